@@ -0,0 +1,104 @@
+// Benchmark approximate convex decomposition of a generated bowl, and loading the decomposition
+// from the disk cache, which is what every load after the first one pays.
+#include "mesh_manager.h"
+#include "simulation.h"
+#include <chrono>
+#include <cmath>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+using namespace sapien;
+namespace fs = std::experimental::filesystem;
+
+constexpr int RINGS = 24;
+constexpr int SEGMENTS = 48;
+
+// closed bowl, a hemispherical shell of thickness 0.1
+void generateBowl(std::vector<PxVec3> &vertices, std::vector<uint32_t> &triangles) {
+  for (int shell = 0; shell < 2; ++shell) {
+    float radius = shell ? 0.9f : 1.f;
+    for (int r = 0; r <= RINGS; ++r) {
+      float theta = M_PI / 2 * (1 + float(r) / RINGS);
+      for (int s = 0; s < SEGMENTS; ++s) {
+        float phi = 2 * M_PI * s / SEGMENTS;
+        vertices.push_back(radius * PxVec3(std::sin(theta) * std::cos(phi),
+                                           std::sin(theta) * std::sin(phi), std::cos(theta)));
+      }
+    }
+  }
+  uint32_t n = (RINGS + 1) * SEGMENTS;
+  for (uint32_t shell = 0; shell < 2; ++shell) {
+    for (uint32_t r = 0; r < RINGS; ++r) {
+      for (uint32_t s = 0; s < SEGMENTS; ++s) {
+        uint32_t a = shell * n + r * SEGMENTS + s;
+        uint32_t b = shell * n + (r + 1) * SEGMENTS + s;
+        uint32_t c = shell * n + (r + 1) * SEGMENTS + (s + 1) % SEGMENTS;
+        uint32_t d = shell * n + r * SEGMENTS + (s + 1) % SEGMENTS;
+        if (shell == 0) {
+          triangles.insert(triangles.end(), {a, b, c, a, c, d});
+        } else {
+          triangles.insert(triangles.end(), {a, c, b, a, d, c});
+        }
+      }
+    }
+  }
+  // rim
+  for (uint32_t s = 0; s < SEGMENTS; ++s) {
+    uint32_t a = s, b = (s + 1) % SEGMENTS;
+    triangles.insert(triangles.end(), {a, b, n + b, a, n + b, n + a});
+  }
+}
+
+double timeit(std::function<void()> const &f) {
+  auto start = std::chrono::high_resolution_clock::now();
+  f();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+  generateBowl(vertices, triangles);
+  std::cout << vertices.size() << " vertices, " << triangles.size() / 3 << " triangles\n";
+
+  ConvexDecompositionParams params;
+  size_t n = 0;
+  double tSerial = timeit([&]() { n = decomposeConvex(vertices, triangles, params).size(); });
+  std::cout << "decompose, 1 thread:    " << tSerial << " ms, " << n << " hulls\n";
+  utils::ThreadPool pool;
+  double tParallel =
+      timeit([&]() { n = decomposeConvex(vertices, triangles, params, &pool).size(); });
+  std::cout << "decompose, all threads: " << tParallel << " ms, " << n << " hulls\n";
+
+  fs::path filename = fs::temp_directory_path() / "sapien_convex_decomposition.obj";
+  fs::path cacheDirectory = fs::temp_directory_path() / "sapien_convex_decomposition_cache";
+  {
+    std::ofstream f(filename);
+    for (auto &v : vertices) {
+      f << "v " << v.x << " " << v.y << " " << v.z << "\n";
+    }
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+      f << "f " << triangles[i] + 1 << " " << triangles[i + 1] + 1 << " " << triangles[i + 2] + 1
+        << "\n";
+    }
+  }
+  fs::remove_all(cacheDirectory);
+
+  Simulation sim;
+  auto &manager = sim.getMeshManager();
+  manager.setCacheDirectory(cacheDirectory.string());
+  double tCold = timeit([&]() { n = manager.loadMeshDecomposition(filename, params).size(); });
+  std::cout << "load decomposition, cold:       " << tCold << " ms, " << n << " hulls\n";
+  manager.evictUnusedMeshes();
+  double tCached = timeit([&]() { n = manager.loadMeshDecomposition(filename, params).size(); });
+  std::cout << "load decomposition, disk cache: " << tCached << " ms, " << n << " hulls\n";
+  double tRegistered = timeit([&]() { manager.loadMeshDecomposition(filename, params); });
+  std::cout << "load decomposition, registered: " << tRegistered << " ms\n";
+
+  fs::remove(filename);
+  fs::remove_all(cacheDirectory);
+  return 0;
+}
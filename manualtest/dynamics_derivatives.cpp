@@ -0,0 +1,122 @@
+// Compare analytical dynamics derivatives of PinocchioModel against central finite differences
+// on serial chains of 7 and 30 revolute joints, for both accuracy and speed.
+#include "articulation/pinocchio_model.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace sapien;
+
+std::string chainURDF(int dof) {
+  std::ostringstream oss;
+  oss << "<robot name=\"chain\">\n";
+  for (int i = 0; i <= dof; ++i) {
+    oss << "<link name=\"link" << i << "\"><inertial><origin xyz=\"0 0 0.1\"/>"
+        << "<mass value=\"1\"/><inertia ixx=\"0.01\" iyy=\"0.01\" izz=\"0.005\" ixy=\"0\" "
+        << "ixz=\"0\" iyz=\"0\"/></inertial></link>\n";
+  }
+  for (int i = 0; i < dof; ++i) {
+    // alternate axes so the chain is not planar
+    char const *axis = i % 3 == 0 ? "0 0 1" : (i % 3 == 1 ? "0 1 0" : "1 0 0");
+    oss << "<joint name=\"joint" << i << "\" type=\"revolute\"><parent link=\"link" << i
+        << "\"/><child link=\"link" << i + 1 << "\"/><origin xyz=\"0 0 0.2\"/><axis xyz=\""
+        << axis << "\"/><limit lower=\"-3\" upper=\"3\" effort=\"100\" velocity=\"1\"/>"
+        << "</joint>\n";
+  }
+  oss << "</robot>\n";
+  return oss.str();
+}
+
+template <typename F> double timeit(int repeat, F &&f) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    f();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / repeat;
+}
+
+void benchmark(int dof) {
+  auto model = PinocchioModel::fromURDFXML(chainURDF(dof), {0, 0, -9.81});
+  std::vector<std::string> joints, links;
+  for (int i = 0; i < dof; ++i) {
+    joints.push_back("joint" + std::to_string(i));
+  }
+  for (int i = 0; i <= dof; ++i) {
+    links.push_back("link" + std::to_string(i));
+  }
+  model->setJointOrder(joints);
+  model->setLinkOrder(links);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> dist(-1, 1);
+  auto random = [&]() { return Eigen::VectorXd::NullaryExpr(dof, [&]() { return dist(gen); }); };
+  Eigen::VectorXd q = random(), v = random(), tau = random(), a = random();
+
+  double h = 1e-6;
+  auto fdForward = [&]() {
+    Eigen::MatrixXd dq(dof, dof), dv(dof, dof);
+    for (int i = 0; i < dof; ++i) {
+      Eigen::VectorXd e = Eigen::VectorXd::Unit(dof, i) * h;
+      dq.col(i) = (model->computeForwardDynamics(q + e, v, tau) -
+                   model->computeForwardDynamics(q - e, v, tau)) /
+                  (2 * h);
+      dv.col(i) = (model->computeForwardDynamics(q, v + e, tau) -
+                   model->computeForwardDynamics(q, v - e, tau)) /
+                  (2 * h);
+    }
+    return std::make_pair(dq, dv);
+  };
+  auto fdInverse = [&]() {
+    Eigen::MatrixXd dq(dof, dof), dv(dof, dof);
+    for (int i = 0; i < dof; ++i) {
+      Eigen::VectorXd e = Eigen::VectorXd::Unit(dof, i) * h;
+      dq.col(i) = (model->computeInverseDynamics(q + e, v, a) -
+                   model->computeInverseDynamics(q - e, v, a)) /
+                  (2 * h);
+      dv.col(i) = (model->computeInverseDynamics(q, v + e, a) -
+                   model->computeInverseDynamics(q, v - e, a)) /
+                  (2 * h);
+    }
+    return std::make_pair(dq, dv);
+  };
+
+  auto [adq, adv, adtau] = model->computeForwardDynamicsDerivatives(q, v, tau);
+  auto [fdq, fdv] = fdForward();
+  auto [idq, idv, ida] = model->computeInverseDynamicsDerivatives(q, v, a);
+  auto [ifdq, ifdv] = fdInverse();
+  printf("%d dof\n", dof);
+  printf("  ABA derivative max error  dq %.3e  dv %.3e  dtau*M-I %.3e\n",
+         (adq - fdq).cwiseAbs().maxCoeff(), (adv - fdv).cwiseAbs().maxCoeff(),
+         (adtau * ida - Eigen::MatrixXd::Identity(dof, dof)).cwiseAbs().maxCoeff());
+  printf("  RNEA derivative max error dq %.3e  dv %.3e\n", (idq - ifdq).cwiseAbs().maxCoeff(),
+         (idv - ifdv).cwiseAbs().maxCoeff());
+
+  int repeat = 2000;
+  double tAnalyticABA =
+      timeit(repeat, [&]() { model->computeForwardDynamicsDerivatives(q, v, tau); });
+  double tFiniteABA = timeit(repeat, fdForward);
+  double tAnalyticRNEA =
+      timeit(repeat, [&]() { model->computeInverseDynamicsDerivatives(q, v, a); });
+  double tFiniteRNEA = timeit(repeat, fdInverse);
+  printf("  ABA  analytical %8.2f us, finite difference %8.2f us, speedup %.1fx\n", tAnalyticABA,
+         tFiniteABA, tFiniteABA / tAnalyticABA);
+  printf("  RNEA analytical %8.2f us, finite difference %8.2f us, speedup %.1fx\n",
+         tAnalyticRNEA, tFiniteRNEA, tFiniteRNEA / tAnalyticRNEA);
+
+  int batch = 1024;
+  PinocchioModel::RowMatrixXd Q = PinocchioModel::RowMatrixXd::Random(batch, dof);
+  PinocchioModel::RowMatrixXd V = PinocchioModel::RowMatrixXd::Random(batch, dof);
+  PinocchioModel::RowMatrixXd T = PinocchioModel::RowMatrixXd::Random(batch, dof);
+  PinocchioModel::RowMatrixXd DQ(batch * dof, dof), DV(batch * dof, dof), DT(batch * dof, dof);
+  double tBatch = timeit(
+      10, [&]() { model->computeForwardDynamicsDerivativesBatch(Q, V, T, DQ, DV, DT); });
+  printf("  ABA  derivatives batch of %d: %.2f us per state\n", batch, tBatch / batch);
+}
+
+int main() {
+  benchmark(7);
+  benchmark(30);
+  return 0;
+}
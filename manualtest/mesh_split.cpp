@@ -0,0 +1,141 @@
+// Benchmark connected component splitting and mesh group loading on a generated mesh made of
+// 40 disjoint UV spheres, about 100k triangles in total.
+#include "mesh_manager.h"
+#include "simulation.h"
+#include <chrono>
+#include <cmath>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+
+using namespace sapien;
+namespace fs = std::experimental::filesystem;
+
+constexpr int N_SPHERES = 40;
+constexpr int RINGS = 32;
+constexpr int SEGMENTS = 40;
+
+// indexed spheres, seam and pole vertices are duplicated as in most exported meshes
+void generateSpheres(std::vector<PxVec3> &vertices, std::vector<uint32_t> &triangles) {
+  for (int k = 0; k < N_SPHERES; ++k) {
+    PxVec3 center(3.f * (k % 8), 3.f * (k / 8), 0.f);
+    uint32_t base = vertices.size();
+    for (int r = 0; r <= RINGS; ++r) {
+      float theta = M_PI * r / RINGS;
+      for (int s = 0; s <= SEGMENTS; ++s) {
+        float phi = 2 * M_PI * (s % SEGMENTS) / SEGMENTS;
+        vertices.push_back(center + PxVec3(std::sin(theta) * std::cos(phi),
+                                           std::sin(theta) * std::sin(phi), std::cos(theta)));
+      }
+    }
+    for (int r = 0; r < RINGS; ++r) {
+      for (int s = 0; s < SEGMENTS; ++s) {
+        uint32_t a = base + r * (SEGMENTS + 1) + s;
+        uint32_t b = a + SEGMENTS + 1;
+        triangles.insert(triangles.end(), {a, b, b + 1, a, b + 1, a + 1});
+      }
+    }
+  }
+}
+
+// the previous implementation: adjacency sets and a depth first search, no welding
+std::vector<std::vector<int>> splitReference(std::vector<PxVec3> const &vertices,
+                                             std::vector<uint32_t> const &triangles) {
+  std::vector<std::set<int>> edges(vertices.size());
+  for (size_t i = 0; i < triangles.size(); i += 3) {
+    edges[triangles[i]].insert({(int)triangles[i + 1], (int)triangles[i + 2]});
+    edges[triangles[i + 1]].insert({(int)triangles[i], (int)triangles[i + 2]});
+    edges[triangles[i + 2]].insert({(int)triangles[i], (int)triangles[i + 1]});
+  }
+  std::vector<int> visited(vertices.size(), 0);
+  std::vector<std::vector<int>> groups;
+  for (size_t v = 0; v < vertices.size(); ++v) {
+    if (visited[v]) {
+      continue;
+    }
+    groups.emplace_back();
+    std::vector<int> stack{(int)v};
+    visited[v] = 1;
+    while (!stack.empty()) {
+      int u = stack.back();
+      stack.pop_back();
+      groups.back().push_back(u);
+      for (int w : edges[u]) {
+        if (!visited[w]) {
+          visited[w] = 1;
+          stack.push_back(w);
+        }
+      }
+    }
+  }
+  return groups;
+}
+
+double timeit(std::function<void()> const &f) {
+  auto start = std::chrono::high_resolution_clock::now();
+  f();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+  generateSpheres(vertices, triangles);
+  std::cout << vertices.size() << " vertices, " << triangles.size() / 3 << " triangles\n";
+
+  // triangle soup, every triangle has its own vertices and only welding connects them
+  std::vector<PxVec3> soup;
+  std::vector<uint32_t> soupTriangles;
+  for (auto i : triangles) {
+    soupTriangles.push_back(soup.size());
+    soup.push_back(vertices[i]);
+  }
+
+  std::vector<std::vector<int>> reference;
+  std::vector<std::vector<uint32_t>> indexed, welded;
+  double tReference = timeit([&]() { reference = splitReference(vertices, triangles); });
+  double tIndexed = timeit([&]() { indexed = splitMeshComponents(vertices, triangles); });
+  double tSoup = timeit([&]() { welded = splitMeshComponents(soup, soupTriangles); });
+  std::cout << "reference split (indexed):  " << tReference << " ms, " << reference.size()
+            << " components\n";
+  std::cout << "union-find split (indexed): " << tIndexed << " ms, " << indexed.size()
+            << " components\n";
+  std::cout << "union-find split (soup):    " << tSoup << " ms, " << welded.size()
+            << " components\n";
+
+  // one copy per run, the second load of a file is served from the group registry
+  std::vector<fs::path> filenames;
+  for (int copy = 0; copy < 2; ++copy) {
+    filenames.push_back(fs::temp_directory_path() /
+                        ("sapien_mesh_split_" + std::to_string(copy) + ".obj"));
+    std::ofstream f(filenames.back());
+    for (auto &v : vertices) {
+      f << "v " << v.x << " " << v.y << " " << v.z << "\n";
+    }
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+      f << "f " << triangles[i] + 1 << " " << triangles[i + 1] + 1 << " " << triangles[i + 2] + 1
+        << "\n";
+    }
+  }
+
+  Simulation sim;
+  auto &manager = sim.getMeshManager();
+  uint32_t threads[] = {1, 0};
+  for (int copy = 0; copy < 2; ++copy) {
+    manager.setNumThreads(threads[copy]);
+    size_t n = 0;
+    double t = timeit([&]() { n = manager.loadMeshGroup(filenames[copy]).size(); });
+    std::cout << "load mesh group, " << (threads[copy] ? "1 thread:    " : "all threads: ") << t
+              << " ms, " << n << " parts\n";
+  }
+  double tRegistered = timeit([&]() { manager.loadMeshGroup(filenames[0]); });
+  std::cout << "load mesh group, registered: " << tRegistered << " ms\n";
+
+  for (auto &filename : filenames) {
+    fs::remove(filename);
+  }
+  return 0;
+}
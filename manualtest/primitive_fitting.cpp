@@ -0,0 +1,143 @@
+// Benchmark stepping a clutter scene of convex mesh objects, with and without replacing the
+// meshes that are close to a box, sphere or capsule by primitives.
+#include "actor_builder.h"
+#include "sapien_actor.h"
+#include "sapien_scene.h"
+#include "simulation.h"
+#include <chrono>
+#include <cmath>
+#include <experimental/filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace sapien;
+namespace fs = std::experimental::filesystem;
+
+constexpr int GRID = 8;
+constexpr int LAYERS = 6;
+constexpr int STEPS = 600;
+constexpr float TOLERANCE = 0.15f;
+
+void writeObj(fs::path const &filename, std::vector<PxVec3> const &vertices,
+              std::vector<uint32_t> const &triangles) {
+  std::ofstream f(filename);
+  for (auto &v : vertices) {
+    f << "v " << v.x << " " << v.y << " " << v.z << "\n";
+  }
+  for (size_t i = 0; i < triangles.size(); i += 3) {
+    f << "f " << triangles[i] + 1 << " " << triangles[i + 1] + 1 << " " << triangles[i + 2] + 1
+      << "\n";
+  }
+}
+
+// surface of revolution around z, radius(t) and z(t) for t in [0, 1] from bottom to top
+template <typename R, typename Z>
+void revolve(R radius, Z height, int rings, int segments, std::vector<PxVec3> &vertices,
+             std::vector<uint32_t> &triangles) {
+  for (int r = 0; r <= rings; ++r) {
+    float t = float(r) / rings;
+    for (int s = 0; s < segments; ++s) {
+      float phi = 2 * M_PI * s / segments;
+      vertices.push_back({radius(t) * std::cos(phi), radius(t) * std::sin(phi), height(t)});
+    }
+  }
+  for (uint32_t r = 0; r < uint32_t(rings); ++r) {
+    for (uint32_t s = 0; s < uint32_t(segments); ++s) {
+      uint32_t a = r * segments + s;
+      uint32_t b = r * segments + (s + 1) % segments;
+      triangles.insert(triangles.end(), {a, b, b + segments, a, b + segments, a + segments});
+    }
+  }
+}
+
+std::vector<fs::path> writeMeshes() {
+  std::vector<fs::path> filenames;
+  auto add = [&](std::string const &name, std::vector<PxVec3> const &vertices,
+                 std::vector<uint32_t> const &triangles) {
+    auto filename = "sapien_primitive_fitting_" + name + ".obj";
+    filenames.push_back(fs::temp_directory_path() / filename);
+    writeObj(filenames.back(), vertices, triangles);
+  };
+
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+  for (int i = 0; i < 8; ++i) {
+    vertices.push_back({i & 1 ? 0.05f : -0.05f, i & 2 ? 0.03f : -0.03f, i & 4 ? 0.02f : -0.02f});
+  }
+  triangles = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+               2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+  add("box", vertices, triangles);
+
+  vertices.clear();
+  triangles.clear();
+  revolve([](float t) { return 0.04f * std::sin(M_PI * t); },
+          [](float t) { return -0.04f * std::cos(M_PI * t); }, 16, 32, vertices, triangles);
+  add("sphere", vertices, triangles);
+
+  // cylinder of half length 0.04 between hemispheres of radius 0.02
+  vertices.clear();
+  triangles.clear();
+  revolve([](float t) { return 0.02f * std::sin(M_PI * t); },
+          [](float t) { return (t < 0.5f ? -0.04f : 0.04f) - 0.02f * std::cos(M_PI * t); }, 17,
+          32, vertices, triangles);
+  add("capsule", vertices, triangles);
+
+  // a cone fits no primitive and stays a convex mesh
+  vertices.clear();
+  triangles.clear();
+  revolve([](float t) { return 0.04f * (1 - t); }, [](float t) { return 0.08f * t - 0.03f; }, 1,
+          32, vertices, triangles);
+  add("cone", vertices, triangles);
+  return filenames;
+}
+
+double run(Simulation &sim, std::vector<fs::path> const &filenames) {
+  auto scene = sim.createScene();
+  scene->setTimestep(1 / 120.f);
+  scene->addGround(0);
+  int count = 0;
+  for (int layer = 0; layer < LAYERS; ++layer) {
+    for (int i = 0; i < GRID; ++i) {
+      for (int j = 0; j < GRID; ++j) {
+        auto builder = scene->createActorBuilder();
+        builder->addConvexShapeFromFile(filenames[count % filenames.size()]);
+        auto actor = builder->build();
+        PxQuat rotation(0.7f * count, PxVec3(1, 2, 3).getNormalized());
+        actor->setPose({{0.12f * i, 0.12f * j, 0.1f + 0.12f * layer}, rotation});
+        count += 1;
+      }
+    }
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < STEPS; ++i) {
+    scene->step();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() / STEPS;
+}
+
+int main() {
+  auto filenames = writeMeshes();
+  Simulation sim;
+  auto &manager = sim.getMeshManager();
+
+  manager.setPrimitiveFitTolerance(0);
+  double tMeshes = run(sim, filenames);
+  manager.setPrimitiveFitTolerance(TOLERANCE);
+  double tPrimitives = run(sim, filenames);
+
+  char const *names[] = {"none", "box", "sphere", "capsule"};
+  for (auto &record : manager.getPrimitiveFitReport()) {
+    std::cout << fs::path(record.shape).filename().string() << ": "
+              << names[record.fit.type] << ", error " << record.fit.error
+              << (record.replaced ? ", replaced\n" : ", kept\n");
+  }
+  std::cout << GRID * GRID * LAYERS << " actors, " << STEPS << " steps\n";
+  std::cout << "convex meshes: " << tMeshes << " ms per step\n";
+  std::cout << "primitives:    " << tPrimitives << " ms per step\n";
+
+  for (auto &filename : filenames) {
+    fs::remove(filename);
+  }
+  return 0;
+}
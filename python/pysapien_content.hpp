@@ -7,20 +7,28 @@
 
 #include "actor_builder.h"
 #include "renderer/render_interface.h"
+#include "kinematic_motion.h"
 #include "sapien_actor.h"
 #include "sapien_actor_base.h"
 #include "sapien_contact.h"
 #include "sapien_drive.h"
+#include "sapien_drive_group.h"
+#include "sapien_height_field.h"
 #include "sapien_scene.h"
 #include "simulation.h"
 
 #include "articulation/articulation_builder.h"
+#include "articulation/collision_checker.h"
+#include "articulation/diff_ik_solver.h"
+#include "articulation/motion_planner.h"
 #include "articulation/sapien_articulation.h"
 #include "articulation/sapien_articulation_base.h"
 #include "articulation/sapien_joint.h"
 #include "articulation/sapien_kinematic_articulation.h"
 #include "articulation/sapien_kinematic_joint.h"
 #include "articulation/sapien_link.h"
+#include "articulation/time_parameterization.h"
+#include "articulation/trajectory_executor.h"
 #include "articulation/urdf_loader.h"
 
 #ifdef _USE_PINOCCHIO
@@ -143,6 +151,10 @@ void buildSapien(py::module &m) {
   auto PyCapsuleGeometry = py::class_<SCapsuleGeometry, SGeometry>(m, "CapsuleGeometry");
   auto PyPlaneGeometry = py::class_<SPlaneGeometry, SGeometry>(m, "PlaneGeometry");
   auto PyConvexMeshGeometry = py::class_<SConvexMeshGeometry, SGeometry>(m, "ConvexMeshGeometry");
+  auto PyNonconvexMeshGeometry =
+      py::class_<SNonconvexMeshGeometry, SGeometry>(m, "NonconvexMeshGeometry");
+  auto PyHeightFieldGeometry =
+      py::class_<SHeightFieldGeometry, SGeometry>(m, "HeightFieldGeometry");
   auto PyShape = py::class_<SShape>(m, "CollisionShape");
 
   // enums
@@ -173,13 +185,26 @@ void buildSapien(py::module &m) {
       py::class_<Renderer::OptifuserCamera, Renderer::ICamera>(m, "OptifuserCamera");
 
   auto PyEngine = py::class_<Simulation>(m, "Engine");
+  auto PyMeshManager = py::class_<MeshManager>(m, "MeshManager");
+  auto PyMeshManagerStats = py::class_<MeshManager::Stats>(m, "MeshManagerStats");
+  auto PyConvexDecompositionParams =
+      py::class_<ConvexDecompositionParams>(m, "ConvexDecompositionParams");
+  auto PyPrimitiveFit = py::class_<PrimitiveFit>(m, "PrimitiveFit");
+  auto PyPrimitiveFitType = py::enum_<PrimitiveFit::Type>(PyPrimitiveFit, "Type");
+  auto PyPrimitiveFitRecord = py::class_<PrimitiveFitRecord>(m, "PrimitiveFitRecord");
   auto PySceneConfig = py::class_<SceneConfig>(m, "SceneConfig");
   auto PyScene = py::class_<SScene>(m, "Scene");
   auto PyDrive = py::class_<SDrive>(m, "Drive");
+  auto PyDriveGroup = py::class_<SDriveGroup>(m, "DriveGroup");
   auto PyActorBase = py::class_<SActorBase>(m, "ActorBase");
   auto PyActorDynamicBase = py::class_<SActorDynamicBase, SActorBase>(m, "ActorDynamicBase");
   auto PyActorStatic = py::class_<SActorStatic, SActorBase>(m, "ActorStatic");
+  auto PyHeightField = py::class_<SHeightField, SActorStatic>(m, "HeightField");
   auto PyActor = py::class_<SActor, SActorDynamicBase>(m, "Actor");
+  auto PyKinematicMotion = py::class_<KinematicMotion>(m, "KinematicMotion");
+  auto PyKinematicMotionInterpolation =
+      py::enum_<KinematicMotion::Interpolation>(PyKinematicMotion, "Interpolation");
+  auto PyKinematicMotionMode = py::enum_<KinematicMotion::Mode>(PyKinematicMotion, "Mode");
   auto PyLinkBase = py::class_<SLinkBase, SActorDynamicBase>(m, "LinkBase");
   auto PyLink = py::class_<SLink, SLinkBase>(m, "Link");
   auto PyKinematicLink = py::class_<SKLink, SLinkBase>(m, "KinematicLink");
@@ -195,6 +220,24 @@ void buildSapien(py::module &m) {
       py::class_<SArticulationDrivable, SArticulationBase>(m, "ArticulationDrivable");
   auto PyArticulation = py::class_<SArticulation, SArticulationDrivable>(m, "Articulation");
   py::class_<SKArticulation, SArticulationDrivable>(m, "KinematicArticulation");
+  auto PyDiffIKSolver = py::class_<DiffIKSolver>(m, "DiffIKSolver");
+  auto PyTrajectoryExecutor = py::class_<TrajectoryExecutor>(m, "TrajectoryExecutor");
+  auto PyTimeParameterization = py::class_<TimeParameterization>(m, "TimeParameterization");
+  auto PyCollisionChecker = py::class_<CollisionChecker>(m, "CollisionChecker");
+  auto PyMotionPlanner = py::class_<MotionPlanner>(m, "MotionPlanner");
+  auto PyArticulationQueryContext =
+      py::class_<ArticulationQueryContext>(m, "ArticulationQueryContext");
+  auto PyTrajectoryInterpolation =
+      py::enum_<TrajectoryExecutor::Interpolation>(PyTrajectoryExecutor, "Interpolation");
+  auto PyArticulationController =
+      py::class_<ArticulationController>(m, "ArticulationController");
+  auto PyJointPDController =
+      py::class_<JointPDController, ArticulationController>(m, "JointPDController");
+  auto PyJointImpedanceController =
+      py::class_<JointImpedanceController, JointPDController>(m, "JointImpedanceController");
+  auto PyOperationalSpaceController =
+      py::class_<OperationalSpaceController, ArticulationController>(
+          m, "OperationalSpaceController");
   auto PyContact = py::class_<SContact>(m, "Contact");
   auto PyContactPoint = py::class_<SContactPoint>(m, "ContactPoint");
 
@@ -221,6 +264,8 @@ void buildSapien(py::module &m) {
 
 #ifdef _USE_PINOCCHIO
   auto PyPinocchioModel = py::class_<PinocchioModel>(m, "PinocchioModel");
+  auto PyPinocchioIntegrator =
+      py::enum_<PinocchioModel::Integrator>(PyPinocchioModel, "Integrator");
 #endif
 
   //======== Internal ========//
@@ -304,6 +349,30 @@ void buildSapien(py::module &m) {
                              })
       .def_property_readonly(
           "indices", [](SConvexMeshGeometry &g) { return make_array<uint32_t>(g.indices); });
+  PyNonconvexMeshGeometry
+      .def_property_readonly("scale",
+                             [](SNonconvexMeshGeometry &g) { return vec32array(g.scale); })
+      .def_property_readonly(
+          "rotation",
+          [](SNonconvexMeshGeometry &g) {
+            return make_array<PxReal>({g.rotation.w, g.rotation.x, g.rotation.y, g.rotation.z});
+          })
+      .def_property_readonly("vertices",
+                             [](SNonconvexMeshGeometry &g) {
+                               int nRows = g.vertices.size() / 3;
+                               int nCols = 3;
+                               return py::array_t<PxReal>({nRows, nCols},
+                                                          {sizeof(PxReal) * nCols, sizeof(PxReal)},
+                                                          g.vertices.data());
+                             })
+      .def_property_readonly(
+          "indices", [](SNonconvexMeshGeometry &g) { return make_array<uint32_t>(g.indices); });
+  PyHeightFieldGeometry.def_readonly("row_scale", &SHeightFieldGeometry::rowScale)
+      .def_readonly("column_scale", &SHeightFieldGeometry::columnScale)
+      .def_property_readonly("heights", [](SHeightFieldGeometry &g) {
+        return py::array_t<PxReal>({g.rows, g.cols}, {sizeof(PxReal) * g.cols, sizeof(PxReal)},
+                                   g.heights.data());
+      });
 
   PyShape.def_readonly("type", &SShape::type)
       .def_readonly("pose", &SShape::pose)
@@ -351,6 +420,24 @@ void buildSapien(py::module &m) {
             }
             return static_cast<SConvexMeshGeometry *>(nullptr);
           },
+          py::return_value_policy::reference)
+      .def_property_readonly(
+          "nonconvex_mesh_geometry",
+          [](SShape &s) {
+            if (s.type == "nonconvex_mesh") {
+              return static_cast<SNonconvexMeshGeometry *>(s.geometry.get());
+            }
+            return static_cast<SNonconvexMeshGeometry *>(nullptr);
+          },
+          py::return_value_policy::reference)
+      .def_property_readonly(
+          "height_field_geometry",
+          [](SShape &s) {
+            if (s.type == "height_field") {
+              return static_cast<SHeightFieldGeometry *>(s.geometry.get());
+            }
+            return static_cast<SHeightFieldGeometry *>(nullptr);
+          },
           py::return_value_policy::reference);
 
   //======== Render Interface ========//
@@ -545,7 +632,72 @@ void buildSapien(py::module &m) {
            py::arg("static_friction"), py::arg("dynamic_friction"), py::arg("restitution"),
            py::return_value_policy::reference)
       .def("set_log_level", &Simulation::setLogLevel, py::arg("level"))
-      .def("create_scene", &Simulation::createScene, py::arg("config") = SceneConfig());
+      .def("create_scene", &Simulation::createScene, py::arg("config") = SceneConfig())
+      .def("get_mesh_manager", &Simulation::getMeshManager, py::return_value_policy::reference);
+
+  PyMeshManager
+      .def_property("cache_directory", &MeshManager::getCacheDirectory,
+                    &MeshManager::setCacheDirectory)
+      .def("get_cached_filename", &MeshManager::getCachedFilename, py::arg("filename"))
+      .def_property("num_threads", &MeshManager::getNumThreads, &MeshManager::setNumThreads)
+      .def("wait_for_pending_loads", &MeshManager::waitForPendingLoads,
+           py::call_guard<py::gil_scoped_release>())
+      .def_property("memory_budget", &MeshManager::getMemoryBudget,
+                    &MeshManager::setMemoryBudget)
+      .def("evict_unused_meshes", &MeshManager::evictUnusedMeshes)
+      .def("get_stats", &MeshManager::getStats)
+      .def(
+          "load_mesh_decomposition",
+          [](MeshManager &manager, std::string const &filename,
+             ConvexDecompositionParams const &params) {
+            return manager.loadMeshDecomposition(filename, params).size();
+          },
+          "Decompose a mesh file and fill the cache, returns the number of hulls",
+          py::arg("filename"), py::arg("params") = ConvexDecompositionParams(),
+          py::call_guard<py::gil_scoped_release>())
+      .def_property("primitive_fit_tolerance", &MeshManager::getPrimitiveFitTolerance,
+                    &MeshManager::setPrimitiveFitTolerance)
+      .def("get_primitive_fit_report", &MeshManager::getPrimitiveFitReport)
+      .def("clear_primitive_fit_report", &MeshManager::clearPrimitiveFitReport);
+
+  PyPrimitiveFitType.value("NONE", PrimitiveFit::None)
+      .value("BOX", PrimitiveFit::Box)
+      .value("SPHERE", PrimitiveFit::Sphere)
+      .value("CAPSULE", PrimitiveFit::Capsule)
+      .export_values();
+  PyPrimitiveFit.def_readonly("type", &PrimitiveFit::type)
+      .def_readonly("pose", &PrimitiveFit::pose)
+      .def_property_readonly("half_extents",
+                             [](PrimitiveFit &f) { return vec32array(f.halfExtents); })
+      .def_readonly("radius", &PrimitiveFit::radius)
+      .def_readonly("half_length", &PrimitiveFit::halfLength)
+      .def_readonly("error", &PrimitiveFit::error);
+  PyPrimitiveFitRecord.def_readonly("shape", &PrimitiveFitRecord::shape)
+      .def_property_readonly("scale",
+                             [](PrimitiveFitRecord &r) { return vec32array(r.scale); })
+      .def_readonly("fit", &PrimitiveFitRecord::fit)
+      .def_readonly("replaced", &PrimitiveFitRecord::replaced);
+
+  PyMeshManagerStats
+      .def_readonly("resident_meshes", &MeshManager::Stats::residentMeshes)
+      .def_readonly("resident_bytes", &MeshManager::Stats::residentBytes)
+      .def_readonly("unused_meshes", &MeshManager::Stats::unusedMeshes)
+      .def_readonly("unused_bytes", &MeshManager::Stats::unusedBytes)
+      .def_readonly("evicted_meshes", &MeshManager::Stats::evictedMeshes)
+      .def("__repr__", [](MeshManager::Stats const &s) {
+        std::ostringstream oss;
+        oss << "MeshManagerStats(resident_meshes=" << s.residentMeshes
+            << ", resident_bytes=" << s.residentBytes << ", unused_meshes=" << s.unusedMeshes
+            << ", unused_bytes=" << s.unusedBytes << ", evicted_meshes=" << s.evictedMeshes
+            << ")";
+        return oss.str();
+      });
+
+  PyConvexDecompositionParams.def(py::init<>())
+      .def_readwrite("resolution", &ConvexDecompositionParams::resolution)
+      .def_readwrite("max_hulls", &ConvexDecompositionParams::maxHulls)
+      .def_readwrite("concavity", &ConvexDecompositionParams::concavity)
+      .def_readwrite("plane_downsampling", &ConvexDecompositionParams::planeDownsampling);
 
   PySceneConfig.def(py::init<>())
       .def_readwrite("gravity", &SceneConfig::gravity)
@@ -628,6 +780,9 @@ void buildSapien(py::module &m) {
       // drive, constrains, and joints
       .def("create_drive", &SScene::createDrive, py::arg("actor1"), py::arg("pose1"),
            py::arg("actor2"), py::arg("pose2"), py::return_value_policy::reference)
+      .def("create_drive_group", &SScene::createDriveGroup,
+           py::arg("drives") = std::vector<SDrive *>(), py::return_value_policy::reference)
+      .def("remove_drive_group", &SScene::removeDriveGroup, py::arg("group"))
       .def_property_readonly("render_id_to_visual_name", &SScene::findRenderId2VisualName);
 
   //======= Drive =======//
@@ -651,6 +806,22 @@ void buildSapien(py::module &m) {
           py::arg("linear"), py::arg("angular"))
       .def("destroy", &SDrive::destroy);
 
+  PyDriveGroup
+      .def("add_drive", &SDriveGroup::addDrive, py::arg("drive"))
+      .def("remove_drive", &SDriveGroup::removeDrive, py::arg("drive"))
+      .def("get_drives", &SDriveGroup::getDrives, py::return_value_policy::reference)
+      .def("__len__", &SDriveGroup::size)
+      .def("set_properties", &SDriveGroup::setProperties, py::arg("stiffness"),
+           py::arg("damping"), py::arg("force_limit") = PX_MAX_F32,
+           py::arg("is_acceleration") = true)
+      .def("set_targets", &SDriveGroup::setTargets, py::arg("targets"),
+           py::arg("interpolation_steps") = 0)
+      .def("get_targets", &SDriveGroup::getTargets)
+      .def("set_target_velocities", &SDriveGroup::setTargetVelocities, py::arg("velocities"))
+      .def("get_target_velocities", &SDriveGroup::getTargetVelocities)
+      .def("is_interpolating", &SDriveGroup::isInterpolating)
+      .def("destroy", &SDriveGroup::destroy);
+
   //======== Actor ========//
 
   PyActorType.value("STATIC", EActorType::STATIC)
@@ -724,6 +895,26 @@ void buildSapien(py::module &m) {
         a.unpackData(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
       });
 
+  // heights accept any numeric array, e.g. an 8 or 16 bit height map image, scaled by
+  // height_scale
+  PyHeightField.attr("HOLE") = SHeightField::HOLE;
+  PyHeightField
+      .def(
+          "set_heights",
+          [](SHeightField &h, SHeightField::Heights const &heights,
+             SHeightField::MaterialIndices const &materialIndices, PxReal heightScale) {
+            return h.setHeights(heights * heightScale, materialIndices);
+          },
+          py::arg("heights"), py::arg("material_indices") = SHeightField::MaterialIndices(),
+          py::arg("height_scale") = 1.f)
+      .def("get_heights", &SHeightField::getHeights)
+      .def("get_material_indices", &SHeightField::getMaterialIndices)
+      .def("get_materials", &SHeightField::getMaterials, py::return_value_policy::reference)
+      .def("get_height_at", &SHeightField::getHeightAt, py::arg("x"), py::arg("y"))
+      .def_property_readonly("cell_size", &SHeightField::getCellSize)
+      .def_property_readonly("rows", &SHeightField::getRows)
+      .def_property_readonly("cols", &SHeightField::getCols);
+
   PyActor.def("set_pose", &SActor::setPose, py::arg("pose"))
       .def("set_velocity", [](SActor &a, py::array_t<PxReal> v) { a.setVelocity(array2vec3(v)); })
       .def("set_angular_velocity",
@@ -736,7 +927,39 @@ void buildSapien(py::module &m) {
              a.unpackData(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
            })
       .def("set_solver_iterations", &SActor::setSolverIterations, py::arg("position"),
-           py::arg("velocity") = 1);
+           py::arg("velocity") = 1)
+      .def("create_kinematic_motion", &SActor::createKinematicMotion,
+           py::return_value_policy::reference)
+      .def("get_kinematic_motion", &SActor::getKinematicMotion,
+           py::return_value_policy::reference)
+      .def("remove_kinematic_motion", &SActor::removeKinematicMotion);
+
+  PyKinematicMotionInterpolation.value("LINEAR", KinematicMotion::Linear)
+      .value("SPLINE", KinematicMotion::Spline)
+      .export_values();
+  PyKinematicMotionMode.value("ONCE", KinematicMotion::Once)
+      .value("LOOP", KinematicMotion::Loop)
+      .value("PINGPONG", KinematicMotion::PingPong)
+      .export_values();
+
+  PyKinematicMotion
+      .def("set_keyframes", &KinematicMotion::setKeyframes, py::arg("times"), py::arg("poses"),
+           py::arg("interpolation") = KinematicMotion::Linear)
+      .def(
+          "set_constant_velocity",
+          [](KinematicMotion &m, PxTransform const &origin, py::array_t<PxReal> const &linear,
+             py::array_t<PxReal> const &angular) {
+            m.setConstantVelocity(origin, array2vec3(linear), array2vec3(angular));
+          },
+          py::arg("origin"), py::arg("linear"), py::arg("angular"))
+      .def_property("mode", &KinematicMotion::getMode, &KinematicMotion::setMode)
+      .def("start", &KinematicMotion::start)
+      .def("stop", &KinematicMotion::stop)
+      .def("is_running", &KinematicMotion::isRunning)
+      .def("is_finished", &KinematicMotion::isFinished)
+      .def_property("time", &KinematicMotion::getTime, &KinematicMotion::setTime)
+      .def_property_readonly("duration", &KinematicMotion::getDuration)
+      .def("evaluate", &KinematicMotion::evaluate, py::arg("t"));
 
   PyLinkBase.def("get_index", &SLinkBase::getIndex)
       .def("get_articulation", &SLinkBase::getArticulation, py::return_value_policy::reference);
@@ -795,6 +1018,8 @@ void buildSapien(py::module &m) {
       .def_property_readonly("stiffness", &SJoint::getDriveStiffness)
       .def_property_readonly("damping", &SJoint::getDriveDamping)
       .def_property_readonly("force_limit", &SJoint::getDriveForceLimit)
+      .def("get_velocity_limit", &SJoint::getVelocityLimit)
+      .def("set_velocity_limit", &SJoint::setVelocityLimit, py::arg("limit"))
       .def(
           "set_drive_velocity_target", [](SJoint &j, PxReal v) { j.setDriveVelocityTarget(v); },
           py::arg("velocity"))
@@ -909,7 +1134,18 @@ void buildSapien(py::module &m) {
           [](SArticulationDrivable &a, const py::array_t<PxReal> &arr) {
             a.setDriveTarget(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
           },
-          py::arg("drive_target"));
+          py::arg("drive_target"))
+      .def("get_drive_velocity_target",
+           [](SArticulationDrivable &a) {
+             auto target = a.getDriveVelocityTarget();
+             return py::array_t<PxReal>(target.size(), target.data());
+           })
+      .def(
+          "set_drive_velocity_target",
+          [](SArticulationDrivable &a, const py::array_t<PxReal> &arr) {
+            a.setDriveVelocityTarget(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
+          },
+          py::arg("drive_velocity_target"));
 
   PyArticulation.def("get_links", &SArticulation::getSLinks, py::return_value_policy::reference)
       .def("get_joints", &SArticulation::getSJoints, py::return_value_policy::reference)
@@ -931,6 +1167,22 @@ void buildSapien(py::module &m) {
           },
           py::arg("gravity") = true, py::arg("coriolis_and_centrifugal") = true,
           py::arg("external") = true)
+      .def("set_passive_force_compensation", &SArticulation::setPassiveForceCompensation,
+           py::arg("gravity") = true, py::arg("coriolis_and_centrifugal") = true,
+           py::arg("external") = true)
+      .def("get_passive_force_compensation", &SArticulation::getPassiveForceCompensation)
+      .def("set_held_qf", &SArticulation::setHeldQf, py::arg("qf"))
+      .def("get_held_qf", &SArticulation::getHeldQf)
+      .def("create_joint_pd_controller", &SArticulation::createJointPDController,
+           py::arg("stiffness"), py::arg("damping"), py::return_value_policy::reference)
+      .def("create_joint_impedance_controller", &SArticulation::createJointImpedanceController,
+           py::arg("stiffness"), py::arg("damping"), py::return_value_policy::reference)
+      .def("create_operational_space_controller",
+           &SArticulation::createOperationalSpaceController, py::arg("link_id"),
+           py::arg("stiffness"), py::arg("damping"), py::return_value_policy::reference)
+      .def("remove_controller", &SArticulation::removeController, py::arg("controller"))
+      .def("get_controllers", &SArticulation::getControllers, py::return_value_policy::reference)
+      .def("create_query_context", &SArticulation::createQueryContext, py::keep_alive<0, 1>())
       .def("compute_inverse_dynamics",
            [](SArticulation &a, const py::array_t<PxReal> &arr) {
              assert(arr.size() == a.dof());
@@ -955,15 +1207,179 @@ void buildSapien(py::module &m) {
            py::overload_cast<uint32_t, uint32_t>(&SArticulation::computeAdjointMatrix),
            py::arg("source_link_ik"), py::arg("target_link_id"))
       .def("compute_twist_diff_ik", &SArticulation::computeTwistDiffIK, py::arg("spatial_twist"),
-           py::arg("commanded_link_id"), py::arg("active_joint_ids") = std::vector<uint32_t>())
+           py::arg("commanded_link_id"), py::arg("active_joint_ids") = std::vector<uint32_t>(),
+           py::arg("damping") = 0.f)
       .def("compute_cartesian_diff_ik", &SArticulation::computeCartesianVelocityDiffIK,
            py::arg("world_velocity"), py::arg("commanded_link_id"),
-           py::arg("active_joint_ids") = std::vector<uint32_t>())
+           py::arg("active_joint_ids") = std::vector<uint32_t>(), py::arg("damping") = 0.f)
       .def("pack", &SArticulation::packData)
       .def("unpack", [](SArticulation &a, const py::array_t<PxReal> &arr) {
         a.unpackData(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
       });
 
+  PyArticulationController.def_property_readonly("dof", &ArticulationController::dof)
+      .def_property("enabled", &ArticulationController::isEnabled,
+                    &ArticulationController::setEnabled)
+      .def("set_force_limit", &ArticulationController::setForceLimit, py::arg("limit"))
+      .def("get_force_limit", &ArticulationController::getForceLimit);
+
+  PyJointPDController
+      .def("set_gains", &JointPDController::setGains, py::arg("stiffness"), py::arg("damping"))
+      .def("get_stiffness", &JointPDController::getStiffness)
+      .def("get_damping", &JointPDController::getDamping)
+      .def("set_target", &JointPDController::setTarget, py::arg("qpos"))
+      .def("set_target_velocity", &JointPDController::setTargetVelocity, py::arg("qvel"))
+      .def("get_target", &JointPDController::getTarget)
+      .def("get_target_velocity", &JointPDController::getTargetVelocity);
+
+  PyJointImpedanceController
+      .def("set_feedforward", &JointImpedanceController::setFeedforward, py::arg("qf"))
+      .def("get_feedforward", &JointImpedanceController::getFeedforward);
+
+  PyOperationalSpaceController
+      .def_property_readonly("link_id", &OperationalSpaceController::getLinkId)
+      .def("set_gains", &OperationalSpaceController::setGains, py::arg("stiffness"),
+           py::arg("damping"))
+      .def("get_stiffness", &OperationalSpaceController::getStiffness)
+      .def("get_damping", &OperationalSpaceController::getDamping)
+      .def("set_target", &OperationalSpaceController::setTarget, py::arg("pose"))
+      .def("get_target", &OperationalSpaceController::getTarget)
+      .def("set_target_velocity", &OperationalSpaceController::setTargetVelocity,
+           py::arg("velocity"))
+      .def("get_target_velocity", &OperationalSpaceController::getTargetVelocity)
+      .def("set_target_wrench", &OperationalSpaceController::setTargetWrench, py::arg("wrench"))
+      .def("get_target_wrench", &OperationalSpaceController::getTargetWrench)
+      .def_property("singularity_damping", &OperationalSpaceController::getSingularityDamping,
+                    &OperationalSpaceController::setSingularityDamping)
+      .def("set_nullspace_gains", &OperationalSpaceController::setNullspaceGains,
+           py::arg("stiffness"), py::arg("damping"))
+      .def("set_nullspace_target", &OperationalSpaceController::setNullspaceTarget,
+           py::arg("qpos"))
+      .def("get_nullspace_target", &OperationalSpaceController::getNullspaceTarget);
+
+  PyDiffIKSolver
+      .def(py::init<SArticulation *, std::vector<uint32_t> const &, bool>(),
+           py::arg("articulation"), py::arg("commanded_link_ids"),
+           py::arg("spatial_twist") = true, py::keep_alive<1, 2>())
+      .def_property("damping", &DiffIKSolver::getDamping, &DiffIKSolver::setDamping)
+      .def_property("joint_limit_avoidance", &DiffIKSolver::getJointLimitAvoidance,
+                    &DiffIKSolver::setJointLimitAvoidance)
+      .def("update_joint_limits", &DiffIKSolver::updateJointLimits)
+      .def("get_commanded_link_ids", &DiffIKSolver::getLinkIds)
+      .def("solve", py::overload_cast<Eigen::VectorXf const &>(&DiffIKSolver::solve),
+           py::arg("target"))
+      .def_static(
+          "solve_batch",
+          [](std::vector<DiffIKSolver *> const &solvers,
+             std::vector<Eigen::VectorXf> const &targets) {
+            // shared by all batches, solveBatch never runs inside one of its tasks
+            static utils::ThreadPool pool;
+            std::vector<Eigen::VectorXf> qvels;
+            {
+              py::gil_scoped_release release;
+              DiffIKSolver::solveBatch(solvers, targets, qvels, &pool);
+            }
+            return qvels;
+          },
+          py::arg("solvers"), py::arg("targets"));
+
+  // queries release the GIL so that Python threads can run them concurrently
+  PyArticulationQueryContext.def_property_readonly("dof", &ArticulationQueryContext::dof)
+      .def("get_qpos", &ArticulationQueryContext::getQpos,
+           py::call_guard<py::gil_scoped_release>())
+      .def("get_qvel", &ArticulationQueryContext::getQvel,
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_passive_force", &ArticulationQueryContext::computePassiveForce,
+           py::arg("gravity") = true, py::arg("coriolis_and_centrifugal") = true,
+           py::arg("external") = true, py::call_guard<py::gil_scoped_release>())
+      .def("compute_inverse_dynamics", &ArticulationQueryContext::computeInverseDynamics,
+           py::arg("qacc"), py::call_guard<py::gil_scoped_release>())
+      .def("compute_forward_dynamics", &ArticulationQueryContext::computeForwardDynamics,
+           py::arg("qf"), py::call_guard<py::gil_scoped_release>())
+      .def("compute_manipulator_inertia_matrix",
+           py::overload_cast<>(&ArticulationQueryContext::computeManipulatorInertiaMatrix),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_link_jacobian", &ArticulationQueryContext::computeLinkJacobian,
+           py::arg("link_id"), py::arg("spatial_twist") = true,
+           py::call_guard<py::gil_scoped_release>());
+
+  PyCollisionChecker
+      .def(py::init<SArticulation *, uint32_t>(), py::arg("articulation"),
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def("update_scene", &CollisionChecker::updateScene)
+      .def("ignore_link_pair", &CollisionChecker::ignoreLinkPair, py::arg("link1"),
+           py::arg("link2"))
+      .def("is_colliding", &CollisionChecker::isColliding, py::arg("qpos"),
+           py::arg("self_collision") = true, py::arg("scene_collision") = true)
+      .def("get_collisions", &CollisionChecker::getCollisions, py::arg("qpos"),
+           py::arg("self_collision") = true, py::arg("scene_collision") = true,
+           py::return_value_policy::reference)
+      .def("check_batch", &CollisionChecker::checkBatch, py::arg("qpos"),
+           py::arg("self_collision") = true, py::arg("scene_collision") = true,
+           py::call_guard<py::gil_scoped_release>());
+
+  PyMotionPlanner
+      .def(py::init<SArticulation *>(), py::arg("articulation"), py::keep_alive<1, 2>())
+      .def("get_collision_checker", &MotionPlanner::getCollisionChecker,
+           py::return_value_policy::reference_internal)
+      .def_property("range", &MotionPlanner::getRange, &MotionPlanner::setRange)
+      .def_property("resolution", &MotionPlanner::getResolution, &MotionPlanner::setResolution)
+      .def("set_random_seed", &MotionPlanner::setRandomSeed, py::arg("seed"))
+      .def("update_joint_limits", &MotionPlanner::updateJointLimits)
+      .def("is_valid", &MotionPlanner::isValid, py::arg("qpos"))
+      .def("plan", &MotionPlanner::plan, py::arg("start"), py::arg("goal"),
+           py::arg("time_limit") = 1.f, py::arg("max_iterations") = 10000,
+           py::arg("shortcut_iterations") = 100, py::call_guard<py::gil_scoped_release>());
+
+  PyTrajectoryInterpolation.value("CUBIC", TrajectoryExecutor::Cubic)
+      .value("QUINTIC", TrajectoryExecutor::Quintic)
+      .export_values();
+
+  PyTrajectoryExecutor
+      .def(py::init<SArticulationDrivable *>(), py::arg("articulation"), py::keep_alive<1, 2>())
+      .def("set_trajectory", &TrajectoryExecutor::setTrajectory, py::arg("times"),
+           py::arg("positions"), py::arg("velocities") = Eigen::MatrixXf(),
+           py::arg("accelerations") = Eigen::MatrixXf(),
+           py::arg("interpolation") = TrajectoryExecutor::Cubic)
+      .def("start", &TrajectoryExecutor::start)
+      .def("stop", &TrajectoryExecutor::stop)
+      .def("is_running", &TrajectoryExecutor::isRunning)
+      .def("is_finished", &TrajectoryExecutor::isFinished)
+      .def_property("time", &TrajectoryExecutor::getTime, &TrajectoryExecutor::setTime)
+      .def_property_readonly("duration", &TrajectoryExecutor::getDuration)
+      .def(
+          "evaluate",
+          [](TrajectoryExecutor &e, PxReal t) {
+            std::vector<PxReal> pos, vel;
+            e.evaluate(t, pos, vel);
+            return py::make_tuple(make_array(pos), make_array(vel));
+          },
+          py::arg("t"));
+
+  PyTimeParameterization
+      .def(py::init<std::vector<PxReal> const &, std::vector<PxReal> const &>(),
+           py::arg("velocity_limits"), py::arg("acceleration_limits"))
+      .def_static("from_articulation", &TimeParameterization::fromArticulation,
+                  py::arg("articulation"), py::arg("acceleration_limits"))
+      .def_property_readonly("velocity_limits", &TimeParameterization::getVelocityLimits)
+      .def_property_readonly("acceleration_limits", &TimeParameterization::getAccelerationLimits)
+      .def(
+          "compute",
+          [](TimeParameterization &tp, Eigen::MatrixXf const &path, uint32_t gridPoints) {
+            TimeParameterization::Result result;
+            bool success;
+            {
+              py::gil_scoped_release release;
+              success = tp.compute(path, result, gridPoints);
+            }
+            if (!success) {
+              return py::object(py::none());
+            }
+            return py::object(py::make_tuple(result.times, result.positions, result.velocities,
+                                             result.accelerations));
+          },
+          py::arg("path"), py::arg("grid_points_per_segment") = 10);
+
   //======== End Articulation ========//
 
   PyContact
@@ -1029,6 +1445,29 @@ void buildSapien(py::module &m) {
           py::arg("scale") = make_array<PxReal>({1, 1, 1}), py::arg("material") = nullptr,
           py::arg("density") = 1000, py::arg("patch_radius") = 0.f,
           py::arg("min_patch_radius") = 0.f)
+      .def(
+          "add_decomposed_convex_shapes_from_file",
+          [](ActorBuilder &a, std::string const &filename, PxTransform const &pose,
+             py::array_t<PxReal> const &scale, PxMaterial *material, PxReal density,
+             PxReal patchRadius, PxReal minPatchRadius, ConvexDecompositionParams const &params) {
+            a.addDecomposedConvexShapesFromFile(filename, pose, array2vec3(scale), material,
+                                                density, patchRadius, minPatchRadius, params);
+          },
+          py::arg("filename"), py::arg("pose") = PxTransform(PxIdentity),
+          py::arg("scale") = make_array<PxReal>({1, 1, 1}), py::arg("material") = nullptr,
+          py::arg("density") = 1000, py::arg("patch_radius") = 0.f,
+          py::arg("min_patch_radius") = 0.f, py::arg("params") = ConvexDecompositionParams())
+      .def(
+          "add_nonconvex_shape_from_file",
+          [](ActorBuilder &a, std::string const &filename, PxTransform const &pose,
+             py::array_t<PxReal> const &scale, PxMaterial *material, PxReal patchRadius,
+             PxReal minPatchRadius) {
+            a.addNonConvexShapeFromFile(filename, pose, array2vec3(scale), material, patchRadius,
+                                        minPatchRadius);
+          },
+          py::arg("filename"), py::arg("pose") = PxTransform(PxIdentity),
+          py::arg("scale") = make_array<PxReal>({1, 1, 1}), py::arg("material") = nullptr,
+          py::arg("patch_radius") = 0.f, py::arg("min_patch_radius") = 0.f)
       .def(
           "add_box_shape",
           [](ActorBuilder &a, PxTransform const &pose, py::array_t<PxReal> const &size,
@@ -1126,7 +1565,23 @@ void buildSapien(py::module &m) {
       .def("build", &ActorBuilder::build, py::arg("is_kinematic") = false, py::arg("name") = "",
            py::return_value_policy::reference)
       .def("build_static", &ActorBuilder::buildStatic, py::return_value_policy::reference,
-           py::arg("name") = "");
+           py::arg("name") = "")
+      .def("prefetch_meshes", &ActorBuilder::prefetchMeshes)
+      .def(
+          "build_height_field",
+          [](ActorBuilder &a, SHeightField::Heights const &heights, PxReal cellSize,
+             std::vector<PxMaterial *> const &materials,
+             SHeightField::MaterialIndices const &materialIndices, PxReal heightScale,
+             bool render, Renderer::PxrMaterial const &renderMaterial, std::string const &name) {
+            return a.buildHeightField(heights * heightScale, cellSize, materials, materialIndices,
+                                      render, renderMaterial, name);
+          },
+          py::arg("heights"), py::arg("cell_size"),
+          py::arg("materials") = std::vector<PxMaterial *>(),
+          py::arg("material_indices") = SHeightField::MaterialIndices(),
+          py::arg("height_scale") = 1.f, py::arg("render") = true,
+          py::arg("render_material") = Renderer::PxrMaterial(), py::arg("name") = "",
+          py::return_value_policy::reference);
 
   PyShapeRecord.def_readonly("filename", &ActorBuilder::ShapeRecord::filename)
       .def_property_readonly("density",
@@ -1136,6 +1591,10 @@ void buildSapien(py::module &m) {
                                  return "Mesh";
                                case sapien::ActorBuilder::ShapeRecord::MultipleMeshes:
                                  return "Meshes";
+                               case sapien::ActorBuilder::ShapeRecord::NonConvexMesh:
+                                 return "NonConvexMesh";
+                               case sapien::ActorBuilder::ShapeRecord::DecomposedMesh:
+                                 return "DecomposedMesh";
                                case sapien::ActorBuilder::ShapeRecord::Box:
                                  return "Box";
                                case sapien::ActorBuilder::ShapeRecord::Capsule:
@@ -1183,6 +1642,7 @@ void buildSapien(py::module &m) {
       .def("get_name", &LinkBuilder::getName)
       .def("set_name", &LinkBuilder::setName)
       .def("set_joint_name", &LinkBuilder::setJointName)
+      .def("set_joint_velocity_limit", &LinkBuilder::setJointVelocityLimit, py::arg("limit"))
       .def(
           "set_joint_properties",
           [](LinkBuilder &b, PxArticulationJointType::Enum jointType,
@@ -1252,6 +1712,10 @@ void buildSapien(py::module &m) {
   PyURDFLoader.def(py::init<SScene *>(), py::arg("scene"))
       .def_readwrite("fix_root_link", &URDF::URDFLoader::fixRootLink)
       .def_readwrite("load_multiple_shapes_from_file", &URDF::URDFLoader::multipleMeshesInOneFile)
+      .def_readwrite("load_nonconvex_kinematic_collision",
+                     &URDF::URDFLoader::nonConvexKinematicCollision)
+      .def_readwrite("decompose_collision", &URDF::URDFLoader::decomposeCollision)
+      .def_readwrite("decomposition_params", &URDF::URDFLoader::decompositionParams)
       .def_readwrite("collision_is_visual", &URDF::URDFLoader::collisionIsVisual)
       .def_readwrite("scale", &URDF::URDFLoader::scale)
       .def_property(
@@ -1295,12 +1759,26 @@ void buildSapien(py::module &m) {
 
 #ifdef _USE_PINOCCHIO
   PyPinocchioModel
+      .def("clone", &PinocchioModel::clone)
       .def("compute_forward_kinematics", &PinocchioModel::computeForwardKinematics,
            py::arg("qpos"))
       .def("get_link_pose", &PinocchioModel::getLinkPose, py::arg("link_index"))
       .def("compute_inverse_kinematics", &PinocchioModel::computeInverseKinematics,
            py::arg("link_index"), py::arg("pose"), py::arg("eps") = 1e-4,
            py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6)
+      .def("compute_inverse_kinematics_multi_start",
+           &PinocchioModel::computeInverseKinematicsMultiStart, py::arg("link_index"),
+           py::arg("pose"), py::arg("initial_qpos") = PinocchioModel::RowMatrixXd(),
+           py::arg("num_random_starts") = 8, py::arg("eps") = 1e-4,
+           py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6,
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_inverse_kinematics_batch", &PinocchioModel::computeInverseKinematicsBatch,
+           py::arg("link_index"), py::arg("poses"),
+           py::arg("initial_qpos") = PinocchioModel::RowMatrixXd(),
+           py::arg("num_random_starts") = 8, py::arg("eps") = 1e-4,
+           py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_random_seed", &PinocchioModel::setRandomSeed, py::arg("seed"))
       .def("compute_forward_dynamics", &PinocchioModel::computeForwardDynamics, py::arg("qpos"),
            py::arg("qvel"), py::arg("qf"))
       .def("compute_inverse_dynamics", &PinocchioModel::computeForwardDynamics, py::arg("qpos"),
@@ -1309,12 +1787,52 @@ void buildSapien(py::module &m) {
            py::arg("qpos"))
       .def("compute_coriolis_matrix", &PinocchioModel::computeCoriolisMatrix, py::arg("qpos"),
            py::arg("qvel"))
+      .def("compute_inverse_dynamics_derivatives",
+           &PinocchioModel::computeInverseDynamicsDerivatives, py::arg("qpos"), py::arg("qvel"),
+           py::arg("qacc"))
+      .def("compute_forward_dynamics_derivatives",
+           &PinocchioModel::computeForwardDynamicsDerivatives, py::arg("qpos"), py::arg("qvel"),
+           py::arg("qf"))
+      .def("compute_link_velocity_derivatives", &PinocchioModel::computeLinkVelocityDerivatives,
+           py::arg("link_index"), py::arg("qpos"), py::arg("qvel"), py::arg("local") = false)
 
       .def("compute_full_jacobian", &PinocchioModel::computeFullJacobian, py::arg("qpos"))
       .def("get_link_jacobian", &PinocchioModel::getLinkJacobian, py::arg("link_index"),
            py::arg("local") = false)
       .def("compute_single_link_local_jacobian", &PinocchioModel::computeSingleLinkLocalJacobian,
-           py::arg("qpos"), py::arg("link_index"));
+           py::arg("qpos"), py::arg("link_index"))
+
+      .def_property("num_threads", &PinocchioModel::getNumThreads,
+                    &PinocchioModel::setNumThreads)
+      .def("compute_forward_kinematics_batch", &PinocchioModel::computeForwardKinematicsBatch,
+           py::arg("qpos"), py::arg("poses").noconvert(),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_full_jacobian_batch", &PinocchioModel::computeFullJacobianBatch,
+           py::arg("qpos"), py::arg("jacobians").noconvert(), py::arg("local") = false,
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_inverse_dynamics_derivatives_batch",
+           &PinocchioModel::computeInverseDynamicsDerivativesBatch, py::arg("qpos"),
+           py::arg("qvel"), py::arg("qacc"), py::arg("dqpos").noconvert(),
+           py::arg("dqvel").noconvert(), py::arg("dqacc").noconvert(),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_forward_dynamics_derivatives_batch",
+           &PinocchioModel::computeForwardDynamicsDerivativesBatch, py::arg("qpos"),
+           py::arg("qvel"), py::arg("qf"), py::arg("dqpos").noconvert(),
+           py::arg("dqvel").noconvert(), py::arg("dqf").noconvert(),
+           py::call_guard<py::gil_scoped_release>())
+      .def("rollout_dynamics", &PinocchioModel::rolloutDynamics, py::arg("qpos"),
+           py::arg("qvel"), py::arg("torques"), py::arg("timestep"),
+           py::arg("integrator"), py::arg("qpos_out").noconvert(),
+           py::arg("qvel_out").noconvert(), py::call_guard<py::gil_scoped_release>())
+      .def("rollout_dynamics_pd", &PinocchioModel::rolloutDynamicsPD, py::arg("qpos"),
+           py::arg("qvel"), py::arg("targets"), py::arg("stiffness"), py::arg("damping"),
+           py::arg("timestep"), py::arg("integrator"), py::arg("compensate_passive_force"),
+           py::arg("qpos_out").noconvert(), py::arg("qvel_out").noconvert(),
+           py::arg("torques_out").noconvert(), py::call_guard<py::gil_scoped_release>());
+
+  PyPinocchioIntegrator.value("SEMI_IMPLICIT_EULER", PinocchioModel::Integrator::SemiImplicitEuler)
+      .value("RK4", PinocchioModel::Integrator::RK4)
+      .export_values();
 #endif
 
 #ifdef _USE_VULKAN
@@ -60,6 +60,41 @@ void ActorBuilder::addMultipleConvexShapesFromFile(const std::string &filename,
   mShapeRecord.push_back(r);
 }
 
+void ActorBuilder::addDecomposedConvexShapesFromFile(const std::string &filename,
+                                                     const PxTransform &pose, const PxVec3 &scale,
+                                                     PxMaterial *material, PxReal density,
+                                                     PxReal patchRadius, PxReal minPatchRadius,
+                                                     ConvexDecompositionParams const &params) {
+  ShapeRecord r;
+  r.type = ShapeRecord::Type::DecomposedMesh;
+  r.filename = filename;
+  r.pose = pose;
+  r.scale = scale;
+  r.material = material;
+  r.density = density;
+  r.patchRadius = patchRadius;
+  r.minPatchRadius = minPatchRadius;
+  r.decomposition = params;
+
+  mShapeRecord.push_back(r);
+}
+
+void ActorBuilder::addNonConvexShapeFromFile(const std::string &filename, const PxTransform &pose,
+                                             const PxVec3 &scale, PxMaterial *material,
+                                             PxReal patchRadius, PxReal minPatchRadius) {
+  ShapeRecord r;
+  r.type = ShapeRecord::Type::NonConvexMesh;
+  r.filename = filename;
+  r.pose = pose;
+  r.scale = scale;
+  r.material = material;
+  r.density = 0.f;
+  r.patchRadius = patchRadius;
+  r.minPatchRadius = minPatchRadius;
+
+  mShapeRecord.push_back(r);
+}
+
 void ActorBuilder::addBoxShape(const PxTransform &pose, const PxVec3 &size, PxMaterial *material,
                                PxReal density, PxReal patchRadius, PxReal minPatchRadius) {
   ShapeRecord r;
@@ -166,56 +201,131 @@ void ActorBuilder::setMassAndInertia(PxReal mass, PxTransform const &cMassPose,
   mInertia = inertia;
 }
 
-void ActorBuilder::buildShapes(std::vector<PxShape *> &shapes,
-                               std::vector<PxReal> &densities) const {
+void ActorBuilder::prefetchMeshes() const {
+  std::vector<std::string> filenames;
+  for (auto &r : mShapeRecord) {
+    if (r.type == ShapeRecord::Type::SingleMesh) {
+      filenames.push_back(r.filename);
+    }
+  }
+  getSimulation()->getMeshManager().loadMeshesAsync(filenames);
+}
+
+PxShape *ActorBuilder::createConvexShape(PxConvexMesh *mesh, ShapeRecord const &r,
+                                         PxMaterial &material, std::string const &name,
+                                         PxReal &density) const {
+  auto physics = getSimulation()->mPhysicsSDK;
+  auto fit = getSimulation()->getMeshManager().fitShape(mesh, r.scale, name);
+  PxShape *shape = nullptr;
+  switch (fit.type) {
+  case PrimitiveFit::Box:
+    shape = physics->createShape(PxBoxGeometry(fit.halfExtents), material, true);
+    break;
+  case PrimitiveFit::Sphere:
+    shape = physics->createShape(PxSphereGeometry(fit.radius), material, true);
+    break;
+  case PrimitiveFit::Capsule:
+    shape = physics->createShape(PxCapsuleGeometry(fit.radius, fit.halfLength), material, true);
+    break;
+  case PrimitiveFit::None:
+    shape = physics->createShape(PxConvexMeshGeometry(mesh, PxMeshScale(r.scale)), material,
+                                 true);
+    break;
+  }
+  if (shape) {
+    shape->setLocalPose(r.pose * fit.pose);
+  }
+  // keep the mass of the hull
+  density = r.density / (1 + fit.error);
+  return shape;
+}
+
+void ActorBuilder::buildShapes(std::vector<PxShape *> &shapes, std::vector<PxReal> &densities,
+                               bool allowNonConvex) const {
+  prefetchMeshes();
   for (auto &r : mShapeRecord) {
     auto material = r.material ? r.material : mScene->getDefaultMaterial();
 
     switch (r.type) {
     case ShapeRecord::Type::SingleMesh: {
-      PxConvexMesh *mesh = getSimulation()->getMeshManager().loadMesh(r.filename);
+      PxConvexMesh *mesh = getSimulation()->getMeshManager().acquireMesh(r.filename);
       if (!mesh) {
         spdlog::get("SAPIEN")->error("Failed to load convex mesh for actor");
         continue;
       }
-      PxShape *shape = getSimulation()->mPhysicsSDK->createShape(
-          PxConvexMeshGeometry(mesh, PxMeshScale(r.scale)), *material, true);
+      PxReal density = r.density;
+      PxShape *shape = createConvexShape(mesh, r, *material, r.filename, density);
+      mesh->release(); // the shape holds its own reference
       shape->setContactOffset(mScene->mDefaultContactOffset);
       if (!shape) {
         spdlog::get("SAPIEN")->critical("Failed to create shape");
         throw std::runtime_error("Failed to create shape");
       }
-      shape->setLocalPose(r.pose);
       shape->setTorsionalPatchRadius(r.patchRadius);
       shape->setMinTorsionalPatchRadius(r.minPatchRadius);
       shapes.push_back(shape);
-      densities.push_back(r.density);
+      densities.push_back(density);
       break;
     }
 
-    case ShapeRecord::Type::MultipleMeshes: {
-      auto meshes = getSimulation()->getMeshManager().loadMeshGroup(r.filename);
-      for (auto mesh : meshes) {
+    case ShapeRecord::Type::MultipleMeshes:
+    case ShapeRecord::Type::DecomposedMesh: {
+      auto meshes =
+          r.type == ShapeRecord::Type::MultipleMeshes
+              ? getSimulation()->getMeshManager().acquireMeshGroup(r.filename)
+              : getSimulation()->getMeshManager().acquireMeshDecomposition(r.filename,
+                                                                           r.decomposition);
+      for (size_t i = 0; i < meshes.size(); ++i) {
+        auto mesh = meshes[i];
         if (!mesh) {
           spdlog::get("SAPIEN")->error("Failed to load part of the convex mesh for actor");
           continue;
         }
-        PxShape *shape = getSimulation()->mPhysicsSDK->createShape(
-            PxConvexMeshGeometry(mesh, PxMeshScale(r.scale)), *material, true);
+        PxReal density = r.density;
+        PxShape *shape = createConvexShape(mesh, r, *material,
+                                           r.filename + "#" + std::to_string(i), density);
+        mesh->release();
         shape->setContactOffset(mScene->mDefaultContactOffset);
         if (!shape) {
           spdlog::get("SAPIEN")->critical("Failed to create shape");
           throw std::runtime_error("Failed to create shape");
         }
-        shape->setLocalPose(r.pose);
         shape->setTorsionalPatchRadius(r.patchRadius);
         shape->setMinTorsionalPatchRadius(r.minPatchRadius);
         shapes.push_back(shape);
-        densities.push_back(r.density);
+        densities.push_back(density);
       }
       break;
     }
 
+    case ShapeRecord::Type::NonConvexMesh: {
+      if (!allowNonConvex) {
+        spdlog::get("SAPIEN")->error(
+            "Non-convex shape {} skipped: only static and kinematic actors support it",
+            r.filename);
+        continue;
+      }
+      PxTriangleMesh *mesh = getSimulation()->getMeshManager().acquireNonConvexMesh(r.filename);
+      if (!mesh) {
+        spdlog::get("SAPIEN")->error("Failed to load non-convex mesh for actor");
+        continue;
+      }
+      PxShape *shape = getSimulation()->mPhysicsSDK->createShape(
+          PxTriangleMeshGeometry(mesh, PxMeshScale(r.scale)), *material, true);
+      mesh->release();
+      if (!shape) {
+        spdlog::get("SAPIEN")->critical("Failed to create shape");
+        throw std::runtime_error("Failed to create shape");
+      }
+      shape->setContactOffset(mScene->mDefaultContactOffset);
+      shape->setLocalPose(r.pose);
+      shape->setTorsionalPatchRadius(r.patchRadius);
+      shape->setMinTorsionalPatchRadius(r.minPatchRadius);
+      shapes.push_back(shape);
+      densities.push_back(r.density);
+      break;
+    }
+
     case ShapeRecord::Type::Box: {
       PxShape *shape =
           getSimulation()->mPhysicsSDK->createShape(PxBoxGeometry(r.scale), *material, true);
@@ -397,6 +507,37 @@ void ActorBuilder::buildCollisionVisuals(std::vector<Renderer::IPxrRigidbody *>
                                                    PxVec3{0, 1, 0});
       break;
     }
+    case PxGeometryType::eTRIANGLEMESH: {
+      PxTriangleMeshGeometry geom;
+      shape->getTriangleMeshGeometry(geom);
+
+      std::vector<PxVec3> vertices;
+      std::vector<PxVec3> normals;
+      std::vector<uint32_t> triangles;
+
+      // flat shading, every triangle gets its own vertices
+      PxTriangleMesh *triangleMesh = geom.triangleMesh;
+      const PxVec3 *meshVerts = triangleMesh->getVertices();
+      bool use16Bit =
+          triangleMesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES;
+      const void *indexBuffer = triangleMesh->getTriangles();
+      for (PxU32 i = 0; i < triangleMesh->getNbTriangles(); ++i) {
+        PxVec3 v[3];
+        for (PxU32 j = 0; j < 3; ++j) {
+          v[j] = meshVerts[use16Bit ? static_cast<const PxU16 *>(indexBuffer)[3 * i + j]
+                                    : static_cast<const PxU32 *>(indexBuffer)[3 * i + j]];
+        }
+        PxVec3 normal = (v[1] - v[0]).cross(v[2] - v[0]).getNormalized();
+        for (PxU32 j = 0; j < 3; ++j) {
+          triangles.push_back(vertices.size());
+          vertices.push_back(v[j]);
+          normals.push_back(normal);
+        }
+      }
+      cBody = rendererScene->addRigidbody(vertices, normals, triangles, geom.scale.scale,
+                                          PxVec3{0, 1, 0});
+      break;
+    }
     default:
       spdlog::get("SAPIEN")->error(
           "Failed to create collision shape rendering: unrecognized geometry type.");
@@ -412,12 +553,47 @@ void ActorBuilder::buildCollisionVisuals(std::vector<Renderer::IPxrRigidbody *>
   }
 }
 
+void ActorBuilder::attachShapes(PxRigidBody &body, std::vector<PxShape *> const &shapes,
+                                std::vector<PxReal> const &densities) const {
+  PxFilterData data;
+  data.word0 = mCollisionGroup.w0;
+  data.word1 = mCollisionGroup.w1;
+  data.word2 = mCollisionGroup.w2;
+  data.word3 = 0;
+
+  // mass properties are computed from the attached shapes, which must all have a volume
+  std::vector<PxShape *> surfaces;
+  std::vector<PxReal> volumeDensities;
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    if (shapes[i]->getGeometryType() == PxGeometryType::eTRIANGLEMESH) {
+      surfaces.push_back(shapes[i]);
+      continue;
+    }
+    body.attachShape(*shapes[i]);
+    shapes[i]->setSimulationFilterData(data);
+    shapes[i]->release(); // this shape is now reference counted by the actor
+    volumeDensities.push_back(densities[i]);
+  }
+  if (volumeDensities.size() && mUseDensity) {
+    PxRigidBodyExt::updateMassAndInertia(body, volumeDensities.data(), volumeDensities.size());
+  } else {
+    body.setMass(mMass);
+    body.setCMassLocalPose(mCMassPose);
+    body.setMassSpaceInertiaTensor(mInertia);
+  }
+  for (auto shape : surfaces) {
+    body.attachShape(*shape);
+    shape->setSimulationFilterData(data);
+    shape->release();
+  }
+}
+
 SActor *ActorBuilder::build(bool isKinematic, std::string const &name) const {
   physx_id_t linkId = mScene->mLinkIdGenerator.next();
 
   std::vector<PxShape *> shapes;
   std::vector<PxReal> densities;
-  buildShapes(shapes, densities);
+  buildShapes(shapes, densities, isKinematic);
 
   std::vector<physx_id_t> renderIds;
   std::vector<Renderer::IPxrRigidbody *> renderBodies;
@@ -432,27 +608,10 @@ SActor *ActorBuilder::build(bool isKinematic, std::string const &name) const {
     body->setSegmentationId(linkId);
   }
 
-  PxFilterData data;
-  data.word0 = mCollisionGroup.w0;
-  data.word1 = mCollisionGroup.w1;
-  data.word2 = mCollisionGroup.w2;
-  data.word3 = 0;
-
   PxRigidDynamic *actor =
       getSimulation()->mPhysicsSDK->createRigidDynamic(PxTransform(PxIdentity));
   actor->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, isKinematic);
-  for (size_t i = 0; i < shapes.size(); ++i) {
-    actor->attachShape(*shapes[i]);
-    shapes[i]->setSimulationFilterData(data);
-    shapes[i]->release(); // this shape is now reference counted by the actor
-  }
-  if (shapes.size() && mUseDensity) {
-    PxRigidBodyExt::updateMassAndInertia(*actor, densities.data(), shapes.size());
-  } else {
-    actor->setMass(mMass);
-    actor->setCMassLocalPose(mCMassPose);
-    actor->setMassSpaceInertiaTensor(mInertia);
-  }
+  attachShapes(*actor, shapes, densities);
 
   auto sActor =
       std::unique_ptr<SActor>(new SActor(actor, linkId, mScene, renderBodies, collisionBodies));
@@ -479,7 +638,7 @@ SActorStatic *ActorBuilder::buildStatic(std::string const &name) const {
 
   std::vector<PxShape *> shapes;
   std::vector<PxReal> densities;
-  buildShapes(shapes, densities);
+  buildShapes(shapes, densities, true);
 
   std::vector<physx_id_t> renderIds;
   std::vector<Renderer::IPxrRigidbody *> renderBodies;
@@ -569,4 +728,53 @@ SActorStatic *ActorBuilder::buildGround(PxReal altitude, bool render, PxMaterial
   return result;
 }
 
+SHeightField *ActorBuilder::buildHeightField(SHeightField::Heights const &heights,
+                                             PxReal cellSize,
+                                             std::vector<PxMaterial *> const &materials,
+                                             SHeightField::MaterialIndices const &materialIndices,
+                                             bool render,
+                                             Renderer::PxrMaterial const &renderMaterial,
+                                             std::string const &name) {
+  if (cellSize <= 0) {
+    spdlog::get("SAPIEN")->error("Height field cell size must be positive");
+    return nullptr;
+  }
+  if (materials.size() >= PxHeightFieldMaterial::eHOLE) {
+    spdlog::get("SAPIEN")->error("Height field supports at most {} materials",
+                                 PxHeightFieldMaterial::eHOLE - 1);
+    return nullptr;
+  }
+  for (auto material : materials) {
+    if (!material) {
+      spdlog::get("SAPIEN")->error("Height field materials must not be null");
+      return nullptr;
+    }
+  }
+
+  physx_id_t linkId = mScene->mLinkIdGenerator.next();
+  PxRigidStatic *actor = getSimulation()->mPhysicsSDK->createRigidStatic(PxTransform(PxIdentity));
+  auto sActor = std::unique_ptr<SHeightField>(new SHeightField(
+      actor, linkId, mScene, cellSize,
+      materials.empty() ? std::vector<PxMaterial *>{mScene->mDefaultMaterial} : materials, render,
+      renderMaterial));
+  sActor->setName(name);
+
+  sActor->mCol1 = mCollisionGroup.w0;
+  sActor->mCol2 = mCollisionGroup.w1;
+  sActor->mCol3 = mCollisionGroup.w2;
+
+  if (!sActor->setHeights(heights, materialIndices)) {
+    sActor.reset();
+    actor->release();
+    return nullptr;
+  }
+
+  actor->userData = sActor.get();
+
+  auto result = sActor.get();
+  mScene->addActor(std::move(sActor));
+
+  return result;
+}
+
 } // namespace sapien
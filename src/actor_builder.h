@@ -1,6 +1,8 @@
 #pragma once
+#include "convex_decomposition.h"
 #include "id_generator.h"
 #include "render_interface.h"
+#include "sapien_height_field.h"
 #include <PxPhysicsAPI.h>
 #include <memory>
 #include <vector>
@@ -20,10 +22,19 @@ class IPxrRididbody;
 class ActorBuilder {
 public:
   struct ShapeRecord {
-    enum Type { SingleMesh, MultipleMeshes, Box, Capsule, Sphere } type;
+    enum Type {
+      SingleMesh,
+      MultipleMeshes,
+      NonConvexMesh,
+      DecomposedMesh,
+      Box,
+      Capsule,
+      Sphere
+    } type;
     // mesh, scale also for box
     std::string filename;
     PxVec3 scale;
+    ConvexDecompositionParams decomposition;
 
     // capsule, radius also for sphere
     PxReal radius;
@@ -94,6 +105,28 @@ public:
                                        PxMaterial *material = nullptr, PxReal density = 1000.f,
                                        PxReal patchRadius = 0.f, PxReal minPatchRadius = 0.f);
 
+  /** Approximate convex decomposition of a non-convex mesh, for any actor
+   *
+   *  The hulls are computed on the first build and cached on disk, see
+   *  MeshManager::loadMeshDecomposition.
+   */
+  void addDecomposedConvexShapesFromFile(const std::string &filename,
+                                         const PxTransform &pose = {{0, 0, 0}, PxIdentity},
+                                         const PxVec3 &scale = {1, 1, 1},
+                                         PxMaterial *material = nullptr, PxReal density = 1000.f,
+                                         PxReal patchRadius = 0.f, PxReal minPatchRadius = 0.f,
+                                         ConvexDecompositionParams const &params = {});
+
+  /** Exact triangle mesh collision, only for static and kinematic actors
+   *
+   *  Triangle meshes have no volume and do not contribute to the mass of kinematic actors.
+   *  Building a dynamic actor or link skips these shapes.
+   */
+  void addNonConvexShapeFromFile(const std::string &filename,
+                                 const PxTransform &pose = {{0, 0, 0}, PxIdentity},
+                                 const PxVec3 &scale = {1, 1, 1}, PxMaterial *material = nullptr,
+                                 PxReal patchRadius = 0.f, PxReal minPatchRadius = 0.f);
+
   void addBoxShape(const PxTransform &pose = {{0, 0, 0}, PxIdentity},
                    const PxVec3 &size = {1, 1, 1}, PxMaterial *material = nullptr,
                    PxReal density = 1000.f, PxReal patchRadius = 0.f, PxReal minPatchRadius = 0.f);
@@ -154,14 +187,39 @@ public:
   SActor *build(bool isKinematic = false, std::string const &name = "") const;
   SActorStatic *buildStatic(std::string const &name = "") const;
 
+  /* Start cooking the convex collision meshes in parallel, building waits for them. Useful to
+   * prefetch meshes of many builders before building any of them. */
+  void prefetchMeshes() const;
+
   SActorStatic *buildGround(PxReal altitude, bool render, PxMaterial *material,
                             Renderer::PxrMaterial const &renderMaterial = {},
                             std::string const &name = "");
 
+  /** Build a static height field terrain, see SHeightField
+   *  @param materials materials referenced by the material indices, the scene default material
+   *         when empty
+   *  @return nullptr if the heights or material indices are invalid
+   */
+  SHeightField *buildHeightField(SHeightField::Heights const &heights, PxReal cellSize,
+                                 std::vector<PxMaterial *> const &materials = {},
+                                 SHeightField::MaterialIndices const &materialIndices = {},
+                                 bool render = true,
+                                 Renderer::PxrMaterial const &renderMaterial = {},
+                                 std::string const &name = "");
+
 protected:
   Simulation *getSimulation() const;
 
-  void buildShapes(std::vector<PxShape *> &shapes, std::vector<PxReal> &densities) const;
+  void buildShapes(std::vector<PxShape *> &shapes, std::vector<PxReal> &densities,
+                   bool allowNonConvex = false) const;
+  /* Convex mesh shape, or its primitive fit when MeshManager primitive fitting accepts it. The
+   * density is adjusted so the primitive keeps the mass of the hull */
+  PxShape *createConvexShape(PxConvexMesh *mesh, ShapeRecord const &r, PxMaterial &material,
+                             std::string const &name, PxReal &density) const;
+  /* Attach shapes to a body and compute its mass, triangle meshes are attached last and do not
+   * contribute to the mass */
+  void attachShapes(PxRigidBody &body, std::vector<PxShape *> const &shapes,
+                    std::vector<PxReal> const &densities) const;
   void buildVisuals(std::vector<Renderer::IPxrRigidbody *> &renderBodies,
                     std::vector<physx_id_t> &renderIds) const;
   void buildCollisionVisuals(std::vector<Renderer::IPxrRigidbody *> &collisionBodies,
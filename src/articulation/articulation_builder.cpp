@@ -154,24 +154,7 @@ bool LinkBuilder::build(SArticulation &articulation) const {
     body->setSegmentationId(linkId);
   }
 
-  PxFilterData data;
-  data.word0 = mCollisionGroup.w0;
-  data.word1 = mCollisionGroup.w1;
-  data.word2 = mCollisionGroup.w2;
-  data.word3 = 0;
-
-  for (size_t i = 0; i < shapes.size(); ++i) {
-    pxLink->attachShape(*shapes[i]);
-    shapes[i]->setSimulationFilterData(data);
-    shapes[i]->release(); // this shape is reference counted by link
-  }
-  if (shapes.size() && mUseDensity) {
-    PxRigidBodyExt::updateMassAndInertia(*pxLink, densities.data(), shapes.size());
-  } else {
-    pxLink->setMass(mMass);
-    pxLink->setCMassLocalPose(mCMassPose);
-    pxLink->setMassSpaceInertiaTensor(mInertia);
-  }
+  attachShapes(*pxLink, shapes, densities);
 
   // wrap link
   links[mIndex] = std::unique_ptr<SLink>(new SLink(pxLink, &articulation, linkId,
@@ -198,6 +181,7 @@ bool LinkBuilder::build(SArticulation &articulation) const {
     j->setLimits(mJointRecord.limits);
     j->setFriction(mJointRecord.friction);
     j->setDriveProperty(0, mJointRecord.damping);
+    j->setVelocityLimit(mJointRecord.velocityLimit);
   } else {
     j = std::unique_ptr<SJoint>(new SJoint(&articulation, nullptr, links[mIndex].get(), nullptr));
   }
@@ -215,7 +199,7 @@ bool LinkBuilder::buildKinematic(SKArticulation &articulation) const {
 
   std::vector<PxShape *> shapes;
   std::vector<PxReal> densities;
-  buildShapes(shapes, densities);
+  buildShapes(shapes, densities, true);
 
   std::vector<physx_id_t> renderIds;
   std::vector<Renderer::IPxrRigidbody *> renderBodies;
@@ -230,27 +214,10 @@ bool LinkBuilder::buildKinematic(SKArticulation &articulation) const {
     body->setSegmentationId(linkId);
   }
 
-  PxFilterData data;
-  data.word0 = mCollisionGroup.w0;
-  data.word1 = mCollisionGroup.w1;
-  data.word2 = mCollisionGroup.w2;
-  data.word3 = 0;
-
   PxRigidDynamic *actor =
       getSimulation()->mPhysicsSDK->createRigidDynamic(PxTransform(PxIdentity));
   actor->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, true);
-  for (size_t i = 0; i < shapes.size(); ++i) {
-    actor->attachShape(*shapes[i]);
-    shapes[i]->setSimulationFilterData(data);
-    shapes[i]->release(); // this shape is now reference counted by the actor
-  }
-  if (shapes.size() && mUseDensity) {
-    PxRigidBodyExt::updateMassAndInertia(*actor, densities.data(), shapes.size());
-  } else {
-    actor->setMass(mMass);
-    actor->setCMassLocalPose(mCMassPose);
-    actor->setMassSpaceInertiaTensor(mInertia);
-  }
+  attachShapes(*actor, shapes, densities);
 
   links[mIndex] = std::unique_ptr<SKLink>(new SKLink(actor, &articulation, linkId,
                                                      mArticulationBuilder->getScene(),
@@ -264,6 +231,11 @@ bool LinkBuilder::buildKinematic(SKArticulation &articulation) const {
 
   actor->userData = links[mIndex].get();
 
+  auto &table = articulation.mJointTable;
+  table.parent[mIndex] = mParent;
+  table.type[mIndex] = mParent >= 0 ? mJointRecord.jointType : PxArticulationJointType::eFIX;
+  table.actor[mIndex] = actor;
+
   std::unique_ptr<SKJoint> j;
   if (mParent >= 0) {
     switch (mJointRecord.jointType) {
@@ -360,6 +332,11 @@ bool ArticulationBuilder::prebuild(std::vector<int> &tosort) const {
     }
   }
 
+  // cook the meshes of all links in parallel, links are built one by one
+  for (auto &builder : mLinkBuilders) {
+    builder->prefetchMeshes();
+  }
+
   return true;
 }
 
@@ -452,6 +429,7 @@ SKArticulation *ArticulationBuilder::buildKinematic() const {
   auto articulation = std::unique_ptr<SKArticulation>(new SKArticulation(mScene));
   articulation->mLinks.resize(mLinkBuilders.size());
   articulation->mJoints.resize(mLinkBuilders.size());
+  articulation->mJointTable.resize(mLinkBuilders.size());
 
   for (int i : sorted) {
     if (!mLinkBuilders[i]->buildKinematic(*articulation)) {
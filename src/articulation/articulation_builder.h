@@ -26,6 +26,7 @@ public:
     PxTransform childPose = {{0, 0, 0}, PxIdentity};
     PxReal friction = 0;
     PxReal damping = 0;
+    PxReal velocityLimit = PX_MAX_F32;
     std::string name = "";
   };
 
@@ -52,6 +53,8 @@ public:
 
   std::string getJointName();
   void setJointName(std::string const &jointName);
+  /* maximum joint speed used by planning tools, it does not affect simulation */
+  inline void setJointVelocityLimit(PxReal limit) { mJointRecord.velocityLimit = limit; }
 
   void setJointProperties(PxArticulationJointType::Enum jointType,
                           std::vector<std::array<PxReal, 2>> const &limits,
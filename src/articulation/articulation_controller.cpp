@@ -0,0 +1,252 @@
+#include "articulation_controller.h"
+#include "sapien_articulation.h"
+#include "sapien_link.h"
+#include <spdlog/spdlog.h>
+
+#define CHECK_SIZE(v)                                                                             \
+  {                                                                                               \
+    if ((v).size() != mDof) {                                                                     \
+      spdlog::get("SAPIEN")->error("Input vector size does not match DOF of controller");         \
+      return;                                                                                     \
+    }                                                                                             \
+  }
+
+namespace sapien {
+
+static Eigen::VectorXf toEigen(std::vector<PxReal> const &v) {
+  return Eigen::Map<const Eigen::VectorXf>(v.data(), v.size());
+}
+
+static std::vector<PxReal> toVector(Eigen::VectorXf const &v) {
+  return std::vector<PxReal>(v.data(), v.data() + v.size());
+}
+
+ArticulationController::ArticulationController(uint32_t dof)
+    : mDof(dof),
+      mForceLimit(Eigen::VectorXf::Constant(dof, std::numeric_limits<PxReal>::infinity())) {}
+
+void ArticulationController::setForceLimit(std::vector<PxReal> const &limit) {
+  CHECK_SIZE(limit);
+  mForceLimit = toEigen(limit).cwiseAbs();
+}
+
+std::vector<PxReal> ArticulationController::getForceLimit() const {
+  return toVector(mForceLimit);
+}
+
+void ArticulationController::update(ControllerContext const &context,
+                                    Eigen::Ref<Eigen::VectorXf> qf) {
+  compute(context, qf);
+  qf = qf.cwiseMax(-mForceLimit).cwiseMin(mForceLimit);
+}
+
+JointPDController::JointPDController(std::vector<PxReal> const &stiffness,
+                                     std::vector<PxReal> const &damping)
+    : ArticulationController(stiffness.size()), mStiffness(toEigen(stiffness)),
+      mDamping(Eigen::VectorXf::Zero(mDof)), mTargetPosition(Eigen::VectorXf::Zero(mDof)),
+      mTargetVelocity(Eigen::VectorXf::Zero(mDof)) {
+  CHECK_SIZE(damping);
+  mDamping = toEigen(damping);
+}
+
+void JointPDController::setGains(std::vector<PxReal> const &stiffness,
+                                 std::vector<PxReal> const &damping) {
+  CHECK_SIZE(stiffness);
+  CHECK_SIZE(damping);
+  mStiffness = toEigen(stiffness);
+  mDamping = toEigen(damping);
+}
+
+std::vector<PxReal> JointPDController::getStiffness() const { return toVector(mStiffness); }
+std::vector<PxReal> JointPDController::getDamping() const { return toVector(mDamping); }
+
+void JointPDController::setTarget(std::vector<PxReal> const &qpos) {
+  CHECK_SIZE(qpos);
+  mTargetPosition = toEigen(qpos);
+}
+
+void JointPDController::setTargetVelocity(std::vector<PxReal> const &qvel) {
+  CHECK_SIZE(qvel);
+  mTargetVelocity = toEigen(qvel);
+}
+
+std::vector<PxReal> JointPDController::getTarget() const { return toVector(mTargetPosition); }
+std::vector<PxReal> JointPDController::getTargetVelocity() const {
+  return toVector(mTargetVelocity);
+}
+
+void JointPDController::compute(ControllerContext const &context,
+                                Eigen::Ref<Eigen::VectorXf> qf) {
+  qf = mStiffness.cwiseProduct(mTargetPosition - context.qpos) +
+       mDamping.cwiseProduct(mTargetVelocity - context.qvel);
+}
+
+JointImpedanceController::JointImpedanceController(std::vector<PxReal> const &stiffness,
+                                                   std::vector<PxReal> const &damping)
+    : JointPDController(stiffness, damping), mFeedforward(Eigen::VectorXf::Zero(mDof)) {}
+
+void JointImpedanceController::setFeedforward(std::vector<PxReal> const &qf) {
+  CHECK_SIZE(qf);
+  mFeedforward = toEigen(qf);
+}
+
+std::vector<PxReal> JointImpedanceController::getFeedforward() const {
+  return toVector(mFeedforward);
+}
+
+void JointImpedanceController::compute(ControllerContext const &context,
+                                       Eigen::Ref<Eigen::VectorXf> qf) {
+  JointPDController::compute(context, qf);
+  qf += mFeedforward;
+}
+
+#define CHECK_SIZE_6(v)                                                                           \
+  {                                                                                               \
+    if ((v).size() != 6) {                                                                        \
+      spdlog::get("SAPIEN")->error("Task space vectors should have size 6");                      \
+      return;                                                                                     \
+    }                                                                                             \
+  }
+
+static Eigen::Matrix<PxReal, 6, 1> toEigen6(std::vector<PxReal> const &v) {
+  return Eigen::Map<const Eigen::Matrix<PxReal, 6, 1>>(v.data());
+}
+
+static std::vector<PxReal> toVector6(Eigen::Matrix<PxReal, 6, 1> const &v) {
+  return std::vector<PxReal>(v.data(), v.data() + 6);
+}
+
+OperationalSpaceController::OperationalSpaceController(uint32_t dof, uint32_t linkId,
+                                                       std::vector<PxReal> const &stiffness,
+                                                       std::vector<PxReal> const &damping)
+    : ArticulationController(dof), mLinkId(linkId),
+      mStiffness(Eigen::Matrix<PxReal, 6, 1>::Zero()),
+      mDamping(Eigen::Matrix<PxReal, 6, 1>::Zero()),
+      mTargetVelocity(Eigen::Matrix<PxReal, 6, 1>::Zero()),
+      mTargetWrench(Eigen::Matrix<PxReal, 6, 1>::Zero()),
+      mNullspaceStiffness(Eigen::VectorXf::Zero(dof)),
+      mNullspaceDamping(Eigen::VectorXf::Zero(dof)), mNullspaceTarget(Eigen::VectorXf::Zero(dof)),
+      mJacobian(6, dof), mMass(dof, dof), mMassLDLT(dof), mMassInvJt(dof, 6), mPosture(dof) {
+  setGains(stiffness, damping);
+}
+
+void OperationalSpaceController::setGains(std::vector<PxReal> const &stiffness,
+                                          std::vector<PxReal> const &damping) {
+  CHECK_SIZE_6(stiffness);
+  CHECK_SIZE_6(damping);
+  mStiffness = toEigen6(stiffness);
+  mDamping = toEigen6(damping);
+}
+
+std::vector<PxReal> OperationalSpaceController::getStiffness() const {
+  return toVector6(mStiffness);
+}
+std::vector<PxReal> OperationalSpaceController::getDamping() const { return toVector6(mDamping); }
+
+void OperationalSpaceController::setTargetVelocity(std::vector<PxReal> const &velocity) {
+  CHECK_SIZE_6(velocity);
+  mTargetVelocity = toEigen6(velocity);
+}
+
+std::vector<PxReal> OperationalSpaceController::getTargetVelocity() const {
+  return toVector6(mTargetVelocity);
+}
+
+void OperationalSpaceController::setTargetWrench(std::vector<PxReal> const &wrench) {
+  CHECK_SIZE_6(wrench);
+  mTargetWrench = toEigen6(wrench);
+}
+
+std::vector<PxReal> OperationalSpaceController::getTargetWrench() const {
+  return toVector6(mTargetWrench);
+}
+
+void OperationalSpaceController::setSingularityDamping(PxReal damping) {
+  if (!(damping >= 0)) {
+    spdlog::get("SAPIEN")->error("Singularity damping must be non-negative");
+    return;
+  }
+  mSingularityDamping = damping;
+}
+
+void OperationalSpaceController::setNullspaceGains(std::vector<PxReal> const &stiffness,
+                                                   std::vector<PxReal> const &damping) {
+  CHECK_SIZE(stiffness);
+  CHECK_SIZE(damping);
+  mNullspaceStiffness = toEigen(stiffness);
+  mNullspaceDamping = toEigen(damping);
+}
+
+void OperationalSpaceController::setNullspaceTarget(std::vector<PxReal> const &qpos) {
+  CHECK_SIZE(qpos);
+  mNullspaceTarget = toEigen(qpos);
+}
+
+std::vector<PxReal> OperationalSpaceController::getNullspaceTarget() const {
+  return toVector(mNullspaceTarget);
+}
+
+void OperationalSpaceController::compute(ControllerContext const &context,
+                                         Eigen::Ref<Eigen::VectorXf> qf) {
+  auto articulation = context.articulation;
+  auto pxArticulation = articulation->getPxArticulation();
+  auto &E2I = articulation->getIndexE2I();
+
+  // state is already in the cache, only J and M are computed here
+  PxU32 nRows, nCols;
+  pxArticulation->computeDenseJacobian(*context.cache, nRows, nCols);
+  articulation->copyLinkJacobian(*context.cache, mLinkId, false, mJacobian);
+  pxArticulation->computeGeneralizedMassMatrix(*context.cache);
+  for (uint32_t r = 0; r < mDof; ++r) {
+    for (uint32_t c = 0; c < mDof; ++c) {
+      mMass(r, c) = context.cache->massMatrix[E2I[r] * mDof + E2I[c]];
+    }
+  }
+
+  // task space error, orientation as the axis-angle rotating the link onto the target
+  if (!mLink) {
+    mLink = articulation->getSLinks()[mLinkId];
+  }
+  PxTransform pose = mLink->getPose();
+  Eigen::Matrix<PxReal, 6, 1> error;
+  PxVec3 dp = mTargetPose.p - pose.p;
+  PxQuat dq = mTargetPose.q * pose.q.getConjugate();
+  if (dq.w < 0) {
+    dq = -dq;
+  }
+  PxReal angle;
+  PxVec3 axis;
+  dq.toRadiansAndUnitAxis(angle, axis);
+  error << dp.x, dp.y, dp.z, axis.x * angle, axis.y * angle, axis.z * angle;
+
+  Eigen::Matrix<PxReal, 6, 1> velocity = mJacobian * context.qvel;
+  Eigen::Matrix<PxReal, 6, 1> acceleration =
+      mStiffness.cwiseProduct(error) + mDamping.cwiseProduct(mTargetVelocity - velocity);
+
+  // Lambda = (J M^-1 J^T + l^2 I)^-1, damped so that it stays bounded near singularities
+  mMassLDLT.compute(mMass);
+  mMassInvJt = mMassLDLT.solve(mJacobian.transpose());
+  Eigen::Matrix<PxReal, 6, 6> lambdaInv = mJacobian * mMassInvJt;
+  lambdaInv.diagonal().array() += mSingularityDamping * mSingularityDamping;
+  mLambdaInvLDLT.compute(lambdaInv);
+
+  Eigen::Matrix<PxReal, 6, 1> wrench = mLambdaInvLDLT.solve(acceleration);
+  wrench += mTargetWrench;
+  qf.noalias() = mJacobian.transpose() * wrench;
+
+  if (!mNullspaceStiffness.isZero() || !mNullspaceDamping.isZero()) {
+    mPosture = mNullspaceStiffness.cwiseProduct(mNullspaceTarget - context.qpos) -
+               mNullspaceDamping.cwiseProduct(context.qvel);
+    // (I - J^T Jbar^T) posture with Jbar = M^-1 J^T Lambda
+    Eigen::Matrix<PxReal, 6, 1> projected;
+    projected.noalias() = mMassInvJt.transpose() * mPosture;
+    Eigen::Matrix<PxReal, 6, 1> nullspaceWrench = mLambdaInvLDLT.solve(projected);
+    qf += mPosture;
+    qf.noalias() -= mJacobian.transpose() * nullspaceWrench;
+  }
+}
+
+} // namespace sapien
+
+#undef CHECK_SIZE_6
+#undef CHECK_SIZE
@@ -0,0 +1,167 @@
+#pragma once
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+class SLink;
+
+/* Everything a controller may read in prestep. qpos and qvel are in external order and are
+ * copied from the articulation cache once per step, shared by all controllers. */
+struct ControllerContext {
+  SArticulation *articulation;
+  PxArticulationCache *cache;
+  Eigen::VectorXf const &qpos;
+  Eigen::VectorXf const &qvel;
+  PxReal timestep;
+};
+
+/** Torque controller executed in SArticulation::prestep
+ *
+ *  The joint forces of all controllers attached to an articulation are summed together with
+ *  passive force compensation and the forces given by setQf and setHeldQf. Every controller
+ *  output is clamped to its force limits, which are infinite by default.
+ */
+class ArticulationController {
+protected:
+  uint32_t mDof;
+  bool mEnabled{true};
+  Eigen::VectorXf mForceLimit;
+
+public:
+  explicit ArticulationController(uint32_t dof);
+  virtual ~ArticulationController() = default;
+
+  inline uint32_t dof() const { return mDof; }
+
+  inline void setEnabled(bool enabled) { mEnabled = enabled; }
+  inline bool isEnabled() const { return mEnabled; }
+
+  /* Per joint absolute force limits */
+  void setForceLimit(std::vector<PxReal> const &limit);
+  std::vector<PxReal> getForceLimit() const;
+
+  /* Write the joint force of this controller into qf, which is zero initialized */
+  virtual void compute(ControllerContext const &context, Eigen::Ref<Eigen::VectorXf> qf) = 0;
+
+  /* Called by the articulation, compute followed by force clamping */
+  void update(ControllerContext const &context, Eigen::Ref<Eigen::VectorXf> qf);
+};
+
+/* qf = Kp (q* - q) + Kd (qd* - qd) */
+class JointPDController : public ArticulationController {
+protected:
+  Eigen::VectorXf mStiffness;
+  Eigen::VectorXf mDamping;
+  Eigen::VectorXf mTargetPosition;
+  Eigen::VectorXf mTargetVelocity;
+
+public:
+  JointPDController(std::vector<PxReal> const &stiffness, std::vector<PxReal> const &damping);
+
+  void setGains(std::vector<PxReal> const &stiffness, std::vector<PxReal> const &damping);
+  std::vector<PxReal> getStiffness() const;
+  std::vector<PxReal> getDamping() const;
+
+  void setTarget(std::vector<PxReal> const &qpos);
+  void setTargetVelocity(std::vector<PxReal> const &qvel);
+  std::vector<PxReal> getTarget() const;
+  std::vector<PxReal> getTargetVelocity() const;
+
+  void compute(ControllerContext const &context, Eigen::Ref<Eigen::VectorXf> qf) override;
+};
+
+/* qf = K (q* - q) + D (qd* - qd) + qf_ff, with the feedforward term typically coming from an
+ * inverse dynamics model of the commanded motion */
+class JointImpedanceController : public JointPDController {
+protected:
+  Eigen::VectorXf mFeedforward;
+
+public:
+  JointImpedanceController(std::vector<PxReal> const &stiffness,
+                           std::vector<PxReal> const &damping);
+
+  void setFeedforward(std::vector<PxReal> const &qf);
+  std::vector<PxReal> getFeedforward() const;
+
+  void compute(ControllerContext const &context, Eigen::Ref<Eigen::VectorXf> qf) override;
+};
+
+/** Operational space impedance control of one link
+ *
+ *  F = Lambda (Kp e + Kd (v* - v)) + F*, qf = J^T F + (I - J^T Jbar^T) qf_null
+ *
+ *  e stacks the position error and the axis-angle orientation error of the link pose, v is
+ *  the link Cartesian velocity (linear then angular, world frame), Lambda = (J M^-1 J^T)^-1 is
+ *  the task space inertia and Jbar = M^-1 J^T Lambda the dynamically consistent inverse. The
+ *  nullspace term qf_null = Kn (q_null - q) - Dn qd only acts in directions that do not
+ *  disturb the link. J and M are computed from the articulation cache already filled for the
+ *  step. Gravity is not included, enable passive force compensation on the articulation.
+ */
+class OperationalSpaceController : public ArticulationController {
+protected:
+  uint32_t mLinkId;
+  Eigen::Matrix<PxReal, 6, 1> mStiffness;
+  Eigen::Matrix<PxReal, 6, 1> mDamping;
+
+  PxTransform mTargetPose{PxIdentity};
+  Eigen::Matrix<PxReal, 6, 1> mTargetVelocity;
+  Eigen::Matrix<PxReal, 6, 1> mTargetWrench;
+
+  Eigen::VectorXf mNullspaceStiffness;
+  Eigen::VectorXf mNullspaceDamping;
+  Eigen::VectorXf mNullspaceTarget;
+
+  PxReal mSingularityDamping{1e-2f};
+
+  // per step scratch, sized once so that compute does not allocate
+  SLink *mLink{nullptr};
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> mJacobian;
+  Eigen::MatrixXf mMass;
+  Eigen::LDLT<Eigen::MatrixXf> mMassLDLT;
+  Eigen::MatrixXf mMassInvJt;
+  Eigen::LDLT<Eigen::Matrix<PxReal, 6, 6>> mLambdaInvLDLT;
+  Eigen::VectorXf mPosture;
+
+public:
+  /** @param linkId controlled link, must not be the root
+   *  @param stiffness, damping 6 task space gains, linear then angular
+   */
+  OperationalSpaceController(uint32_t dof, uint32_t linkId, std::vector<PxReal> const &stiffness,
+                             std::vector<PxReal> const &damping);
+
+  inline uint32_t getLinkId() const { return mLinkId; }
+
+  void setGains(std::vector<PxReal> const &stiffness, std::vector<PxReal> const &damping);
+  std::vector<PxReal> getStiffness() const;
+  std::vector<PxReal> getDamping() const;
+
+  inline void setTarget(PxTransform const &pose) { mTargetPose = pose; }
+  inline PxTransform getTarget() const { return mTargetPose; }
+
+  /* 6 values, linear then angular, world frame */
+  void setTargetVelocity(std::vector<PxReal> const &velocity);
+  std::vector<PxReal> getTargetVelocity() const;
+
+  /* Feedforward wrench applied by the link, force then torque, world frame */
+  void setTargetWrench(std::vector<PxReal> const &wrench);
+  std::vector<PxReal> getTargetWrench() const;
+
+  /* Lambda = (J M^-1 J^T + damping^2 I)^-1 stays bounded near singular configurations, 0
+   * gives the exact task space inertia */
+  void setSingularityDamping(PxReal damping);
+  inline PxReal getSingularityDamping() const { return mSingularityDamping; }
+
+  /* Posture held in the nullspace of the task, zero gains disable it */
+  void setNullspaceGains(std::vector<PxReal> const &stiffness,
+                         std::vector<PxReal> const &damping);
+  void setNullspaceTarget(std::vector<PxReal> const &qpos);
+  std::vector<PxReal> getNullspaceTarget() const;
+
+  void compute(ControllerContext const &context, Eigen::Ref<Eigen::VectorXf> qf) override;
+};
+
+} // namespace sapien
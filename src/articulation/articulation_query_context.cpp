@@ -0,0 +1,131 @@
+#include "articulation_query_context.h"
+#include "sapien_articulation.h"
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+ArticulationQueryContext::ArticulationQueryContext(SArticulation *articulation)
+    : mArticulation(articulation), mPxArticulation(articulation->getPxArticulation()),
+      mDof(articulation->dof()) {
+  mCache = mPxArticulation->createCache();
+  mPxArticulation->zeroCache(*mCache);
+  mScratch.resize(mDof);
+}
+
+ArticulationQueryContext::~ArticulationQueryContext() { mPxArticulation->releaseCache(*mCache); }
+
+std::vector<PxReal> ArticulationQueryContext::gather(PxReal const *internal) {
+  Eigen::Map<Eigen::VectorXf> external(mScratch.data(), mDof);
+  mArticulation->gatherFromCache(internal, external);
+  return mScratch;
+}
+
+bool ArticulationQueryContext::scatter(std::vector<PxReal> const &external, PxReal *internal) {
+  if (external.size() != mDof) {
+    spdlog::get("SAPIEN")->error("Input vector size does not match DOF of articulation");
+    return false;
+  }
+  mArticulation->scatterToCache(Eigen::Map<const Eigen::VectorXf>(external.data(), mDof),
+                                internal);
+  return true;
+}
+
+std::vector<PxReal> ArticulationQueryContext::getQpos() {
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION);
+  return gather(mCache->jointPosition);
+}
+
+std::vector<PxReal> ArticulationQueryContext::getQvel() {
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eVELOCITY);
+  return gather(mCache->jointVelocity);
+}
+
+std::vector<PxReal> ArticulationQueryContext::computePassiveForce(bool gravity,
+                                                                  bool coriolisAndCentrifugal,
+                                                                  bool external) {
+  mArticulation->prepareCommonData();
+  std::vector<PxReal> passiveForce(mDof, 0);
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION |
+                                                         PxArticulationCache::eVELOCITY);
+  if (coriolisAndCentrifugal) {
+    mPxArticulation->computeCoriolisAndCentrifugalForce(*mCache);
+    for (uint32_t i = 0; i < mDof; ++i) {
+      passiveForce[i] += mCache->jointForce[i];
+    }
+  }
+  if (gravity) {
+    mPxArticulation->computeGeneralizedGravityForce(*mCache);
+    for (uint32_t i = 0; i < mDof; ++i) {
+      passiveForce[i] += mCache->jointForce[i];
+    }
+  }
+  if (external) {
+    mPxArticulation->computeGeneralizedExternalForce(*mCache);
+    for (uint32_t i = 0; i < mDof; ++i) {
+      passiveForce[i] += mCache->jointForce[i];
+    }
+  }
+  return gather(passiveForce.data());
+}
+
+std::vector<PxReal>
+ArticulationQueryContext::computeInverseDynamics(std::vector<PxReal> const &qacc) {
+  mArticulation->prepareCommonData();
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION |
+                                                         PxArticulationCache::eVELOCITY);
+  if (!scatter(qacc, mCache->jointAcceleration)) {
+    return std::vector<PxReal>(mDof, 0);
+  }
+  mPxArticulation->computeJointForce(*mCache);
+  return gather(mCache->jointForce);
+}
+
+std::vector<PxReal>
+ArticulationQueryContext::computeForwardDynamics(std::vector<PxReal> const &qf) {
+  mArticulation->prepareCommonData();
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION |
+                                                         PxArticulationCache::eVELOCITY);
+  if (!scatter(qf, mCache->jointForce)) {
+    return std::vector<PxReal>(mDof, 0);
+  }
+  mPxArticulation->computeJointAcceleration(*mCache);
+  return gather(mCache->jointAcceleration);
+}
+
+void ArticulationQueryContext::computeManipulatorInertiaMatrix(
+    Eigen::Ref<Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> out) {
+  mArticulation->prepareCommonData();
+  mPxArticulation->computeGeneralizedMassMatrix(*mCache);
+  Eigen::Map<Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> mass(
+      mCache->massMatrix, mDof, mDof);
+  auto &E2I = mArticulation->getIndexE2I();
+  for (uint32_t r = 0; r < mDof; ++r) {
+    for (uint32_t c = 0; c < mDof; ++c) {
+      out(r, c) = mass(E2I[r], E2I[c]);
+    }
+  }
+}
+
+Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+ArticulationQueryContext::computeManipulatorInertiaMatrix() {
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> result(mDof, mDof);
+  computeManipulatorInertiaMatrix(result);
+  return result;
+}
+
+Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+ArticulationQueryContext::computeLinkJacobian(uint32_t linkId, bool spatialTwist) {
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> result =
+      Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>::Zero(6, mDof);
+  if (linkId == 0 || linkId >= mArticulation->getBaseLinks().size()) {
+    spdlog::get("SAPIEN")->error("Invalid link id {} for Jacobian computation", linkId);
+    return result;
+  }
+  mArticulation->prepareCommonData();
+  PxU32 nRows, nCols;
+  mPxArticulation->computeDenseJacobian(*mCache, nRows, nCols);
+  mArticulation->copyLinkJacobian(*mCache, linkId, spatialTwist, result);
+  return result;
+}
+
+} // namespace sapien
@@ -0,0 +1,66 @@
+#pragma once
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+
+/** Dynamics queries on an articulation backed by a private PxArticulationCache
+ *
+ *  SArticulation query functions share the articulation cache and must be serialized.
+ *  A query context owns its cache and scratch buffers, so different contexts, on the same or
+ *  on different articulations, can be queried from different threads concurrently. The
+ *  first query after a step or a change of the articulation state recomputes the pose
+ *  dependent PhysX data of the articulation, once for all its contexts. Do not step the
+ *  scene, modify the articulation or call SArticulation queries while context queries are
+ *  running. A single context is not thread-safe, use one per thread.
+ *
+ *  Contexts are created by SArticulation::createQueryContext. All vectors are in external
+ *  joint order.
+ */
+class ArticulationQueryContext {
+  friend class SArticulation;
+
+  SArticulation *mArticulation;
+  PxArticulationReducedCoordinate *mPxArticulation;
+  PxArticulationCache *mCache;
+  uint32_t mDof;
+
+  std::vector<PxReal> mScratch;
+
+public:
+  ArticulationQueryContext(ArticulationQueryContext const &other) = delete;
+  ArticulationQueryContext &operator=(ArticulationQueryContext const &other) = delete;
+  ~ArticulationQueryContext();
+
+  inline SArticulation *getArticulation() const { return mArticulation; }
+  inline uint32_t dof() const { return mDof; }
+
+  std::vector<PxReal> getQpos();
+  std::vector<PxReal> getQvel();
+
+  std::vector<PxReal> computePassiveForce(bool gravity = true, bool coriolisAndCentrifugal = true,
+                                          bool external = true);
+  std::vector<PxReal> computeInverseDynamics(std::vector<PxReal> const &qacc);
+  std::vector<PxReal> computeForwardDynamics(std::vector<PxReal> const &qf);
+
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+  computeManipulatorInertiaMatrix();
+  void computeManipulatorInertiaMatrix(
+      Eigen::Ref<Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> out);
+
+  /* 6 x dof Jacobian of a link, linear rows first */
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+  computeLinkJacobian(uint32_t linkId, bool spatialTwist = true);
+
+private:
+  explicit ArticulationQueryContext(SArticulation *articulation);
+
+  std::vector<PxReal> gather(PxReal const *internal);
+  bool scatter(std::vector<PxReal> const &external, PxReal *internal);
+};
+
+} // namespace sapien
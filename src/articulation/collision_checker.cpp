@@ -0,0 +1,320 @@
+#include "collision_checker.h"
+#include "sapien_articulation.h"
+#include "sapien_joint.h"
+#include "sapien_link.h"
+#include "sapien_scene.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+static bool shouldCollide(PxFilterData const &a, PxFilterData const &b) {
+  // same rules as TypeAffinityIgnoreFilterShader
+  if (a.word2 & b.word2) {
+    return false;
+  }
+  return (a.word0 & b.word1) || (b.word0 & a.word1);
+}
+
+static bool isPrimitive(PxGeometryType::Enum type) {
+  return type == PxGeometryType::eSPHERE || type == PxGeometryType::eCAPSULE ||
+         type == PxGeometryType::eBOX || type == PxGeometryType::eCONVEXMESH;
+}
+
+// PxGeometryQuery::overlap needs at least one primitive
+static bool isSupported(PxGeometryType::Enum a, PxGeometryType::Enum b) {
+  return isPrimitive(a) || isPrimitive(b);
+}
+
+static void acquireGeometry(PxGeometryHolder const &holder) {
+  switch (holder.getType()) {
+  case PxGeometryType::eCONVEXMESH:
+    holder.convexMesh().convexMesh->acquireReference();
+    break;
+  case PxGeometryType::eTRIANGLEMESH:
+    holder.triangleMesh().triangleMesh->acquireReference();
+    break;
+  case PxGeometryType::eHEIGHTFIELD:
+    holder.heightField().heightField->acquireReference();
+    break;
+  default:
+    break;
+  }
+}
+
+static void releaseGeometry(PxGeometryHolder const &holder) {
+  switch (holder.getType()) {
+  case PxGeometryType::eCONVEXMESH:
+    holder.convexMesh().convexMesh->release();
+    break;
+  case PxGeometryType::eTRIANGLEMESH:
+    holder.triangleMesh().triangleMesh->release();
+    break;
+  case PxGeometryType::eHEIGHTFIELD:
+    holder.heightField().heightField->release();
+    break;
+  default:
+    break;
+  }
+}
+
+static std::vector<PxShape *> getSimulationShapes(PxRigidActor *actor) {
+  std::vector<PxShape *> shapes(actor->getNbShapes());
+  actor->getShapes(shapes.data(), shapes.size());
+  shapes.erase(std::remove_if(shapes.begin(), shapes.end(),
+                              [](PxShape *s) {
+                                return !(s->getFlags() & PxShapeFlag::eSIMULATION_SHAPE);
+                              }),
+               shapes.end());
+  return shapes;
+}
+
+CollisionChecker::CollisionChecker(SArticulation *articulation, uint32_t numThreads)
+    : mArticulation(articulation), mDof(articulation->dof()), mNumThreads(numThreads) {
+  auto links = articulation->getSLinks();
+  auto joints = articulation->getSJoints();
+  uint32_t n = links.size();
+
+  mParent.assign(n, -1);
+  mJointType.assign(n, PxArticulationJointType::eFIX);
+  mJointParentPose.assign(n, PxTransform(PxIdentity));
+  mJointChildPoseInv.assign(n, PxTransform(PxIdentity));
+  mQIndex.assign(n, -1);
+
+  // joints are visited in qpos order, their data is stored at the index of their child link
+  uint32_t q = 0;
+  std::vector<std::vector<uint32_t>> children(n);
+  for (auto joint : joints) {
+    uint32_t i = joint->getChildLink()->getIndex();
+    auto parent = joint->getParentLink();
+    uint32_t dof = joint->getDof();
+    if (dof > 1) {
+      throw std::runtime_error("Collision checker only supports single dof joints");
+    }
+    if (parent) {
+      mParent[i] = parent->getIndex();
+      children[mParent[i]].push_back(i);
+      mJointType[i] = joint->getType();
+      mJointParentPose[i] = joint->getParentPose();
+      mJointChildPoseInv[i] = joint->getChildPose().getInverse();
+    }
+    if (dof) {
+      mQIndex[i] = q;
+    }
+    q += dof;
+  }
+
+  std::queue<uint32_t> queue;
+  queue.push(articulation->getRootLink()->getIndex());
+  while (!queue.empty()) {
+    uint32_t i = queue.front();
+    queue.pop();
+    mOrder.push_back(i);
+    for (uint32_t c : children[i]) {
+      queue.push(c);
+    }
+  }
+
+  for (auto link : links) {
+    for (PxShape *shape : getSimulationShapes(link->getPxActor())) {
+      mLinkShapes.push_back({link->getIndex(), shape->getGeometry(), shape->getLocalPose(),
+                             shape->getSimulationFilterData()});
+      acquireGeometry(mLinkShapes.back().geometry);
+    }
+  }
+
+  buildSelfPairs();
+  updateScene();
+}
+
+CollisionChecker::~CollisionChecker() {
+  releaseSceneShapes();
+  for (auto &shape : mLinkShapes) {
+    releaseGeometry(shape.geometry);
+  }
+}
+
+void CollisionChecker::buildSelfPairs() {
+  mSelfPairs.clear();
+  for (uint32_t a = 0; a < mLinkShapes.size(); ++a) {
+    for (uint32_t b = a + 1; b < mLinkShapes.size(); ++b) {
+      auto &sa = mLinkShapes[a];
+      auto &sb = mLinkShapes[b];
+      uint32_t la = std::min(sa.link, sb.link);
+      uint32_t lb = std::max(sa.link, sb.link);
+      if (la == lb || mParent[la] == static_cast<int>(lb) ||
+          mParent[lb] == static_cast<int>(la) ||
+          std::find(mIgnoredLinkPairs.begin(), mIgnoredLinkPairs.end(),
+                    std::make_pair(la, lb)) != mIgnoredLinkPairs.end()) {
+        continue;
+      }
+      if (!shouldCollide(sa.filter, sb.filter) ||
+          !isSupported(sa.geometry.getType(), sb.geometry.getType())) {
+        continue;
+      }
+      mSelfPairs.push_back({a, b});
+    }
+  }
+}
+
+void CollisionChecker::ignoreLinkPair(uint32_t link1, uint32_t link2) {
+  mIgnoredLinkPairs.push_back({std::min(link1, link2), std::max(link1, link2)});
+  buildSelfPairs();
+}
+
+void CollisionChecker::releaseSceneShapes() {
+  for (auto &shape : mSceneShapes) {
+    releaseGeometry(shape.geometry);
+  }
+  mSceneShapes.clear();
+}
+
+void CollisionChecker::updateScene() {
+  releaseSceneShapes();
+  auto scene = mArticulation->getScene();
+
+  auto addActor = [&](SActorBase *actor) {
+    PxRigidActor *pxActor = actor->getPxActor();
+    PxTransform actorPose = pxActor->getGlobalPose();
+    for (PxShape *shape : getSimulationShapes(pxActor)) {
+      SceneShape s{actor, shape->getGeometry(), actorPose * shape->getLocalPose(),
+                   PxBounds3::empty(), shape->getSimulationFilterData()};
+      s.bounds = PxGeometryQuery::getWorldBounds(s.geometry.any(), s.pose);
+      acquireGeometry(s.geometry);
+      mSceneShapes.push_back(s);
+    }
+  };
+
+  for (auto actor : scene->getAllActors()) {
+    if (!actor->isBeingDestroyed()) {
+      addActor(actor);
+    }
+  }
+  for (auto articulation : scene->getAllArticulations()) {
+    if (articulation == mArticulation) {
+      continue;
+    }
+    for (auto link : articulation->getBaseLinks()) {
+      if (!link->isBeingDestroyed()) {
+        addActor(link);
+      }
+    }
+  }
+}
+
+void CollisionChecker::computeLinkPoses(PxReal const *qpos,
+                                        std::vector<PxTransform> &poses) const {
+  poses.resize(mParent.size());
+  uint32_t root = mOrder[0];
+  poses[root] = mArticulation->getRootLink()->getPose();
+  for (size_t k = 1; k < mOrder.size(); ++k) {
+    uint32_t i = mOrder[k];
+    PxTransform jointPose(PxIdentity);
+    if (mQIndex[i] >= 0) {
+      PxReal q = qpos[mQIndex[i]];
+      if (mJointType[i] == PxArticulationJointType::eREVOLUTE) {
+        jointPose.q = PxQuat(q, {1, 0, 0});
+      } else if (mJointType[i] == PxArticulationJointType::ePRISMATIC) {
+        jointPose.p = {q, 0, 0};
+      }
+    }
+    poses[i] = poses[mParent[i]] * mJointParentPose[i] * jointPose * mJointChildPoseInv[i];
+  }
+}
+
+template <typename F>
+void CollisionChecker::forEachCollision(std::vector<PxTransform> const &linkPoses,
+                                        bool selfCollision, bool sceneCollision,
+                                        F &&visit) const {
+  if (selfCollision) {
+    for (auto [a, b] : mSelfPairs) {
+      auto &sa = mLinkShapes[a];
+      auto &sb = mLinkShapes[b];
+      if (PxGeometryQuery::overlap(sa.geometry.any(), linkPoses[sa.link] * sa.localPose,
+                                   sb.geometry.any(), linkPoses[sb.link] * sb.localPose)) {
+        if (!visit(sa.link, static_cast<int>(sb.link), nullptr)) {
+          return;
+        }
+      }
+    }
+  }
+  if (sceneCollision) {
+    for (auto &sa : mLinkShapes) {
+      PxTransform pose = linkPoses[sa.link] * sa.localPose;
+      PxBounds3 bounds = PxGeometryQuery::getWorldBounds(sa.geometry.any(), pose);
+      for (auto &sb : mSceneShapes) {
+        if (!bounds.intersects(sb.bounds) || !shouldCollide(sa.filter, sb.filter) ||
+            !isSupported(sa.geometry.getType(), sb.geometry.getType())) {
+          continue;
+        }
+        if (PxGeometryQuery::overlap(sa.geometry.any(), pose, sb.geometry.any(), sb.pose)) {
+          if (!visit(sa.link, -1, sb.actor)) {
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+bool CollisionChecker::isColliding(std::vector<PxReal> const &qpos, bool selfCollision,
+                                   bool sceneCollision) const {
+  if (qpos.size() != mDof) {
+    spdlog::get("SAPIEN")->error("Input vector size does not match DOF of articulation");
+    return false;
+  }
+  std::vector<PxTransform> poses;
+  return isColliding(qpos.data(), poses, selfCollision, sceneCollision);
+}
+
+bool CollisionChecker::isColliding(PxReal const *qpos, std::vector<PxTransform> &poses,
+                                   bool selfCollision, bool sceneCollision) const {
+  computeLinkPoses(qpos, poses);
+  bool colliding = false;
+  forEachCollision(poses, selfCollision, sceneCollision, [&](uint32_t, int, SActorBase *) {
+    colliding = true;
+    return false;
+  });
+  return colliding;
+}
+
+std::vector<std::pair<SActorBase *, SActorBase *>>
+CollisionChecker::getCollisions(std::vector<PxReal> const &qpos, bool selfCollision,
+                                bool sceneCollision) const {
+  std::vector<std::pair<SActorBase *, SActorBase *>> result;
+  if (qpos.size() != mDof) {
+    spdlog::get("SAPIEN")->error("Input vector size does not match DOF of articulation");
+    return result;
+  }
+  auto links = mArticulation->getSLinks();
+  std::vector<PxTransform> poses;
+  computeLinkPoses(qpos.data(), poses);
+  forEachCollision(poses, selfCollision, sceneCollision,
+                   [&](uint32_t link, int otherLink, SActorBase *other) {
+                     result.push_back(
+                         {links[link], otherLink >= 0 ? links[otherLink] : other});
+                     return true;
+                   });
+  return result;
+}
+
+std::vector<bool> CollisionChecker::checkBatch(Eigen::Ref<const RowMatrixXf> const &qpos,
+                                               bool selfCollision, bool sceneCollision) {
+  if (qpos.cols() != mDof) {
+    spdlog::get("SAPIEN")->error("Input matrix columns do not match DOF of articulation");
+    return {};
+  }
+  if (!mThreadPool) {
+    mThreadPool = std::make_unique<utils::ThreadPool>(mNumThreads);
+  }
+  std::vector<std::vector<PxTransform>> poses(mThreadPool->size());
+  std::vector<char> colliding(qpos.rows(), 0);
+  mThreadPool->parallelFor(0, qpos.rows(), [&](size_t i, uint32_t thread) {
+    colliding[i] = isColliding(qpos.row(i).data(), poses[thread], selfCollision, sceneCollision);
+  });
+  return std::vector<bool>(colliding.begin(), colliding.end());
+}
+
+} // namespace sapien
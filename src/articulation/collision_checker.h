@@ -0,0 +1,112 @@
+#pragma once
+#include "utils/thread_pool.hpp"
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+class SActorBase;
+
+/** Collision checking of articulation configurations without stepping the scene
+ *
+ *  Link poses are computed from the joint frames of the articulation with its root at the
+ *  current root pose. Link collision shapes are tested against each other and against a
+ *  snapshot of the other shapes in the scene with PxGeometryQuery::overlap. Pairs are filtered
+ *  with the collision groups of the scene filter shader. Parent and child links and pairs
+ *  registered with ignoreLinkPair are never tested against each other.
+ *
+ *  The snapshot is taken at construction and by updateScene, call it after the scene changes.
+ *  Queries only read the checker, different configurations are checked in parallel.
+ */
+class CollisionChecker {
+public:
+  using RowMatrixXf = Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+private:
+  struct LinkShape {
+    uint32_t link;
+    PxGeometryHolder geometry;
+    PxTransform localPose;
+    PxFilterData filter;
+  };
+
+  struct SceneShape {
+    SActorBase *actor;
+    PxGeometryHolder geometry;
+    PxTransform pose;
+    PxBounds3 bounds;
+    PxFilterData filter;
+  };
+
+  SArticulation *mArticulation;
+  uint32_t mDof;
+
+  // kinematic tree indexed by link index
+  std::vector<int> mParent;
+  std::vector<uint32_t> mOrder; // topological order
+  std::vector<PxArticulationJointType::Enum> mJointType;
+  std::vector<PxTransform> mJointParentPose;
+  std::vector<PxTransform> mJointChildPoseInv;
+  std::vector<int> mQIndex; // external qpos index of the joint, -1 for fixed joints
+
+  std::vector<LinkShape> mLinkShapes;
+  std::vector<std::pair<uint32_t, uint32_t>> mSelfPairs; // shape index pairs
+  std::vector<std::pair<uint32_t, uint32_t>> mIgnoredLinkPairs;
+  std::vector<SceneShape> mSceneShapes;
+
+  std::unique_ptr<utils::ThreadPool> mThreadPool;
+  uint32_t mNumThreads;
+
+public:
+  /* throws std::runtime_error if the articulation has a joint with more than 1 DOF */
+  explicit CollisionChecker(SArticulation *articulation, uint32_t numThreads = 0);
+  CollisionChecker(CollisionChecker const &other) = delete;
+  CollisionChecker &operator=(CollisionChecker const &other) = delete;
+  ~CollisionChecker();
+
+  inline SArticulation *getArticulation() const { return mArticulation; }
+
+  /* snapshot the shapes and poses of every other actor and articulation in the scene */
+  void updateScene();
+
+  void ignoreLinkPair(uint32_t link1, uint32_t link2);
+
+  /* link poses in link index order for an external order qpos */
+  void computeLinkPoses(PxReal const *qpos, std::vector<PxTransform> &poses) const;
+
+  bool isColliding(std::vector<PxReal> const &qpos, bool selfCollision = true,
+                   bool sceneCollision = true) const;
+
+  /* non-allocating check for planners, poses is scratch space */
+  bool isColliding(PxReal const *qpos, std::vector<PxTransform> &poses, bool selfCollision,
+                   bool sceneCollision) const;
+
+  /** colliding pairs at qpos, the first actor is always a link of the articulation
+   *  Self pairs appear with both links of the articulation
+   */
+  std::vector<std::pair<SActorBase *, SActorBase *>>
+  getCollisions(std::vector<PxReal> const &qpos, bool selfCollision = true,
+                bool sceneCollision = true) const;
+
+  /** check N x dof configurations in parallel
+   *  @return for each row, whether the configuration collides
+   */
+  std::vector<bool> checkBatch(Eigen::Ref<const RowMatrixXf> const &qpos,
+                               bool selfCollision = true, bool sceneCollision = true);
+
+private:
+  void buildSelfPairs();
+  void releaseSceneShapes();
+
+  /* return false from visit to stop */
+  template <typename F>
+  void forEachCollision(std::vector<PxTransform> const &linkPoses, bool selfCollision,
+                        bool sceneCollision, F &&visit) const;
+};
+
+} // namespace sapien
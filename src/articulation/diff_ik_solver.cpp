@@ -0,0 +1,163 @@
+#include "diff_ik_solver.h"
+#include "sapien_articulation.h"
+#include "sapien_link.h"
+#include <atomic>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+DiffIKSolver::DiffIKSolver(SArticulation *articulation, std::vector<uint32_t> const &linkIds,
+                           bool spatialTwist)
+    : mArticulation(articulation), mSpatialTwist(spatialTwist) {
+  uint32_t nLinks = articulation->getBaseLinks().size();
+  for (uint32_t id : linkIds) {
+    if (id == 0 || id >= nLinks) {
+      spdlog::get("SAPIEN")->error("Invalid commanded link id {} for diff IK, ignored", id);
+      continue;
+    }
+    mLinkIds.push_back(id);
+  }
+
+  mDof = articulation->dof();
+  mRows = mLinkIds.size() * 6;
+  mCache = articulation->getPxArticulation()->createCache();
+
+  mJacobian.resize(mRows, mDof);
+  uint32_t n = std::min(mRows, mDof);
+  mNormal.resize(n, n);
+  mLLT = Eigen::LLT<Eigen::MatrixXf>(n);
+  mTmpTask.resize(mRows);
+  mTmpJoint.resize(mDof);
+  mNullspaceVel.resize(mDof);
+  mLimitCenter.resize(mDof);
+  mLimitInvRange2.resize(mDof);
+
+  updateJointLimits();
+}
+
+DiffIKSolver::~DiffIKSolver() {
+  if (mCache) {
+    mArticulation->getPxArticulation()->releaseCache(*mCache);
+  }
+}
+
+void DiffIKSolver::updateJointLimits() {
+  auto limits = mArticulation->getQlimits();
+  for (uint32_t i = 0; i < mDof; ++i) {
+    auto [low, high] = limits[i];
+    if (std::isfinite(low) && std::isfinite(high) && high > low) {
+      mLimitCenter[i] = (low + high) / 2.f;
+      mLimitInvRange2[i] = 1.f / ((high - low) * (high - low));
+    } else {
+      mLimitCenter[i] = 0.f;
+      mLimitInvRange2[i] = 0.f;
+    }
+  }
+}
+
+bool DiffIKSolver::solve(Eigen::Ref<const Eigen::VectorXf> const &target,
+                         Eigen::Ref<Eigen::VectorXf> qvel) {
+  if (target.size() != mRows || qvel.size() != mDof) {
+    spdlog::get("SAPIEN")->error("Diff IK expects a target of size {} and an output of size {}",
+                                 mRows, mDof);
+    return false;
+  }
+  qvel.setZero();
+  if (mRows == 0) {
+    return false;
+  }
+
+  auto pxArticulation = mArticulation->getPxArticulation();
+  PxU32 nRows, nCols;
+  pxArticulation->computeDenseJacobian(*mCache, nRows, nCols);
+  for (uint32_t k = 0; k < mLinkIds.size(); ++k) {
+    mArticulation->copyLinkJacobian(*mCache, mLinkIds[k], mSpatialTwist,
+                                    mJacobian.middleRows(6 * k, 6));
+  }
+
+  // secondary task: gradient descent on sum(((q - center) / range)^2)
+  bool avoidLimits = mLimitAvoidanceGain > 0.f;
+  if (avoidLimits) {
+    pxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION);
+    mArticulation->gatherFromCache(mCache->jointPosition, mNullspaceVel);
+    mNullspaceVel = -mLimitAvoidanceGain *
+                    (mNullspaceVel - mLimitCenter).cwiseProduct(mLimitInvRange2);
+  }
+
+  float damping2 = mDamping * mDamping;
+  if (mRows <= mDof) {
+    // J^T (J J^T + l^2 I)^-1
+    mNormal.noalias() = mJacobian * mJacobian.transpose();
+    mNormal.diagonal().array() += damping2;
+    mLLT.compute(mNormal);
+    if (mLLT.info() != Eigen::Success) {
+      return false;
+    }
+    mTmpTask = target;
+    if (avoidLimits) {
+      mTmpTask.noalias() -= mJacobian * mNullspaceVel;
+    }
+    mLLT.solveInPlace(mTmpTask);
+    qvel.noalias() = mJacobian.transpose() * mTmpTask;
+  } else {
+    // (J^T J + l^2 I)^-1 J^T
+    mNormal.noalias() = mJacobian.transpose() * mJacobian;
+    mNormal.diagonal().array() += damping2;
+    mLLT.compute(mNormal);
+    if (mLLT.info() != Eigen::Success) {
+      return false;
+    }
+    mTmpTask = target;
+    if (avoidLimits) {
+      mTmpTask.noalias() -= mJacobian * mNullspaceVel;
+    }
+    mTmpJoint.noalias() = mJacobian.transpose() * mTmpTask;
+    mLLT.solveInPlace(mTmpJoint);
+    qvel = mTmpJoint;
+  }
+
+  // qvel = J^+ x + (I - J^+ J) qvel0 = J^+ (x - J qvel0) + qvel0
+  if (avoidLimits) {
+    qvel += mNullspaceVel;
+  }
+  return true;
+}
+
+Eigen::VectorXf DiffIKSolver::solve(Eigen::VectorXf const &target) {
+  Eigen::VectorXf qvel(mDof);
+  solve(target, qvel);
+  return qvel;
+}
+
+bool DiffIKSolver::solveBatch(std::vector<DiffIKSolver *> const &solvers,
+                              std::vector<Eigen::VectorXf> const &targets,
+                              std::vector<Eigen::VectorXf> &qvels, utils::ThreadPool *pool) {
+  if (solvers.size() != targets.size()) {
+    spdlog::get("SAPIEN")->error("Diff IK batch has {} solvers but {} targets", solvers.size(),
+                                 targets.size());
+    return false;
+  }
+  qvels.resize(solvers.size());
+  for (size_t i = 0; i < solvers.size(); ++i) {
+    if (qvels[i].size() != solvers[i]->mDof) {
+      qvels[i].resize(solvers[i]->mDof);
+    }
+  }
+
+  std::atomic<bool> success{true};
+  auto solveOne = [&](size_t i, uint32_t) {
+    if (!solvers[i]->solve(targets[i], qvels[i])) {
+      success = false;
+    }
+  };
+  if (pool) {
+    pool->parallelFor(0, solvers.size(), solveOne);
+  } else {
+    for (size_t i = 0; i < solvers.size(); ++i) {
+      solveOne(i, 0);
+    }
+  }
+  return success;
+}
+
+} // namespace sapien
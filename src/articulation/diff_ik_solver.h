@@ -0,0 +1,84 @@
+#pragma once
+#include <Eigen/Dense>
+#include "utils/thread_pool.hpp"
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+
+/** Damped least-squares differential IK for one or more commanded links
+ *
+ *  qvel = J^T (J J^T + damping^2 I)^-1 x + (I - J^+ J) qvel0
+ *
+ *  x stacks a 6D target for every commanded link (linear first, then angular), J stacks
+ *  their Jacobians in external joint order. qvel0 pushes joints away from their limits and
+ *  is projected into the nullspace of the task. All buffers, including the PhysX cache, are
+ *  allocated once in the constructor so solve can be called every step.
+ */
+class DiffIKSolver {
+  SArticulation *mArticulation;
+  PxArticulationCache *mCache;
+
+  std::vector<uint32_t> mLinkIds;
+  uint32_t mDof;
+  uint32_t mRows;
+
+  bool mSpatialTwist;
+  PxReal mDamping{0.05f};
+  PxReal mLimitAvoidanceGain{0.f};
+
+  // workspace
+  Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> mJacobian;
+  Eigen::MatrixXf mNormal;
+  Eigen::LLT<Eigen::MatrixXf> mLLT;
+  Eigen::VectorXf mTmpTask;
+  Eigen::VectorXf mTmpJoint;
+  Eigen::VectorXf mNullspaceVel;
+  Eigen::VectorXf mLimitCenter;
+  Eigen::VectorXf mLimitInvRange2;
+
+public:
+  /** @param linkIds external indices of the commanded links, the root link is not allowed
+   *  @param spatialTwist interpret targets as spatial twists instead of Cartesian velocities
+   */
+  DiffIKSolver(SArticulation *articulation, std::vector<uint32_t> const &linkIds,
+               bool spatialTwist = true);
+  DiffIKSolver(DiffIKSolver const &other) = delete;
+  DiffIKSolver &operator=(DiffIKSolver const &other) = delete;
+  ~DiffIKSolver();
+
+  inline void setDamping(PxReal damping) { mDamping = damping; }
+  inline PxReal getDamping() const { return mDamping; }
+
+  /** gain of the secondary task pulling joints towards the middle of their limits,
+   *  0 disables it */
+  inline void setJointLimitAvoidance(PxReal gain) { mLimitAvoidanceGain = gain; }
+  inline PxReal getJointLimitAvoidance() const { return mLimitAvoidanceGain; }
+
+  /** re-read joint limits from the articulation */
+  void updateJointLimits();
+
+  inline SArticulation *getArticulation() const { return mArticulation; }
+  inline std::vector<uint32_t> const &getLinkIds() const { return mLinkIds; }
+  inline uint32_t getTaskDim() const { return mRows; }
+
+  /** solve for joint velocities, target has size 6 x number of commanded links */
+  bool solve(Eigen::Ref<const Eigen::VectorXf> const &target, Eigen::Ref<Eigen::VectorXf> qvel);
+  Eigen::VectorXf solve(Eigen::VectorXf const &target);
+
+  /** solve several articulations in one call, targets[i] is passed to solvers[i]
+   *
+   *  qvels[i] receives the result of solvers[i], it is only resized when its size does not
+   *  match, so reusing qvels across calls does not allocate. Solvers run on the pool if given,
+   *  the scene must not be stepped meanwhile.
+   *  @return false if any solve failed
+   */
+  static bool solveBatch(std::vector<DiffIKSolver *> const &solvers,
+                         std::vector<Eigen::VectorXf> const &targets,
+                         std::vector<Eigen::VectorXf> &qvels, utils::ThreadPool *pool = nullptr);
+};
+
+} // namespace sapien
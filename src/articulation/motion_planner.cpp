@@ -0,0 +1,178 @@
+#include "motion_planner.h"
+#include "sapien_articulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+MotionPlanner::MotionPlanner(SArticulation *articulation)
+    : mArticulation(articulation), mDof(articulation->dof()),
+      mChecker(std::make_unique<CollisionChecker>(articulation)) {
+  updateJointLimits();
+}
+
+void MotionPlanner::updateJointLimits() {
+  mLimits = mArticulation->getQlimits();
+  for (auto &limit : mLimits) {
+    if (!std::isfinite(limit[0]) || !std::isfinite(limit[1]) || limit[1] < limit[0]) {
+      limit = {-PxPi, PxPi};
+    }
+  }
+}
+
+bool MotionPlanner::isValid(Eigen::VectorXf const &qpos) {
+  for (uint32_t i = 0; i < mDof; ++i) {
+    if (qpos[i] < mLimits[i][0] || qpos[i] > mLimits[i][1]) {
+      return false;
+    }
+  }
+  return !mChecker->isColliding(qpos.data(), mPoseBuffer, true, true);
+}
+
+bool MotionPlanner::isEdgeValid(Eigen::VectorXf const &from, Eigen::VectorXf const &to) {
+  uint32_t steps = std::ceil((to - from).norm() / mResolution);
+  Eigen::VectorXf q(mDof);
+  for (uint32_t s = 1; s <= steps; ++s) {
+    q = from + (to - from) * (static_cast<PxReal>(s) / steps);
+    if (mChecker->isColliding(q.data(), mPoseBuffer, true, true)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Eigen::VectorXf MotionPlanner::sample() {
+  std::uniform_real_distribution<PxReal> unit(0, 1);
+  Eigen::VectorXf q(mDof);
+  for (uint32_t i = 0; i < mDof; ++i) {
+    q[i] = mLimits[i][0] + (mLimits[i][1] - mLimits[i][0]) * unit(mRandomEngine);
+  }
+  return q;
+}
+
+int MotionPlanner::nearest(Tree const &tree, Eigen::VectorXf const &q) const {
+  int best = 0;
+  PxReal bestDistance = PX_MAX_F32;
+  for (size_t i = 0; i < tree.nodes.size(); ++i) {
+    PxReal d = (tree.nodes[i] - q).squaredNorm();
+    if (d < bestDistance) {
+      bestDistance = d;
+      best = i;
+    }
+  }
+  return best;
+}
+
+MotionPlanner::ExtendResult MotionPlanner::extend(Tree &tree, Eigen::VectorXf const &q) {
+  int near = nearest(tree, q);
+  Eigen::VectorXf const &from = tree.nodes[near];
+  PxReal distance = (q - from).norm();
+  bool reached = distance <= mRange;
+  Eigen::VectorXf to = reached ? q : Eigen::VectorXf(from + (q - from) * (mRange / distance));
+  if (!isEdgeValid(from, to)) {
+    return Trapped;
+  }
+  tree.nodes.push_back(to);
+  tree.parents.push_back(near);
+  return reached ? Reached : Advanced;
+}
+
+MotionPlanner::ExtendResult MotionPlanner::connect(Tree &tree, Eigen::VectorXf const &q) {
+  ExtendResult result;
+  do {
+    result = extend(tree, q);
+  } while (result == Advanced);
+  return result;
+}
+
+void MotionPlanner::shortcut(std::vector<Eigen::VectorXf> &path, uint32_t iterations) {
+  for (uint32_t it = 0; it < iterations && path.size() > 2; ++it) {
+    std::uniform_int_distribution<size_t> pick(0, path.size() - 1);
+    size_t i = pick(mRandomEngine);
+    size_t j = pick(mRandomEngine);
+    if (i > j) {
+      std::swap(i, j);
+    }
+    if (j - i < 2) {
+      continue;
+    }
+    if (isEdgeValid(path[i], path[j])) {
+      path.erase(path.begin() + i + 1, path.begin() + j);
+    }
+  }
+}
+
+std::tuple<bool, MotionPlanner::RowMatrixXf>
+MotionPlanner::plan(Eigen::VectorXf const &start, Eigen::VectorXf const &goal,
+                    PxReal timeLimit, uint32_t maxIterations, uint32_t shortcutIterations) {
+  auto logger = spdlog::get("SAPIEN");
+  if (start.size() != mDof || goal.size() != mDof) {
+    logger->error("Failed to plan: start and goal should have {} entries", mDof);
+    return {false, RowMatrixXf(0, mDof)};
+  }
+  if (!isValid(start)) {
+    logger->warn("Failed to plan: start configuration is invalid or in collision");
+    return {false, RowMatrixXf(0, mDof)};
+  }
+  if (!isValid(goal)) {
+    logger->warn("Failed to plan: goal configuration is invalid or in collision");
+    return {false, RowMatrixXf(0, mDof)};
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<PxReal>(timeLimit));
+
+  Tree a{{start}, {-1}};
+  Tree b{{goal}, {-1}};
+  bool aIsStart = true;
+  bool found = isEdgeValid(start, goal);
+  if (found) {
+    b.nodes.push_back(start);
+    b.parents.push_back(0);
+  }
+
+  for (uint32_t it = 0; !found && it < maxIterations; ++it) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      break;
+    }
+    Eigen::VectorXf q = sample();
+    if (extend(a, q) != Trapped) {
+      if (connect(b, a.nodes.back()) == Reached) {
+        found = true;
+        break;
+      }
+    }
+    std::swap(a, b);
+    aIsStart = !aIsStart;
+  }
+
+  if (!found) {
+    return {false, RowMatrixXf(0, mDof)};
+  }
+
+  // the last nodes of both trees coincide, make a the start tree
+  if (!aIsStart) {
+    std::swap(a, b);
+  }
+  std::vector<Eigen::VectorXf> path;
+  for (int i = a.nodes.size() - 1; i >= 0; i = a.parents[i]) {
+    path.push_back(a.nodes[i]);
+  }
+  std::reverse(path.begin(), path.end());
+  for (int i = b.parents[b.nodes.size() - 1]; i >= 0; i = b.parents[i]) {
+    path.push_back(b.nodes[i]);
+  }
+
+  shortcut(path, shortcutIterations);
+
+  RowMatrixXf result(path.size(), mDof);
+  for (size_t i = 0; i < path.size(); ++i) {
+    result.row(i) = path[i].transpose();
+  }
+  return {true, result};
+}
+
+} // namespace sapien
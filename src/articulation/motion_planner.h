@@ -0,0 +1,81 @@
+#pragma once
+#include "collision_checker.h"
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <array>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+
+/** Joint space RRT-Connect planner with shortcut smoothing
+ *
+ *  Configurations are checked against the articulation itself and the scene snapshot of its
+ *  CollisionChecker; call getCollisionChecker()->updateScene() after the scene changes. Joints
+ *  without finite limits are sampled in [-pi, pi].
+ */
+class MotionPlanner {
+public:
+  using RowMatrixXf = Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+private:
+  SArticulation *mArticulation;
+  uint32_t mDof;
+  std::unique_ptr<CollisionChecker> mChecker;
+  std::vector<std::array<PxReal, 2>> mLimits;
+
+  PxReal mRange{0.5f};       // maximum joint space extension of one tree step
+  PxReal mResolution{0.02f}; // joint space distance between checked points of an edge
+  std::mt19937 mRandomEngine;
+
+  std::vector<PxTransform> mPoseBuffer;
+
+  struct Tree {
+    std::vector<Eigen::VectorXf> nodes;
+    std::vector<int> parents;
+  };
+  enum ExtendResult { Trapped, Advanced, Reached };
+
+public:
+  explicit MotionPlanner(SArticulation *articulation);
+  MotionPlanner(MotionPlanner const &other) = delete;
+  MotionPlanner &operator=(MotionPlanner const &other) = delete;
+
+  inline CollisionChecker *getCollisionChecker() const { return mChecker.get(); }
+
+  inline void setRange(PxReal range) { mRange = range; }
+  inline PxReal getRange() const { return mRange; }
+  inline void setResolution(PxReal resolution) { mResolution = resolution; }
+  inline PxReal getResolution() const { return mResolution; }
+  inline void setRandomSeed(uint32_t seed) { mRandomEngine.seed(seed); }
+
+  /* refresh joint limits from the articulation */
+  void updateJointLimits();
+
+  bool isValid(Eigen::VectorXf const &qpos);
+  bool isEdgeValid(Eigen::VectorXf const &from, Eigen::VectorXf const &to);
+
+  /** Plan a collision free path
+   *
+   *  @param timeLimit seconds before giving up
+   *  @param shortcutIterations random shortcut attempts on the found path
+   *  @return success and the waypoints, one per row, from start to goal
+   */
+  std::tuple<bool, RowMatrixXf> plan(Eigen::VectorXf const &start, Eigen::VectorXf const &goal,
+                                     PxReal timeLimit = 1.f, uint32_t maxIterations = 10000,
+                                     uint32_t shortcutIterations = 100);
+
+private:
+  Eigen::VectorXf sample();
+  int nearest(Tree const &tree, Eigen::VectorXf const &q) const;
+  ExtendResult extend(Tree &tree, Eigen::VectorXf const &q);
+  ExtendResult connect(Tree &tree, Eigen::VectorXf const &q);
+  void shortcut(std::vector<Eigen::VectorXf> &path, uint32_t iterations);
+};
+
+} // namespace sapien
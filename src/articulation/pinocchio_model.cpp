@@ -1,9 +1,20 @@
 #ifdef _USE_PINOCCHIO
 #include "pinocchio_model.h"
+#include "sapien_articulation_base.h"
+#include "sapien_joint.h"
+#include "sapien_link.h"
+#include <pinocchio/algorithm/aba-derivatives.hpp>
 #include <pinocchio/algorithm/aba.hpp>
 #include <pinocchio/algorithm/crba.hpp>
+#include <pinocchio/algorithm/frames-derivatives.hpp>
 #include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics-derivatives.hpp>
+#include <pinocchio/algorithm/rnea-derivatives.hpp>
 #include <pinocchio/algorithm/rnea.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
 
 #define ASSERT(exp, info)                                                                         \
   if (!(exp)) {                                                                                   \
@@ -21,7 +32,138 @@ std::unique_ptr<PinocchioModel> PinocchioModel::fromURDFXML(std::string const &u
   return m;
 }
 
-Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) {
+std::unique_ptr<PinocchioModel>
+PinocchioModel::fromArticulation(SArticulationBase &articulation, Eigen::Vector3d gravity) {
+  auto m = std::unique_ptr<PinocchioModel>(new PinocchioModel);
+  auto &model = m->model;
+  model.gravity = {gravity, Eigen::Vector3d{0, 0, 0}};
+
+  auto links = articulation.getBaseLinks();
+  auto joints = articulation.getBaseJoints();
+  std::unordered_map<SLinkBase *, uint32_t> linkPosition;
+  for (uint32_t i = 0; i < links.size(); ++i) {
+    linkPosition[links[i]] = i;
+  }
+  std::vector<std::vector<SJointBase *>> children(links.size());
+  SJointBase *rootJoint = nullptr;
+  for (auto j : joints) {
+    if (j->getParentLink()) {
+      children[linkPosition.at(j->getParentLink())].push_back(j);
+    } else {
+      rootJoint = j;
+    }
+  }
+  ASSERT(rootJoint, "articulation has no root joint");
+
+  auto toSE3 = [](PxTransform const &pose) {
+    return pinocchio::SE3(
+        Eigen::Quaterniond(pose.q.w, pose.q.x, pose.q.y, pose.q.z).toRotationMatrix(),
+        Eigen::Vector3d(pose.p.x, pose.p.y, pose.p.z));
+  };
+
+  // for every link, the Pinocchio joint it is attached to and its placement in that joint
+  std::vector<pinocchio::JointIndex> linkJoint(links.size(), 0);
+  std::vector<pinocchio::SE3> linkPlacement(links.size(), pinocchio::SE3::Identity());
+  std::vector<int> linkFrame(links.size(), -1);
+  std::vector<pinocchio::JointIndex> jointIndex(links.size(), 0);
+
+  auto addLink = [&](SLinkBase *link, int previousFrame) {
+    uint32_t i = linkPosition.at(link);
+    PxTransform cmass = link->getCMassLocalPose();
+    PxVec3 inertia = link->getInertia();
+    Eigen::Matrix3d R =
+        Eigen::Quaterniond(cmass.q.w, cmass.q.x, cmass.q.y, cmass.q.z).toRotationMatrix();
+    Eigen::Matrix3d I = R * Eigen::Vector3d(inertia.x, inertia.y, inertia.z).asDiagonal() *
+                        R.transpose();
+    pinocchio::Inertia Y(link->getMass(), Eigen::Vector3d(cmass.p.x, cmass.p.y, cmass.p.z), I);
+    model.appendBodyToJoint(linkJoint[i], Y, linkPlacement[i]);
+    linkFrame[i] = model.addBodyFrame("link_" + std::to_string(link->getIndex()), linkJoint[i],
+                                      linkPlacement[i], previousFrame);
+  };
+
+  // depth first from the root, parents must be added before children
+  addLink(rootJoint->getChildLink(), 0);
+  std::vector<SLinkBase *> stack{rootJoint->getChildLink()};
+  while (!stack.empty()) {
+    SLinkBase *parent = stack.back();
+    stack.pop_back();
+    uint32_t p = linkPosition.at(parent);
+    // reversed so children are visited in joint order
+    for (auto it = children[p].rbegin(); it != children[p].rend(); ++it) {
+      SJointBase *joint = *it;
+      SLinkBase *child = joint->getChildLink();
+      uint32_t c = linkPosition.at(child);
+      pinocchio::SE3 j2p = linkPlacement[p] * toSE3(joint->getParentPose());
+      pinocchio::SE3 c2j = toSE3(joint->getChildPose().getInverse());
+      std::string name = "joint_" + std::to_string(child->getIndex());
+
+      if (joint->getType() == PxArticulationJointType::eFIX) {
+        linkJoint[c] = linkJoint[p];
+        linkPlacement[c] = j2p * c2j;
+        addLink(child, linkFrame[p]);
+        stack.push_back(child);
+        continue;
+      }
+
+      auto limits = joint->getLimits();
+      Eigen::VectorXd effort = Eigen::VectorXd::Constant(1, std::numeric_limits<double>::max());
+      Eigen::VectorXd velocity = effort;
+      pinocchio::JointIndex id;
+      if (joint->getType() == PxArticulationJointType::ePRISMATIC) {
+        id = model.addJoint(linkJoint[p], pinocchio::JointModelPX(), j2p, name, effort, velocity,
+                            Eigen::VectorXd::Constant(1, limits[0][0]),
+                            Eigen::VectorXd::Constant(1, limits[0][1]));
+      } else if (joint->getType() == PxArticulationJointType::eREVOLUTE) {
+        // same rule as exportKinematicsChainAsURDF for continuous joints
+        if (limits[0][0] < -10) {
+          id = model.addJoint(linkJoint[p], pinocchio::JointModelRUBX(), j2p, name, effort,
+                              velocity, Eigen::VectorXd::Constant(2, -1.01),
+                              Eigen::VectorXd::Constant(2, 1.01));
+        } else {
+          id = model.addJoint(linkJoint[p], pinocchio::JointModelRX(), j2p, name, effort,
+                              velocity, Eigen::VectorXd::Constant(1, limits[0][0]),
+                              Eigen::VectorXd::Constant(1, limits[0][1]));
+        }
+      } else {
+        throw std::runtime_error("unknown joint type");
+      }
+      int jointFrame = model.addJointFrame(id, linkFrame[p]);
+      jointIndex[c] = id;
+      linkJoint[c] = id;
+      linkPlacement[c] = c2j;
+      addLink(child, jointFrame);
+      stack.push_back(child);
+    }
+  }
+
+  m->data = pinocchio::Data(model);
+
+  std::vector<pinocchio::JointIndex> order;
+  for (auto j : joints) {
+    if (j->getDof() > 0) {
+      order.push_back(jointIndex[linkPosition.at(j->getChildLink())]);
+    }
+  }
+  m->setJointIndices(order);
+  m->linkIdx2FrameIdx = linkFrame;
+  return m;
+}
+
+std::unique_ptr<PinocchioModel> PinocchioModel::clone() const {
+  auto m = std::unique_ptr<PinocchioModel>(new PinocchioModel);
+  m->model = model;
+  m->data = pinocchio::Data(model);
+  m->indexS2P = indexS2P;
+  m->QIDX = QIDX;
+  m->NQ = NQ;
+  m->NV = NV;
+  m->linkIdx2FrameIdx = linkIdx2FrameIdx;
+  m->mNumThreads = mNumThreads;
+  m->mRandomEngine = mRandomEngine;
+  return m;
+}
+
+Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) const {
   Eigen::VectorXd qint(model.nq);
   uint32_t count = 0;
   for (size_t N = 0; N < QIDX.size(); ++N) {
@@ -46,7 +188,7 @@ Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) {
   return qint;
 }
 
-Eigen::VectorXd PinocchioModel::posP2S(const Eigen::VectorXd &qint) {
+Eigen::VectorXd PinocchioModel::posP2S(const Eigen::VectorXd &qint) const {
   Eigen::VectorXd qext(model.nv);
 
   uint32_t count = 0;
@@ -72,13 +214,21 @@ Eigen::VectorXd PinocchioModel::posP2S(const Eigen::VectorXd &qint) {
 }
 
 void PinocchioModel::setJointOrder(std::vector<std::string> names) {
-  Eigen::VectorXi v(model.nv);
-  size_t count = 0;
+  std::vector<pinocchio::JointIndex> joints;
   for (auto &name : names) {
     auto i = model.getJointId(name);
     if (i == model.njoints) {
       throw std::invalid_argument("invalid names in setJointOrder");
     }
+    joints.push_back(i);
+  }
+  setJointIndices(joints);
+}
+
+void PinocchioModel::setJointIndices(std::vector<pinocchio::JointIndex> const &joints) {
+  Eigen::VectorXi v(model.nv);
+  size_t count = 0;
+  for (auto i : joints) {
     auto size = model.nvs[i];
     auto qi = model.idx_vs[i];
     for (int s = 0; s < size; ++s) {
@@ -88,17 +238,13 @@ void PinocchioModel::setJointOrder(std::vector<std::string> names) {
   ASSERT(count == model.nv, "setJointOrder failed");
   indexS2P = Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic>(v);
 
-  QIDX = Eigen::VectorXi(names.size());
-  NQ = Eigen::VectorXi(names.size());
-  NV = Eigen::VectorXi(names.size());
-  for (size_t N = 0; N < names.size(); ++N) {
-    auto i = model.getJointId(names[N]);
-    if (i == model.njoints) {
-      throw std::invalid_argument("invalid names in setJointOrder");
-    }
-    NQ[N] = model.nqs[i];
-    NV[N] = model.nvs[i];
-    QIDX[N] = model.idx_qs[i];
+  QIDX = Eigen::VectorXi(joints.size());
+  NQ = Eigen::VectorXi(joints.size());
+  NV = Eigen::VectorXi(joints.size());
+  for (size_t N = 0; N < joints.size(); ++N) {
+    NQ[N] = model.nqs[joints[N]];
+    NV[N] = model.nvs[joints[N]];
+    QIDX[N] = model.idx_qs[joints[N]];
   }
 }
 
@@ -122,14 +268,16 @@ void PinocchioModel::computeForwardKinematics(const Eigen::VectorXd &qpos) {
   pinocchio::forwardKinematics(model, data, posS2P(qpos));
 }
 
-physx::PxTransform PinocchioModel::getLinkPose(uint32_t index) {
-  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+pinocchio::SE3 PinocchioModel::linkPose(pinocchio::Data const &d, uint32_t index) const {
   auto frame = linkIdx2FrameIdx[index];
   auto parentJoint = model.frames[frame].parent;
   auto link2joint = model.frames[frame].placement;
-  auto joint2world = data.oMi[parentJoint];
+  return d.oMi[parentJoint] * link2joint;
+}
 
-  auto link2world = joint2world * link2joint;
+physx::PxTransform PinocchioModel::getLinkPose(uint32_t index) {
+  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto link2world = linkPose(data, index);
   auto P = link2world.translation();
   auto Q = Eigen::Quaterniond(link2world.rotation());
   return {physx::PxVec3(P.x(), P.y(), P.z()), physx::PxQuat(Q.x(), Q.y(), Q.z(), Q.w())};
@@ -139,25 +287,84 @@ void PinocchioModel::computeFullJacobian(const Eigen::VectorXd &qpos) {
   pinocchio::computeJointJacobians(model, data, posS2P(qpos));
 }
 
+template <typename Out>
+void PinocchioModel::linkJacobian(pinocchio::Data const &d, uint32_t index, bool local,
+                                  pinocchio::Data::Matrix6x &J,
+                                  Eigen::MatrixBase<Out> const &out) const {
+  auto &result = const_cast<Eigen::MatrixBase<Out> &>(out);
+  auto jointIdx = model.frames[linkIdx2FrameIdx[index]].parent;
+  J.setZero();
+  pinocchio::getJointJacobian(model, d, jointIdx, pinocchio::ReferenceFrame::WORLD, J);
+  // permute Jacobin to SAPIEN format
+  if (local) {
+    result = (linkPose(d, index).toActionMatrixInverse() * J) * indexS2P;
+  } else {
+    result = J * indexS2P;
+  }
+}
+
 Eigen::Matrix<double, 6, Eigen::Dynamic> PinocchioModel::getLinkJacobian(uint32_t index,
                                                                          bool local) {
   ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
-  auto frameIdx = linkIdx2FrameIdx[index];
-  auto jointIdx = model.frames[frameIdx].parent;
-
-  auto link2joint = model.frames[frameIdx].placement;
-  auto joint2world = data.oMi[jointIdx];
-  auto link2world = joint2world * link2joint;
+  pinocchio::Data::Matrix6x J(6, model.nv);
+  Eigen::MatrixXd result(6, model.nv);
+  linkJacobian(data, index, local, J, result);
+  return result;
+}
 
-  Eigen::Matrix<double, 6, Eigen::Dynamic> J(6, model.nv);
-  J.fill(0);
+void PinocchioModel::setNumThreads(uint32_t n) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  mNumThreads = n;
+  mThreadPool.reset();
+  mThreadData.clear();
+  mThreadJacobians.clear();
+}
 
-  pinocchio::getJointJacobian(model, data, jointIdx, pinocchio::ReferenceFrame::WORLD, J);
-  if (local) {
-    J = link2world.toActionMatrixInverse() * J;
+void PinocchioModel::prepareThreads() {
+  if (mThreadPool) {
+    return;
   }
-  // permute Jacobin to SAPIEN format
-  return J * indexS2P;
+  mThreadPool = std::make_unique<utils::ThreadPool>(mNumThreads);
+  mThreadData.assign(mThreadPool->size(), pinocchio::Data(model));
+  mThreadJacobians.assign(mThreadPool->size(), pinocchio::Data::Matrix6x(6, model.nv));
+}
+
+void PinocchioModel::computeForwardKinematicsBatch(Eigen::Ref<const RowMatrixXd> const &qpos,
+                                                   Eigen::Ref<RowMatrixXd> poses) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  uint32_t nLinks = linkIdx2FrameIdx.size();
+  ASSERT(qpos.cols() == model.nv, "qpos batch should have dof columns");
+  ASSERT(poses.rows() == qpos.rows() && poses.cols() == 7 * nLinks,
+         "poses batch should be N x (7 * number of links)");
+  prepareThreads();
+  mThreadPool->parallelFor(0, qpos.rows(), [&](size_t i, uint32_t thread) {
+    auto &d = mThreadData[thread];
+    pinocchio::forwardKinematics(model, d, posS2P(qpos.row(i).transpose()));
+    for (uint32_t l = 0; l < nLinks; ++l) {
+      auto link2world = linkPose(d, l);
+      auto P = link2world.translation();
+      auto Q = Eigen::Quaterniond(link2world.rotation());
+      poses.block<1, 7>(i, 7 * l) << P.x(), P.y(), P.z(), Q.w(), Q.x(), Q.y(), Q.z();
+    }
+  });
+}
+
+void PinocchioModel::computeFullJacobianBatch(Eigen::Ref<const RowMatrixXd> const &qpos,
+                                              Eigen::Ref<RowMatrixXd> jacobians, bool local) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  uint32_t nLinks = linkIdx2FrameIdx.size();
+  ASSERT(qpos.cols() == model.nv, "qpos batch should have dof columns");
+  ASSERT(jacobians.rows() == qpos.rows() * nLinks * 6 && jacobians.cols() == model.nv,
+         "jacobians batch should be (N * number of links * 6) x dof");
+  prepareThreads();
+  mThreadPool->parallelFor(0, qpos.rows(), [&](size_t i, uint32_t thread) {
+    auto &d = mThreadData[thread];
+    pinocchio::computeJointJacobians(model, d, posS2P(qpos.row(i).transpose()));
+    for (uint32_t l = 0; l < nLinks; ++l) {
+      linkJacobian(d, l, local, mThreadJacobians[thread],
+                   jacobians.block(((i * nLinks) + l) * 6, 0, 6, model.nv));
+    }
+  });
 }
 
 Eigen::Matrix<double, 6, Eigen::Dynamic>
@@ -200,49 +407,414 @@ Eigen::VectorXd PinocchioModel::computeForwardDynamics(const Eigen::VectorXd &qp
          pinocchio::aba(model, data, posS2P(qpos), indexS2P * qvel, indexS2P * qf);
 }
 
-std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
-PinocchioModel::computeInverseKinematics(uint32_t linkIdx, physx::PxTransform const &pose,
-                                         double eps, int maxIter, double dt, double damp) {
-  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+template <typename Out>
+void PinocchioModel::inverseDynamicsDerivatives(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                                Eigen::VectorXd const &qvel,
+                                                Eigen::VectorXd const &qacc,
+                                                Eigen::MatrixBase<Out> const &dqpos,
+                                                Eigen::MatrixBase<Out> const &dqvel,
+                                                Eigen::MatrixBase<Out> const &dqacc) const {
+  pinocchio::computeRNEADerivatives(model, d, posS2P(qpos), indexS2P * qvel, indexS2P * qacc);
+  // only the upper triangular part of M is filled
+  d.M.triangularView<Eigen::StrictlyLower>() =
+      d.M.transpose().triangularView<Eigen::StrictlyLower>();
+  const_cast<Eigen::MatrixBase<Out> &>(dqpos) = indexS2P.transpose() * d.dtau_dq * indexS2P;
+  const_cast<Eigen::MatrixBase<Out> &>(dqvel) = indexS2P.transpose() * d.dtau_dv * indexS2P;
+  const_cast<Eigen::MatrixBase<Out> &>(dqacc) = indexS2P.transpose() * d.M * indexS2P;
+}
+
+template <typename Out>
+void PinocchioModel::forwardDynamicsDerivatives(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                                Eigen::VectorXd const &qvel,
+                                                Eigen::VectorXd const &qf,
+                                                Eigen::MatrixBase<Out> const &dqpos,
+                                                Eigen::MatrixBase<Out> const &dqvel,
+                                                Eigen::MatrixBase<Out> const &dqf) const {
+  pinocchio::computeABADerivatives(model, d, posS2P(qpos), indexS2P * qvel, indexS2P * qf);
+  // only the upper triangular part of Minv is filled
+  d.Minv.triangularView<Eigen::StrictlyLower>() =
+      d.Minv.transpose().triangularView<Eigen::StrictlyLower>();
+  const_cast<Eigen::MatrixBase<Out> &>(dqpos) = indexS2P.transpose() * d.ddq_dq * indexS2P;
+  const_cast<Eigen::MatrixBase<Out> &>(dqvel) = indexS2P.transpose() * d.ddq_dv * indexS2P;
+  const_cast<Eigen::MatrixBase<Out> &>(dqf) = indexS2P.transpose() * d.Minv * indexS2P;
+}
+
+std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+PinocchioModel::computeInverseDynamicsDerivatives(const Eigen::VectorXd &qpos,
+                                                  const Eigen::VectorXd &qvel,
+                                                  const Eigen::VectorXd &qacc) {
+  Eigen::MatrixXd dqpos(model.nv, model.nv), dqvel(model.nv, model.nv), dqacc(model.nv, model.nv);
+  inverseDynamicsDerivatives(data, qpos, qvel, qacc, dqpos, dqvel, dqacc);
+  return {dqpos, dqvel, dqacc};
+}
+
+std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+PinocchioModel::computeForwardDynamicsDerivatives(const Eigen::VectorXd &qpos,
+                                                  const Eigen::VectorXd &qvel,
+                                                  const Eigen::VectorXd &qf) {
+  Eigen::MatrixXd dqpos(model.nv, model.nv), dqvel(model.nv, model.nv), dqf(model.nv, model.nv);
+  forwardDynamicsDerivatives(data, qpos, qvel, qf, dqpos, dqvel, dqf);
+  return {dqpos, dqvel, dqf};
+}
+
+std::tuple<Eigen::Matrix<double, 6, Eigen::Dynamic>, Eigen::Matrix<double, 6, Eigen::Dynamic>>
+PinocchioModel::computeLinkVelocityDerivatives(uint32_t index, const Eigen::VectorXd &qpos,
+                                               const Eigen::VectorXd &qvel, bool local) {
+  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+  pinocchio::computeForwardKinematicsDerivatives(model, data, posS2P(qpos), indexS2P * qvel,
+                                                 Eigen::VectorXd::Zero(model.nv));
+  pinocchio::Data::Matrix6x dvdq = pinocchio::Data::Matrix6x::Zero(6, model.nv);
+  pinocchio::Data::Matrix6x dvdv = pinocchio::Data::Matrix6x::Zero(6, model.nv);
+  pinocchio::getFrameVelocityDerivatives(
+      model, data, linkIdx2FrameIdx[index],
+      local ? pinocchio::ReferenceFrame::LOCAL : pinocchio::ReferenceFrame::WORLD, dvdq, dvdv);
+  return {dvdq * indexS2P, dvdv * indexS2P};
+}
+
+void PinocchioModel::computeInverseDynamicsDerivativesBatch(
+    Eigen::Ref<const RowMatrixXd> const &qpos, Eigen::Ref<const RowMatrixXd> const &qvel,
+    Eigen::Ref<const RowMatrixXd> const &qacc, Eigen::Ref<RowMatrixXd> dqpos,
+    Eigen::Ref<RowMatrixXd> dqvel, Eigen::Ref<RowMatrixXd> dqacc) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  int dof = model.nv;
+  auto n = qpos.rows();
+  ASSERT(qpos.cols() == dof && qvel.rows() == n && qvel.cols() == dof && qacc.rows() == n &&
+             qacc.cols() == dof,
+         "qpos, qvel and qacc batches should be N x dof");
+  ASSERT(dqpos.rows() == n * dof && dqpos.cols() == dof && dqvel.rows() == n * dof &&
+             dqvel.cols() == dof && dqacc.rows() == n * dof && dqacc.cols() == dof,
+         "derivative batches should be (N * dof) x dof");
+  prepareThreads();
+  mThreadPool->parallelFor(0, n, [&](size_t i, uint32_t thread) {
+    inverseDynamicsDerivatives(mThreadData[thread], qpos.row(i).transpose(),
+                               qvel.row(i).transpose(), qacc.row(i).transpose(),
+                               dqpos.block(i * dof, 0, dof, dof),
+                               dqvel.block(i * dof, 0, dof, dof),
+                               dqacc.block(i * dof, 0, dof, dof));
+  });
+}
+
+void PinocchioModel::computeForwardDynamicsDerivativesBatch(
+    Eigen::Ref<const RowMatrixXd> const &qpos, Eigen::Ref<const RowMatrixXd> const &qvel,
+    Eigen::Ref<const RowMatrixXd> const &qf, Eigen::Ref<RowMatrixXd> dqpos,
+    Eigen::Ref<RowMatrixXd> dqvel, Eigen::Ref<RowMatrixXd> dqf) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  int dof = model.nv;
+  auto n = qpos.rows();
+  ASSERT(qpos.cols() == dof && qvel.rows() == n && qvel.cols() == dof && qf.rows() == n &&
+             qf.cols() == dof,
+         "qpos, qvel and qf batches should be N x dof");
+  ASSERT(dqpos.rows() == n * dof && dqpos.cols() == dof && dqvel.rows() == n * dof &&
+             dqvel.cols() == dof && dqf.rows() == n * dof && dqf.cols() == dof,
+         "derivative batches should be (N * dof) x dof");
+  prepareThreads();
+  mThreadPool->parallelFor(0, n, [&](size_t i, uint32_t thread) {
+    forwardDynamicsDerivatives(mThreadData[thread], qpos.row(i).transpose(),
+                               qvel.row(i).transpose(), qf.row(i).transpose(),
+                               dqpos.block(i * dof, 0, dof, dof),
+                               dqvel.block(i * dof, 0, dof, dof),
+                               dqf.block(i * dof, 0, dof, dof));
+  });
+}
+
+pinocchio::SE3 PinocchioModel::jointTarget(uint32_t linkIdx,
+                                           physx::PxTransform const &pose) const {
   auto frameIdx = linkIdx2FrameIdx[linkIdx];
-  auto jointIdx = model.frames[frameIdx].parent;
   pinocchio::SE3 l2w;
   l2w.translation({pose.p.x, pose.p.y, pose.p.z});
   l2w.rotation(Eigen::Quaterniond(pose.q.w, pose.q.x, pose.q.y, pose.q.z).toRotationMatrix());
   auto l2j = model.frames[frameIdx].placement;
-  pinocchio::SE3 oMdes = l2w * l2j.inverse();
+  return l2w * l2j.inverse();
+}
 
+Eigen::VectorXd PinocchioModel::sampleConfiguration() {
   Eigen::VectorXd q = pinocchio::neutral(model);
+  std::uniform_real_distribution<double> unit(0, 1);
+  for (int j = 1; j < model.njoints; ++j) {
+    int idx = model.idx_qs[j];
+    switch (model.nqs[j]) {
+    case 1: {
+      double lower = model.lowerPositionLimit[idx];
+      double upper = model.upperPositionLimit[idx];
+      if (!std::isfinite(lower) || !std::isfinite(upper) || upper < lower) {
+        lower = -M_PI;
+        upper = M_PI;
+      }
+      q[idx] = lower + (upper - lower) * unit(mRandomEngine);
+      break;
+    }
+    case 2: {
+      double angle = -M_PI + 2 * M_PI * unit(mRandomEngine);
+      q[idx] = std::cos(angle);
+      q[idx + 1] = std::sin(angle);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return q;
+}
 
+bool PinocchioModel::clik(pinocchio::Data &d, uint32_t jointIdx, pinocchio::SE3 const &oMdes,
+                          Eigen::VectorXd &q, Eigen::Matrix<double, 6, 1> &err, double eps,
+                          int maxIter, double dt, double damp, bool clampLimits,
+                          std::atomic<bool> const *cancel) const {
   pinocchio::Data::Matrix6x J(6, model.nv);
   J.setZero();
-  bool success = false;
-  typedef Eigen::Matrix<double, 6, 1> Vector6d;
-  Vector6d err;
   Eigen::VectorXd v(model.nv);
 
   for (int i = 0;; i++) {
-    pinocchio::forwardKinematics(model, data, q);
-    const pinocchio::SE3 dMi = oMdes.actInv(data.oMi[jointIdx]);
+    pinocchio::forwardKinematics(model, d, q);
+    const pinocchio::SE3 dMi = oMdes.actInv(d.oMi[jointIdx]);
     err = pinocchio::log6(dMi).toVector();
     if (err.norm() < eps) {
-      success = true;
-      break;
+      return true;
     }
-    if (i >= maxIter) {
-      success = false;
-      break;
+    if (i >= maxIter || (cancel && cancel->load(std::memory_order_relaxed))) {
+      return false;
     }
-    pinocchio::computeJointJacobian(model, data, q, jointIdx, J);
+    pinocchio::computeJointJacobian(model, d, q, jointIdx, J);
     pinocchio::Data::Matrix6 JJt;
     JJt.noalias() = J * J.transpose();
     JJt.diagonal().array() += damp;
     v.noalias() = -J.transpose() * JJt.ldlt().solve(err);
     q = pinocchio::integrate(model, q, v * dt);
+    if (clampLimits) {
+      for (int j = 1; j < model.njoints; ++j) {
+        if (model.nqs[j] == 1) {
+          int idx = model.idx_qs[j];
+          q[idx] = std::clamp(q[idx], model.lowerPositionLimit[idx],
+                              model.upperPositionLimit[idx]);
+        }
+      }
+    }
   }
+}
+
+std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
+PinocchioModel::computeInverseKinematics(uint32_t linkIdx, physx::PxTransform const &pose,
+                                         double eps, int maxIter, double dt, double damp) {
+  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto jointIdx = model.frames[linkIdx2FrameIdx[linkIdx]].parent;
+  Eigen::VectorXd q = pinocchio::neutral(model);
+  Eigen::Matrix<double, 6, 1> err;
+  bool success = clik(data, jointIdx, jointTarget(linkIdx, pose), q, err, eps, maxIter, dt, damp,
+                      false);
   return {posP2S(q), success, err};
 }
 
+std::vector<Eigen::VectorXd> PinocchioModel::makeSeeds(RowMatrixXd const &initQpos,
+                                                       uint32_t numRandom) {
+  ASSERT(initQpos.size() == 0 || initQpos.cols() == model.nv,
+         "initial qpos should have dof columns");
+  std::vector<Eigen::VectorXd> seeds;
+  seeds.reserve(initQpos.rows() + numRandom);
+  for (Eigen::Index i = 0; i < initQpos.rows(); ++i) {
+    seeds.push_back(posS2P(initQpos.row(i).transpose()));
+  }
+  for (uint32_t i = 0; i < numRandom; ++i) {
+    seeds.push_back(sampleConfiguration());
+  }
+  if (seeds.empty()) {
+    seeds.push_back(pinocchio::neutral(model));
+  }
+  return seeds;
+}
+
+std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
+PinocchioModel::computeInverseKinematicsMultiStart(uint32_t linkIdx,
+                                                   physx::PxTransform const &pose,
+                                                   RowMatrixXd const &initQpos,
+                                                   uint32_t numRandomStarts, double eps,
+                                                   int maxIter, double dt, double damp) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto jointIdx = model.frames[linkIdx2FrameIdx[linkIdx]].parent;
+  auto oMdes = jointTarget(linkIdx, pose);
+  auto seeds = makeSeeds(initQpos, numRandomStarts);
+
+  std::vector<Eigen::Matrix<double, 6, 1>> errors(seeds.size());
+  std::vector<char> successes(seeds.size(), 0);
+  std::atomic<bool> found{false};
+
+  prepareThreads();
+  mThreadPool->parallelFor(0, seeds.size(), [&](size_t i, uint32_t thread) {
+    if (found.load(std::memory_order_relaxed)) {
+      errors[i].setConstant(std::numeric_limits<double>::infinity());
+      return;
+    }
+    successes[i] = clik(mThreadData[thread], jointIdx, oMdes, seeds[i], errors[i], eps, maxIter,
+                        dt, damp, true, &found);
+    if (successes[i]) {
+      found = true;
+    }
+  });
+
+  size_t best = 0;
+  for (size_t i = 0; i < seeds.size(); ++i) {
+    if (successes[i]) {
+      best = i;
+      break;
+    }
+    if (errors[i].norm() < errors[best].norm()) {
+      best = i;
+    }
+  }
+  return {posP2S(seeds[best]), successes[best], errors[best]};
+}
+
+std::tuple<PinocchioModel::RowMatrixXd, std::vector<bool>,
+           Eigen::Matrix<double, Eigen::Dynamic, 6>>
+PinocchioModel::computeInverseKinematicsBatch(uint32_t linkIdx,
+                                              std::vector<physx::PxTransform> const &poses,
+                                              RowMatrixXd const &initQpos,
+                                              uint32_t numRandomStarts, double eps, int maxIter,
+                                              double dt, double damp) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto jointIdx = model.frames[linkIdx2FrameIdx[linkIdx]].parent;
+  size_t n = poses.size();
+
+  // draw every random start up front, the random engine is not shared between threads
+  std::vector<std::vector<Eigen::VectorXd>> seeds(n);
+  for (size_t i = 0; i < n; ++i) {
+    seeds[i] = makeSeeds(initQpos, numRandomStarts);
+  }
+
+  RowMatrixXd result(n, model.nv);
+  std::vector<char> successes(n, 0);
+  Eigen::Matrix<double, Eigen::Dynamic, 6> errors(n, 6);
+
+  prepareThreads();
+  mThreadPool->parallelFor(0, n, [&](size_t i, uint32_t thread) {
+    auto oMdes = jointTarget(linkIdx, poses[i]);
+    Eigen::Matrix<double, 6, 1> err;
+    size_t best = 0;
+    double bestError = std::numeric_limits<double>::infinity();
+    for (size_t s = 0; s < seeds[i].size(); ++s) {
+      bool success = clik(mThreadData[thread], jointIdx, oMdes, seeds[i][s], err, eps, maxIter,
+                          dt, damp, true);
+      if (success || err.norm() < bestError) {
+        best = s;
+        bestError = err.norm();
+        errors.row(i) = err.transpose();
+      }
+      if (success) {
+        successes[i] = 1;
+        break;
+      }
+    }
+    result.row(i) = posP2S(seeds[i][best]).transpose();
+  });
+
+  return {result, std::vector<bool>(successes.begin(), successes.end()), errors};
+}
+
+Eigen::VectorXd PinocchioModel::forwardDynamics(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                                Eigen::VectorXd const &qvel,
+                                                Eigen::VectorXd const &qf) const {
+  return indexS2P.transpose() *
+         pinocchio::aba(model, d, posS2P(qpos), indexS2P * qvel, indexS2P * qf);
+}
+
+template <typename Policy>
+void PinocchioModel::rollout(Eigen::Ref<const RowMatrixXd> const &qpos,
+                             Eigen::Ref<const RowMatrixXd> const &qvel, uint32_t horizon,
+                             double timestep, Integrator integrator, Policy const &policy,
+                             Eigen::Ref<RowMatrixXd> qposOut, Eigen::Ref<RowMatrixXd> qvelOut) {
+  std::lock_guard<std::mutex> lock(mThreadMutex);
+  int dof = model.nv;
+  ASSERT(qpos.cols() == dof && qvel.cols() == dof && qvel.rows() == qpos.rows(),
+         "initial qpos and qvel should be B x dof");
+  ASSERT(qposOut.rows() == qpos.rows() && qposOut.cols() == (horizon + 1) * dof &&
+             qvelOut.rows() == qpos.rows() && qvelOut.cols() == (horizon + 1) * dof,
+         "trajectory outputs should be B x ((H + 1) * dof)");
+  prepareThreads();
+  mThreadPool->parallelFor(0, qpos.rows(), [&](size_t b, uint32_t thread) {
+    auto &d = mThreadData[thread];
+    // joint coordinates are angles and offsets in SAPIEN order, so integration is additive
+    Eigen::VectorXd q = qpos.row(b).transpose();
+    Eigen::VectorXd v = qvel.row(b).transpose();
+    qposOut.block(b, 0, 1, dof) = q.transpose();
+    qvelOut.block(b, 0, 1, dof) = v.transpose();
+    for (uint32_t h = 0; h < horizon; ++h) {
+      if (integrator == Integrator::SemiImplicitEuler) {
+        v += timestep * forwardDynamics(d, q, v, policy(b, h, 0, d, q, v));
+        q += timestep * v;
+      } else {
+        Eigen::VectorXd k1q = v;
+        Eigen::VectorXd k1v = forwardDynamics(d, q, v, policy(b, h, 0, d, q, v));
+        Eigen::VectorXd q2 = q + 0.5 * timestep * k1q, v2 = v + 0.5 * timestep * k1v;
+        Eigen::VectorXd k2q = v2;
+        Eigen::VectorXd k2v = forwardDynamics(d, q2, v2, policy(b, h, 1, d, q2, v2));
+        Eigen::VectorXd q3 = q + 0.5 * timestep * k2q, v3 = v + 0.5 * timestep * k2v;
+        Eigen::VectorXd k3q = v3;
+        Eigen::VectorXd k3v = forwardDynamics(d, q3, v3, policy(b, h, 2, d, q3, v3));
+        Eigen::VectorXd q4 = q + timestep * k3q, v4 = v + timestep * k3v;
+        Eigen::VectorXd k4q = v4;
+        Eigen::VectorXd k4v = forwardDynamics(d, q4, v4, policy(b, h, 3, d, q4, v4));
+        q += timestep / 6 * (k1q + 2 * k2q + 2 * k3q + k4q);
+        v += timestep / 6 * (k1v + 2 * k2v + 2 * k3v + k4v);
+      }
+      qposOut.block(b, (h + 1) * dof, 1, dof) = q.transpose();
+      qvelOut.block(b, (h + 1) * dof, 1, dof) = v.transpose();
+    }
+  });
+}
+
+void PinocchioModel::rolloutDynamics(Eigen::Ref<const RowMatrixXd> const &qpos,
+                                     Eigen::Ref<const RowMatrixXd> const &qvel,
+                                     Eigen::Ref<const RowMatrixXd> const &torques,
+                                     double timestep, Integrator integrator,
+                                     Eigen::Ref<RowMatrixXd> qposOut,
+                                     Eigen::Ref<RowMatrixXd> qvelOut) {
+  int dof = model.nv;
+  ASSERT(torques.rows() == qpos.rows() && dof > 0 && torques.cols() % dof == 0,
+         "torques should be B x (H * dof)");
+  uint32_t horizon = torques.cols() / dof;
+  rollout(
+      qpos, qvel, horizon, timestep, integrator,
+      [&](size_t b, uint32_t h, int, pinocchio::Data &, Eigen::VectorXd const &,
+          Eigen::VectorXd const &) {
+        return Eigen::VectorXd(torques.block(b, h * dof, 1, dof).transpose());
+      },
+      qposOut, qvelOut);
+}
+
+void PinocchioModel::rolloutDynamicsPD(
+    Eigen::Ref<const RowMatrixXd> const &qpos, Eigen::Ref<const RowMatrixXd> const &qvel,
+    Eigen::Ref<const RowMatrixXd> const &targets, Eigen::VectorXd const &stiffness,
+    Eigen::VectorXd const &damping, double timestep, Integrator integrator,
+    bool compensatePassiveForce, Eigen::Ref<RowMatrixXd> qposOut, Eigen::Ref<RowMatrixXd> qvelOut,
+    Eigen::Ref<RowMatrixXd> torquesOut) {
+  int dof = model.nv;
+  ASSERT(targets.rows() == qpos.rows() && dof > 0 && targets.cols() % dof == 0,
+         "targets should be B x (H * dof)");
+  ASSERT(stiffness.size() == dof && damping.size() == dof,
+         "stiffness and damping should have size dof");
+  ASSERT(torquesOut.rows() == targets.rows() && torquesOut.cols() == targets.cols(),
+         "torques output should be B x (H * dof)");
+  uint32_t horizon = targets.cols() / dof;
+  rollout(
+      qpos, qvel, horizon, timestep, integrator,
+      [&](size_t b, uint32_t h, int stage, pinocchio::Data &d, Eigen::VectorXd const &q,
+          Eigen::VectorXd const &v) {
+        Eigen::VectorXd target = targets.block(b, h * dof, 1, dof).transpose();
+        Eigen::VectorXd t = stiffness.cwiseProduct(target - q) - damping.cwiseProduct(v);
+        if (compensatePassiveForce) {
+          // ABA recomputes everything afterwards, so the worker data can be reused here
+          t += indexS2P.transpose() * pinocchio::rnea(model, d, posS2P(q), indexS2P * v,
+                                                      Eigen::VectorXd::Zero(model.nv));
+        }
+        if (stage == 0) {
+          torquesOut.block(b, h * dof, 1, dof) = t.transpose();
+        }
+        return t;
+      },
+      qposOut, qvelOut);
+}
+
 } // namespace sapien
 
 #endif
@@ -1,18 +1,39 @@
 #ifdef _USE_PINOCCHIO
 #pragma once
 
+#include "utils/thread_pool.hpp"
 #include <PxPhysicsAPI.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <pinocchio/algorithm/jacobian.hpp>
 #include <pinocchio/algorithm/joint-configuration.hpp>
 #include <pinocchio/algorithm/kinematics.hpp>
+#include <pinocchio/container/aligned-vector.hpp>
 #include <pinocchio/parsers/urdf.hpp>
+#include <random>
 
 namespace sapien {
+class SArticulationBase;
 
 class PinocchioModel {
+public:
+  using RowMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  enum class Integrator { SemiImplicitEuler, RK4 };
+
+private:
   pinocchio::Model model;
   pinocchio::Data data;
 
+  // per-thread data for batched queries, one entry per pool worker. Slots are indexed by
+  // the pool chunk, so batched queries hold the mutex and run one at a time per model
+  std::mutex mThreadMutex;
+  std::unique_ptr<utils::ThreadPool> mThreadPool;
+  pinocchio::container::aligned_vector<pinocchio::Data> mThreadData;
+  std::vector<pinocchio::Data::Matrix6x> mThreadJacobians;
+  uint32_t mNumThreads{0};
+
   /** pinocchio_qpos = indexS2P * sapien_qpos
    * Left multiplication permutes rows of SAPIEN order to Pinocchio order
    * Right multiplication permutes columns of Pinocchio order to SAPIEN order
@@ -23,15 +44,93 @@ class PinocchioModel {
   Eigen::VectorXi NQ;
   Eigen::VectorXi NV;
 
-  Eigen::VectorXd posS2P(const Eigen::VectorXd &qpos);
-  Eigen::VectorXd posP2S(const Eigen::VectorXd &qpos);
+  Eigen::VectorXd posS2P(const Eigen::VectorXd &qpos) const;
+  Eigen::VectorXd posP2S(const Eigen::VectorXd &qpos) const;
 
   std::vector<int> linkIdx2FrameIdx;
 
+  /* build indexS2P, QIDX, NQ and NV from Pinocchio joints listed in SAPIEN order */
+  void setJointIndices(std::vector<pinocchio::JointIndex> const &joints);
+
+  pinocchio::SE3 linkPose(pinocchio::Data const &d, uint32_t index) const;
+
+  /* out is a template so that it accepts matrices and blocks of any storage order, it is
+   * written through const_cast as Eigen recommends */
+  template <typename Out>
+  void linkJacobian(pinocchio::Data const &d, uint32_t index, bool local,
+                    pinocchio::Data::Matrix6x &J, Eigen::MatrixBase<Out> const &out) const;
+
+  /* create the pool and per-thread data on first use */
+  void prepareThreads();
+
+  std::mt19937 mRandomEngine;
+
+  pinocchio::SE3 jointTarget(uint32_t linkIdx, physx::PxTransform const &pose) const;
+
+  /** sample a configuration in Pinocchio order, uniform within finite joint limits and in
+   *  [-pi, pi] for unbounded revolute joints */
+  Eigen::VectorXd sampleConfiguration();
+
+  /** clik iterations from q (Pinocchio order), q is updated in place
+   *  @param clampLimits clamp single dof joints to their limits after every iteration
+   *  @param cancel stop early when set by another thread, may be null
+   */
+  bool clik(pinocchio::Data &d, uint32_t jointIdx, pinocchio::SE3 const &oMdes,
+            Eigen::VectorXd &q, Eigen::Matrix<double, 6, 1> &err, double eps, int maxIter,
+            double dt, double damp, bool clampLimits,
+            std::atomic<bool> const *cancel = nullptr) const;
+
+  /* build seeds in Pinocchio order from user seeds (SAPIEN order) and random samples */
+  std::vector<Eigen::VectorXd> makeSeeds(RowMatrixXd const &initQpos, uint32_t numRandom);
+
+  /* derivatives on the given data, outputs in SAPIEN order and of any storage order as in
+   * linkJacobian */
+  template <typename Out>
+  void inverseDynamicsDerivatives(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                  Eigen::VectorXd const &qvel, Eigen::VectorXd const &qacc,
+                                  Eigen::MatrixBase<Out> const &dqpos,
+                                  Eigen::MatrixBase<Out> const &dqvel,
+                                  Eigen::MatrixBase<Out> const &dqacc) const;
+  template <typename Out>
+  void forwardDynamicsDerivatives(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                  Eigen::VectorXd const &qvel, Eigen::VectorXd const &qf,
+                                  Eigen::MatrixBase<Out> const &dqpos,
+                                  Eigen::MatrixBase<Out> const &dqvel,
+                                  Eigen::MatrixBase<Out> const &dqf) const;
+
+  /* ABA on the given data, all vectors in SAPIEN order */
+  Eigen::VectorXd forwardDynamics(pinocchio::Data &d, Eigen::VectorXd const &qpos,
+                                  Eigen::VectorXd const &qvel, Eigen::VectorXd const &qf) const;
+
+  /** shared rollout loop, policy(env, step, stage, data, qpos, qvel) returns the joint torque,
+   *  stage is the RK4 stage (always 0 for Euler) and data is free scratch of the worker */
+  template <typename Policy>
+  void rollout(Eigen::Ref<const RowMatrixXd> const &qpos,
+               Eigen::Ref<const RowMatrixXd> const &qvel, uint32_t horizon, double timestep,
+               Integrator integrator, Policy const &policy,
+               Eigen::Ref<RowMatrixXd> qposOut, Eigen::Ref<RowMatrixXd> qvelOut);
+
 public:
   static std::unique_ptr<PinocchioModel> fromURDFXML(std::string const &urdf,
                                                      Eigen::Vector3d gravity);
 
+  /** Build the model directly from the joint tree, link inertias and joint frames of an
+   *  articulation, with the root fixed at the origin
+   *
+   *  Produces the same kinematics and dynamics as fromURDFXML on
+   *  exportKinematicsChainAsURDF(true), with joint and link order already set, without
+   *  going through URDF text.
+   */
+  static std::unique_ptr<PinocchioModel> fromArticulation(SArticulationBase &articulation,
+                                                          Eigen::Vector3d gravity);
+
+  /** Copy of the model with fresh data, for identical articulations in other environments
+   *  or other threads. The thread pool is not shared.
+   *
+   *  Single queries share the data of the model and must not run concurrently. Batched
+   *  queries are serialized on the model, clone it to run them concurrently. */
+  std::unique_ptr<PinocchioModel> clone() const;
+
   PinocchioModel(PinocchioModel const &other) = delete;
   PinocchioModel &operator=(PinocchioModel const &other) = delete;
   ~PinocchioModel() = default;
@@ -67,6 +166,29 @@ public:
    */
   Eigen::Matrix<double, 6, Eigen::Dynamic> getLinkJacobian(uint32_t index, bool local = false);
 
+  /** number of threads used by batched queries, 0 means one per hardware thread */
+  void setNumThreads(uint32_t n);
+  inline uint32_t getNumThreads() const { return mNumThreads; }
+
+  /** forward kinematics for many configurations in parallel
+   *
+   *  @param qpos N x dof, one configuration per row
+   *  @param poses N x (7 * numLinks) output, row i holds the pose (x, y, z, qw, qx, qy, qz) of
+   *         every link at configuration i
+   *  Does not modify the data used by computeForwardKinematics
+   */
+  void computeForwardKinematicsBatch(Eigen::Ref<const RowMatrixXd> const &qpos,
+                                     Eigen::Ref<RowMatrixXd> poses);
+
+  /** link Jacobians for many configurations in parallel
+   *
+   *  @param qpos N x dof, one configuration per row
+   *  @param jacobians (N * numLinks * 6) x dof output, the Jacobian of link l at configuration
+   *         i starts at row (i * numLinks + l) * 6, as returned by getLinkJacobian
+   */
+  void computeFullJacobianBatch(Eigen::Ref<const RowMatrixXd> const &qpos,
+                                Eigen::Ref<RowMatrixXd> jacobians, bool local = false);
+
   /** compute the local Jacobian for a single link
    *
    */
@@ -102,6 +224,78 @@ public:
   Eigen::VectorXd computeForwardDynamics(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
                                          const Eigen::VectorXd &qf);
 
+  /** Integrate forward dynamics of B environments for H steps under a torque sequence
+   *
+   *  Environments run in parallel. The torque of a step is held constant over the step.
+   *  @param qpos, qvel B x dof initial states
+   *  @param torques B x (H * dof), row b holds the torques of environment b step by step
+   *  @param qposOut, qvelOut B x ((H + 1) * dof) trajectories including the initial state,
+   *         reshape to (B, H + 1, dof) on the Python side
+   */
+  void rolloutDynamics(Eigen::Ref<const RowMatrixXd> const &qpos,
+                       Eigen::Ref<const RowMatrixXd> const &qvel,
+                       Eigen::Ref<const RowMatrixXd> const &torques, double timestep,
+                       Integrator integrator, Eigen::Ref<RowMatrixXd> qposOut,
+                       Eigen::Ref<RowMatrixXd> qvelOut);
+
+  /** Integrate forward dynamics of B environments for H steps under joint PD control
+   *
+   *  t = stiffness * (target - qpos) - damping * qvel (+ gravity and Coriolis terms when
+   *  compensatePassiveForce), evaluated at every integration stage. Layouts are as in
+   *  rolloutDynamics.
+   *  @param targets B x (H * dof) position targets
+   *  @param torquesOut B x (H * dof) torque applied at the start of every step
+   */
+  void rolloutDynamicsPD(Eigen::Ref<const RowMatrixXd> const &qpos,
+                         Eigen::Ref<const RowMatrixXd> const &qvel,
+                         Eigen::Ref<const RowMatrixXd> const &targets,
+                         Eigen::VectorXd const &stiffness, Eigen::VectorXd const &damping,
+                         double timestep, Integrator integrator, bool compensatePassiveForce,
+                         Eigen::Ref<RowMatrixXd> qposOut, Eigen::Ref<RowMatrixXd> qvelOut,
+                         Eigen::Ref<RowMatrixXd> torquesOut);
+
+  /** Derivatives of inverse dynamics t = RNEA(qpos, qvel, qacc)
+   *
+   *  @return dt/dqpos, dt/dqvel and dt/dqacc (the full mass matrix)
+   */
+  std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+  computeInverseDynamicsDerivatives(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                    const Eigen::VectorXd &qacc);
+
+  /** Derivatives of forward dynamics qacc = ABA(qpos, qvel, qf)
+   *
+   *  @return dqacc/dqpos, dqacc/dqvel and dqacc/dqf (the full inverse mass matrix)
+   */
+  std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+  computeForwardDynamicsDerivatives(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                    const Eigen::VectorXd &qf);
+
+  /** Derivatives of the spatial velocity (linear first) of a link
+   *
+   *  @return dv/dqpos and dv/dqvel, both 6 x dof. dv/dqvel is the link Jacobian.
+   */
+  std::tuple<Eigen::Matrix<double, 6, Eigen::Dynamic>, Eigen::Matrix<double, 6, Eigen::Dynamic>>
+  computeLinkVelocityDerivatives(uint32_t index, const Eigen::VectorXd &qpos,
+                                 const Eigen::VectorXd &qvel, bool local = false);
+
+  /** computeInverseDynamicsDerivatives for many states in parallel
+   *
+   *  @param qpos, qvel, qacc N x dof
+   *  @param dqpos, dqvel, dqacc (N * dof) x dof outputs, the derivatives of state i start at
+   *         row i * dof
+   */
+  void computeInverseDynamicsDerivativesBatch(
+      Eigen::Ref<const RowMatrixXd> const &qpos, Eigen::Ref<const RowMatrixXd> const &qvel,
+      Eigen::Ref<const RowMatrixXd> const &qacc, Eigen::Ref<RowMatrixXd> dqpos,
+      Eigen::Ref<RowMatrixXd> dqvel, Eigen::Ref<RowMatrixXd> dqacc);
+
+  /** computeForwardDynamicsDerivatives for many states in parallel, layouts as in
+   *  computeInverseDynamicsDerivativesBatch */
+  void computeForwardDynamicsDerivativesBatch(
+      Eigen::Ref<const RowMatrixXd> const &qpos, Eigen::Ref<const RowMatrixXd> const &qvel,
+      Eigen::Ref<const RowMatrixXd> const &qf, Eigen::Ref<RowMatrixXd> dqpos,
+      Eigen::Ref<RowMatrixXd> dqvel, Eigen::Ref<RowMatrixXd> dqf);
+
   /** Numerical IK clik algorithm
    *  computes the numerical IK for a given link
    *  https://gepettoweb.laas.fr/doc/stack-of-tasks/pinocchio/master/doxygen-html/md_doc_b-examples_i-inverse-kinematics.html
@@ -110,6 +304,33 @@ public:
   std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
   computeInverseKinematics(uint32_t linkIdx, physx::PxTransform const &pose, double eps = 1e-4,
                            int maxIter = 1000, double dt = 1e-1, double damp = 1e-6);
+
+  /** Multi-start clik with joint limits
+   *
+   *  Starts from every row of initQpos (K x dof, may be empty) and from numRandomStarts random
+   *  configurations. Starts run in parallel and all stop as soon as one succeeds. Single dof
+   *  joints are clamped to their limits during iteration.
+   *  @return the first successful solution, or the one with the smallest error
+   */
+  std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
+  computeInverseKinematicsMultiStart(uint32_t linkIdx, physx::PxTransform const &pose,
+                                     RowMatrixXd const &initQpos = {},
+                                     uint32_t numRandomStarts = 8, double eps = 1e-4,
+                                     int maxIter = 1000, double dt = 1e-1, double damp = 1e-6);
+
+  /** Multi-start clik for many target poses of the same link
+   *
+   *  Targets are solved in parallel, the starts of each target are tried in order until one
+   *  succeeds. Random starts are drawn independently for every target.
+   *  @return N x dof solutions, success flags and N x 6 errors
+   */
+  std::tuple<RowMatrixXd, std::vector<bool>, Eigen::Matrix<double, Eigen::Dynamic, 6>>
+  computeInverseKinematicsBatch(uint32_t linkIdx, std::vector<physx::PxTransform> const &poses,
+                                RowMatrixXd const &initQpos = {}, uint32_t numRandomStarts = 8,
+                                double eps = 1e-4, int maxIter = 1000, double dt = 1e-1,
+                                double damp = 1e-6);
+
+  inline void setRandomSeed(uint32_t seed) { mRandomEngine.seed(seed); }
 };
 
 }; // namespace sapien
@@ -2,6 +2,7 @@
 #include "sapien_joint.h"
 #include "sapien_link.h"
 #include "sapien_scene.h"
+#include <algorithm>
 #include <numeric>
 #include <spdlog/spdlog.h>
 
@@ -56,6 +57,7 @@ void SArticulation::setQpos(std::vector<physx::PxReal> const &v) {
     mCache->jointPosition[i] = v2[i];
   }
   mPxArticulation->applyCache(*mCache, PxArticulationCache::ePOSITION);
+  invalidateCommonData();
 }
 
 std::vector<physx::PxReal> SArticulation::getQvel() const {
@@ -70,6 +72,7 @@ void SArticulation::setQvel(std::vector<physx::PxReal> const &v) {
     mCache->jointVelocity[i] = v2[i];
   }
   mPxArticulation->applyCache(*mCache, PxArticulationCache::eVELOCITY);
+  invalidateCommonData();
 }
 
 std::vector<physx::PxReal> SArticulation::getQacc() const {
@@ -100,6 +103,8 @@ void SArticulation::setQf(std::vector<physx::PxReal> const &v) {
     mCache->jointForce[i] = v2[i];
   }
   mPxArticulation->applyCache(*mCache, PxArticulationCache::eFORCE);
+  // prestep overwrites the joint force, so it adds this one for the next step
+  mPendingForce = v2;
 }
 
 std::vector<std::array<physx::PxReal, 2>> SArticulation::getQlimits() const {
@@ -137,16 +142,31 @@ void SArticulation::setDriveTarget(std::vector<physx::PxReal> const &v) {
   }
 }
 
+void SArticulation::setDriveVelocityTarget(std::vector<physx::PxReal> const &v) {
+  CHECK_SIZE(v);
+
+  uint32_t i = 0;
+  for (auto &j : mJoints) {
+    for (auto axis : j->getAxes()) {
+      j->getPxJoint()->setDriveVelocity(axis, v[i]);
+      i += 1;
+    }
+  }
+}
+
 void SArticulation::setRootPose(physx::PxTransform const &T) {
   mPxArticulation->teleportRootLink(T, true);
+  invalidateCommonData();
 }
 
 void SArticulation::setRootVelocity(physx::PxVec3 const &v) {
   mRootLink->getPxActor()->setLinearVelocity(v);
+  invalidateCommonData();
 }
 
 void SArticulation::setRootAngularVelocity(physx::PxVec3 const &omega) {
   mRootLink->getPxActor()->setAngularVelocity(omega);
+  invalidateCommonData();
 }
 
 SLinkBase *SArticulation::getRootLink() { return mRootLink; }
@@ -221,6 +241,16 @@ std::vector<PxReal> SArticulation::getDriveTarget() const {
   return driveTarget;
 }
 
+std::vector<PxReal> SArticulation::getDriveVelocityTarget() const {
+  std::vector<PxReal> driveVelocity;
+  for (auto &j : mJoints) {
+    for (auto axis : j->getAxes()) {
+      driveVelocity.push_back(j->getPxJoint()->getDriveVelocity(axis));
+    }
+  }
+  return driveVelocity;
+}
+
 std::vector<SLink *> SArticulation::getSLinks() {
   std::vector<SLink *> result;
   result.reserve(mLinks.size());
@@ -253,6 +283,22 @@ void SArticulation::resetCache() {
   mPxArticulation->releaseCache(*mCache);
   mCache = mPxArticulation->createCache();
 }
+
+std::unique_ptr<ArticulationQueryContext> SArticulation::createQueryContext() {
+  return std::unique_ptr<ArticulationQueryContext>(new ArticulationQueryContext(this));
+}
+
+void SArticulation::prepareCommonData() {
+  if (!mCommonDataStale.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mCommonDataMutex);
+  if (mCommonDataStale.load(std::memory_order_relaxed)) {
+    mPxArticulation->commonInit();
+    mCommonDataStale.store(false, std::memory_order_release);
+  }
+}
+
 std::vector<physx::PxReal>
 SArticulation::computePassiveForce(bool gravity, bool coriolisAndCentrifugal, bool external) {
   mPxArticulation->commonInit();
@@ -337,6 +383,165 @@ SArticulation::computeManipulatorInertiaMatrix() {
   return mColumnPermutationI2E.transpose() * originMass * mColumnPermutationI2E;
 }
 
+void SArticulation::setPassiveForceCompensation(bool gravity, bool coriolisAndCentrifugal,
+                                                bool external) {
+  mCompensateGravity = gravity;
+  mCompensateCoriolisAndCentrifugal = coriolisAndCentrifugal;
+  mCompensateExternal = external;
+}
+
+std::array<bool, 3> SArticulation::getPassiveForceCompensation() const {
+  return {mCompensateGravity, mCompensateCoriolisAndCentrifugal, mCompensateExternal};
+}
+
+void SArticulation::setHeldQf(std::vector<PxReal> const &v) {
+  if (v.empty()) {
+    mHeldForce.clear();
+    return;
+  }
+  CHECK_SIZE(v);
+  mHeldForce = E2I(v);
+}
+
+std::vector<PxReal> SArticulation::getHeldQf() const {
+  if (mHeldForce.empty()) {
+    return {};
+  }
+  return I2E(mHeldForce);
+}
+
+ArticulationController *
+SArticulation::addController(std::unique_ptr<ArticulationController> controller) {
+  if (!controller) {
+    return nullptr;
+  }
+  if (controller->dof() != dof()) {
+    spdlog::get("SAPIEN")->error(
+        "Failed to add controller: controller has {} DOF but articulation has {}",
+        controller->dof(), dof());
+    return nullptr;
+  }
+  mControllers.push_back(std::move(controller));
+  return mControllers.back().get();
+}
+
+JointPDController *SArticulation::createJointPDController(std::vector<PxReal> const &stiffness,
+                                                          std::vector<PxReal> const &damping) {
+  return static_cast<JointPDController *>(
+      addController(std::make_unique<JointPDController>(stiffness, damping)));
+}
+
+JointImpedanceController *
+SArticulation::createJointImpedanceController(std::vector<PxReal> const &stiffness,
+                                              std::vector<PxReal> const &damping) {
+  return static_cast<JointImpedanceController *>(
+      addController(std::make_unique<JointImpedanceController>(stiffness, damping)));
+}
+
+OperationalSpaceController *
+SArticulation::createOperationalSpaceController(uint32_t linkId,
+                                                std::vector<PxReal> const &stiffness,
+                                                std::vector<PxReal> const &damping) {
+  if (linkId == 0 || linkId >= mLinks.size()) {
+    spdlog::get("SAPIEN")->error(
+        "Failed to create operational space controller: invalid link id {}", linkId);
+    return nullptr;
+  }
+  return static_cast<OperationalSpaceController *>(addController(
+      std::make_unique<OperationalSpaceController>(dof(), linkId, stiffness, damping)));
+}
+
+void SArticulation::removeController(ArticulationController *controller) {
+  mControllers.erase(std::remove_if(mControllers.begin(), mControllers.end(),
+                                    [controller](auto &c) { return c.get() == controller; }),
+                     mControllers.end());
+}
+
+std::vector<ArticulationController *> SArticulation::getControllers() {
+  std::vector<ArticulationController *> result;
+  for (auto &c : mControllers) {
+    result.push_back(c.get());
+  }
+  return result;
+}
+
+bool SArticulation::hasPrestepForce() const {
+  return mCompensateGravity || mCompensateCoriolisAndCentrifugal || mCompensateExternal ||
+         !mControllers.empty() || !mHeldForce.empty();
+}
+
+void SArticulation::applyPrestepForce() {
+  uint32_t n = dof();
+  mPrestepForce.resize(n);
+  if (mHeldForce.size() == n) {
+    std::copy(mHeldForce.begin(), mHeldForce.end(), mPrestepForce.begin());
+  } else {
+    std::fill(mPrestepForce.begin(), mPrestepForce.end(), 0.f);
+  }
+  if (mPendingForce.size() == n) {
+    for (uint32_t i = 0; i < n; ++i) {
+      mPrestepForce[i] += mPendingForce[i];
+    }
+  }
+
+  bool compensate = mCompensateGravity || mCompensateCoriolisAndCentrifugal || mCompensateExternal;
+  if (!compensate && mControllers.empty()) {
+    // only the held force, no state needed
+    std::copy(mPrestepForce.begin(), mPrestepForce.end(), mCache->jointForce);
+    mPxArticulation->applyCache(*mCache, PxArticulationCache::eFORCE);
+    return;
+  }
+
+  // one state copy shared by all passive force terms and controllers
+  mPxArticulation->commonInit();
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION |
+                                                         PxArticulationCache::eVELOCITY);
+  if (!mControllers.empty()) {
+    mControllerQpos.resize(n);
+    mControllerQvel.resize(n);
+    mControllerForce.resize(n);
+    gatherFromCache(mCache->jointPosition, mControllerQpos);
+    gatherFromCache(mCache->jointVelocity, mControllerQvel);
+  }
+
+  if (mCompensateCoriolisAndCentrifugal) {
+    mPxArticulation->computeCoriolisAndCentrifugalForce(*mCache);
+    for (uint32_t i = 0; i < n; ++i) {
+      mPrestepForce[i] += mCache->jointForce[i];
+    }
+  }
+  if (mCompensateGravity) {
+    mPxArticulation->computeGeneralizedGravityForce(*mCache);
+    for (uint32_t i = 0; i < n; ++i) {
+      mPrestepForce[i] += mCache->jointForce[i];
+    }
+  }
+  if (mCompensateExternal) {
+    mPxArticulation->computeGeneralizedExternalForce(*mCache);
+    for (uint32_t i = 0; i < n; ++i) {
+      mPrestepForce[i] += mCache->jointForce[i];
+    }
+  }
+
+  if (!mControllers.empty()) {
+    ControllerContext context{this, mCache, mControllerQpos, mControllerQvel,
+                              mScene->getTimestep()};
+    for (auto &controller : mControllers) {
+      if (!controller->isEnabled()) {
+        continue;
+      }
+      mControllerForce.setZero();
+      controller->update(context, mControllerForce);
+      for (uint32_t i = 0; i < n; ++i) {
+        mPrestepForce[mIndexE2I[i]] += mControllerForce[i];
+      }
+    }
+  }
+
+  std::copy(mPrestepForce.begin(), mPrestepForce.end(), mCache->jointForce);
+  mPxArticulation->applyCache(*mCache, PxArticulationCache::eFORCE);
+}
+
 void SArticulation::prestep() {
   auto time = mScene->getTimestep();
   EventArticulationStep s;
@@ -350,6 +555,25 @@ void SArticulation::prestep() {
     s.time = time;
     l->EventEmitter<EventActorStep>::emit(s);
   }
+
+  if (hasPrestepForce()) {
+    applyPrestepForce();
+    mPrestepForceApplied = true;
+  } else if (mPrestepForceApplied) {
+    // remove the last prestep force from the cache, keeping a force given to setQf
+    uint32_t n = dof();
+    if (mPendingForce.size() == n) {
+      std::copy(mPendingForce.begin(), mPendingForce.end(), mCache->jointForce);
+    } else {
+      std::fill(mCache->jointForce, mCache->jointForce + n, 0.f);
+    }
+    mPxArticulation->applyCache(*mCache, PxArticulationCache::eFORCE);
+    mPrestepForceApplied = false;
+  }
+  // setQf acts on one step, also when compensation is enabled later
+  mPendingForce.clear();
+  // the step moves the articulation
+  invalidateCommonData();
 }
 
 Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
@@ -520,49 +744,7 @@ void SArticulation::unpackData(std::vector<PxReal> const &data) {
   p += 3;
 
   mPxArticulation->applyCache(*mCache, PxArticulationCache::eALL);
-}
-
-Matrix<PxReal, Dynamic, 1>
-SArticulation::computeTwistDiffIK(const Eigen::Matrix<PxReal, 6, 1> &spatialTwist,
-                                  uint32_t commandedLinkId,
-                                  const std::vector<uint32_t> &activeQIds) {
-  auto logger = spdlog::get("SAPIEN");
-  auto numCol = activeQIds.empty() ? dof() : activeQIds.size();
-  Eigen::VectorXf qvel(numCol);
-
-  if (commandedLinkId == 0) {
-    logger->warn("Link with id 0 (root link) can not be a valid commanded link.");
-    return qvel;
-  }
-
-  auto denseJacobian = computeSpatialTwistJacobianMatrix();
-  Eigen::MatrixXf jacobian = denseJacobian.block(commandedLinkId * 6 - 6, 0, 6, dof());
-  Eigen::MatrixXf reducedJacobian(jacobian);
-  if (!activeQIds.empty()) {
-    reducedJacobian.resize(6, numCol);
-    for (size_t i = 0; i < numCol; ++i) {
-      if (activeQIds[i] >= dof()) {
-        logger->warn("Articulation has {} joints, but given joint id {}", dof(), activeQIds[i]);
-        return qvel;
-      }
-      reducedJacobian.block<6, 1>(0, i) = jacobian.block<6, 1>(0, activeQIds[i]);
-    }
-  }
-
-  Eigen::JacobiSVD<Eigen::MatrixXf> svd_of_j(reducedJacobian,
-                                             Eigen::ComputeThinU | Eigen::ComputeThinV);
-  const Eigen::MatrixXf &u = svd_of_j.matrixU();
-  const Eigen::MatrixXf &v = svd_of_j.matrixV();
-  const Eigen::VectorXf &s = svd_of_j.singularValues();
-
-  Eigen::VectorXf invS = s;
-  static const float epsilon = std::numeric_limits<float>::epsilon();
-  double maxS = s[0];
-  for (std::size_t i = 0; i < static_cast<std::size_t>(s.rows()); ++i) {
-    invS(i) = fabs(s(i)) > maxS * epsilon ? 1.0 / s(i) : 0.0;
-  }
-  qvel = v * invS.asDiagonal() * u.transpose() * spatialTwist;
-  return qvel;
+  invalidateCommonData();
 }
 
 Eigen::Matrix<PxReal, 6, 6, Eigen::RowMajor>
@@ -577,47 +759,126 @@ SArticulation::computeAdjointMatrix(SLink *sourceFrame, SLink *targetFrame) {
   return adjoint;
 }
 
-Matrix<PxReal, Dynamic, 1>
-SArticulation::computeCartesianVelocityDiffIK(const Eigen::Matrix<PxReal, 6, 1> &cartesianVelocity,
-                                              uint32_t commandedLinkId,
-                                              const std::vector<uint32_t> &activeQIds) {
+static Eigen::VectorXf dampedLeastSquares(Eigen::MatrixXf const &jacobian,
+                                          Eigen::VectorXf const &target, PxReal damping) {
+  if (damping <= 0.f) {
+    // exact minimum norm least squares through the pseudo-inverse
+    Eigen::JacobiSVD<Eigen::MatrixXf> svd_of_j(jacobian,
+                                               Eigen::ComputeThinU | Eigen::ComputeThinV);
+    const Eigen::MatrixXf &u = svd_of_j.matrixU();
+    const Eigen::MatrixXf &v = svd_of_j.matrixV();
+    const Eigen::VectorXf &s = svd_of_j.singularValues();
+
+    Eigen::VectorXf invS = s;
+    static const float epsilon = std::numeric_limits<float>::epsilon();
+    double maxS = s[0];
+    for (std::size_t i = 0; i < static_cast<std::size_t>(s.rows()); ++i) {
+      invS(i) = fabs(s(i)) > maxS * epsilon ? 1.0 / s(i) : 0.0;
+    }
+    return v * invS.asDiagonal() * u.transpose() * target;
+  }
+
+  // solve in the smaller of the task space and the joint space
+  float damping2 = damping * damping;
+  if (jacobian.rows() <= jacobian.cols()) {
+    Eigen::MatrixXf normal = jacobian * jacobian.transpose();
+    normal.diagonal().array() += damping2;
+    return jacobian.transpose() * normal.ldlt().solve(target);
+  }
+  Eigen::MatrixXf normal = jacobian.transpose() * jacobian;
+  normal.diagonal().array() += damping2;
+  return normal.ldlt().solve(jacobian.transpose() * target);
+}
+
+static Eigen::VectorXf diffIK(SArticulation &articulation,
+                              Eigen::Matrix<PxReal, 6, 1> const &target, uint32_t commandedLinkId,
+                              std::vector<uint32_t> const &activeQIds, PxReal damping,
+                              bool spatialTwist) {
   auto logger = spdlog::get("SAPIEN");
-  auto numCol = activeQIds.empty() ? dof() : activeQIds.size();
-  Eigen::VectorXf qvel(numCol);
+  uint32_t dof = articulation.dof();
+  auto numCol = activeQIds.empty() ? dof : activeQIds.size();
+  Eigen::VectorXf qvel = Eigen::VectorXf::Zero(numCol);
 
   if (commandedLinkId == 0) {
     logger->warn("Link with id 0 (root link) can not be a valid commanded link.");
     return qvel;
   }
+  if (commandedLinkId >= articulation.getBaseLinks().size()) {
+    logger->warn("Articulation has {} links, but given link id {}",
+                 articulation.getBaseLinks().size(), commandedLinkId);
+    return qvel;
+  }
 
-  auto denseJacobian = computeWorldCartesianJacobianMatrix();
-  Eigen::MatrixXf jacobian = denseJacobian.block(commandedLinkId * 6 - 6, 0, 6, dof());
+  auto denseJacobian = spatialTwist ? articulation.computeSpatialTwistJacobianMatrix()
+                                    : articulation.computeWorldCartesianJacobianMatrix();
+  Eigen::MatrixXf jacobian = denseJacobian.block(commandedLinkId * 6 - 6, 0, 6, dof);
   Eigen::MatrixXf reducedJacobian(jacobian);
   if (!activeQIds.empty()) {
     reducedJacobian.resize(6, numCol);
     for (size_t i = 0; i < numCol; ++i) {
-      if (activeQIds[i] >= dof()) {
-        logger->warn("Articulation has {} joints, but given joint id {}", dof(), activeQIds[i]);
+      if (activeQIds[i] >= dof) {
+        logger->warn("Articulation has {} joints, but given joint id {}", dof, activeQIds[i]);
         return qvel;
       }
       reducedJacobian.block<6, 1>(0, i) = jacobian.block<6, 1>(0, activeQIds[i]);
     }
   }
 
-  Eigen::JacobiSVD<Eigen::MatrixXf> svd_of_j(reducedJacobian,
-                                             Eigen::ComputeThinU | Eigen::ComputeThinV);
-  const Eigen::MatrixXf &u = svd_of_j.matrixU();
-  const Eigen::MatrixXf &v = svd_of_j.matrixV();
-  const Eigen::VectorXf &s = svd_of_j.singularValues();
+  return dampedLeastSquares(reducedJacobian, target, damping);
+}
+
+Matrix<PxReal, Dynamic, 1>
+SArticulation::computeTwistDiffIK(const Eigen::Matrix<PxReal, 6, 1> &spatialTwist,
+                                  uint32_t commandedLinkId,
+                                  const std::vector<uint32_t> &activeQIds, PxReal damping) {
+  return diffIK(*this, spatialTwist, commandedLinkId, activeQIds, damping, true);
+}
+
+Matrix<PxReal, Dynamic, 1>
+SArticulation::computeCartesianVelocityDiffIK(const Eigen::Matrix<PxReal, 6, 1> &cartesianVelocity,
+                                              uint32_t commandedLinkId,
+                                              const std::vector<uint32_t> &activeQIds,
+                                              PxReal damping) {
+  return diffIK(*this, cartesianVelocity, commandedLinkId, activeQIds, damping, false);
+}
+
+void SArticulation::gatherFromCache(PxReal const *internal,
+                                    Eigen::Ref<Eigen::VectorXf> external) const {
+  for (uint32_t i = 0; i < mIndexE2I.size(); ++i) {
+    external[i] = internal[mIndexE2I[i]];
+  }
+}
+
+void SArticulation::scatterToCache(Eigen::Ref<const Eigen::VectorXf> const &external,
+                                   PxReal *internal) const {
+  for (uint32_t i = 0; i < mIndexE2I.size(); ++i) {
+    internal[mIndexE2I[i]] = external[i];
+  }
+}
+
+void SArticulation::copyLinkJacobian(
+    PxArticulationCache const &cache, uint32_t linkId, bool spatialTwist,
+    Eigen::Ref<Matrix<PxReal, Dynamic, Dynamic, RowMajor>> out) const {
+  // the dense Jacobian has 6 extra rows and columns for a floating root
+  bool fixBase = mPxArticulation->getArticulationFlags() & PxArticulationFlag::eFIX_BASE;
+  uint32_t freeBase = fixBase ? 0 : 6;
+  uint32_t nCols = mIndexE2I.size() + freeBase;
+
+  auto link = mLinks[linkId]->getPxActor();
+  uint32_t row = freeBase + (link->getLinkIndex() - 1) * 6;
+  for (uint32_t r = 0; r < 6; ++r) {
+    PxReal const *src = cache.denseJacobian + (row + r) * nCols + freeBase;
+    for (uint32_t c = 0; c < mIndexE2I.size(); ++c) {
+      out(r, c) = src[mIndexE2I[c]];
+    }
+  }
 
-  Eigen::VectorXf invS = s;
-  static const float epsilon = std::numeric_limits<float>::epsilon();
-  double maxS = s[0];
-  for (std::size_t i = 0; i < static_cast<std::size_t>(s.rows()); ++i) {
-    invS(i) = fabs(s(i)) > maxS * epsilon ? 1.0 / s(i) : 0.0;
+  if (spatialTwist) {
+    // v_twist = v + p x w
+    auto p = link->getGlobalPose().p;
+    Eigen::Matrix3f skew = skewSymmetric({p.x, p.y, p.z});
+    out.topRows<3>().noalias() += skew * out.bottomRows<3>();
   }
-  qvel = v * invS.asDiagonal() * u.transpose() * cartesianVelocity;
-  return qvel;
 }
 
 Eigen::Matrix<PxReal, 4, 4, Eigen::RowMajor>
@@ -1,7 +1,11 @@
 #pragma once
+#include "articulation_controller.h"
+#include "articulation_query_context.h"
 #include "sapien_articulation_base.h"
 #include <Eigen/Dense>
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 namespace sapien {
 using namespace physx;
@@ -14,6 +18,7 @@ class SJoint;
 class SArticulation : public SArticulationDrivable {
   friend class ArticulationBuilder;
   friend class LinkBuilder;
+  friend class ArticulationQueryContext;
 
   SScene *mScene;
 
@@ -31,6 +36,29 @@ class SArticulation : public SArticulationDrivable {
   Matrix<PxReal, Dynamic, Dynamic, RowMajor> mColumnPermutationI2E;
   Matrix<PxReal, Dynamic, Dynamic, RowMajor> mRowPermutationI2E;
 
+  /* Passive forces cancelled in prestep */
+  bool mCompensateGravity{false};
+  bool mCompensateCoriolisAndCentrifugal{false};
+  bool mCompensateExternal{false};
+
+  /* Joint force given to setHeldQf, force given to setQf for the next step only and the
+   * force applied in prestep, internal order */
+  std::vector<PxReal> mHeldForce;
+  std::vector<PxReal> mPendingForce;
+  std::vector<PxReal> mPrestepForce;
+  /* Whether the last prestep wrote the joint force, it is zeroed once when that stops */
+  bool mPrestepForceApplied{false};
+
+  std::vector<std::unique_ptr<ArticulationController>> mControllers;
+  Eigen::VectorXf mControllerQpos;
+  Eigen::VectorXf mControllerQvel;
+  Eigen::VectorXf mControllerForce;
+
+  /* PhysX common data depends on the pose, it is recomputed by the first query context that
+   * runs after a step or a state change */
+  std::atomic<bool> mCommonDataStale{true};
+  std::mutex mCommonDataMutex;
+
 public:
   std::vector<SLinkBase *> getBaseLinks() override;
   std::vector<SJointBase *> getBaseJoints() override;
@@ -59,6 +87,8 @@ public:
 
   std::vector<physx::PxReal> getDriveTarget() const override;
   void setDriveTarget(std::vector<physx::PxReal> const &v) override;
+  std::vector<physx::PxReal> getDriveVelocityTarget() const override;
+  void setDriveVelocityTarget(std::vector<physx::PxReal> const &v) override;
 
   void setRootPose(physx::PxTransform const &T) override;
   void setRootVelocity(physx::PxVec3 const &v);
@@ -74,10 +104,38 @@ public:
 
   void resetCache();
 
+  /* Create a context with its own cache, for dynamics queries from multiple threads */
+  std::unique_ptr<ArticulationQueryContext> createQueryContext();
+
   /* Dynamics Functions */
   std::vector<physx::PxReal> computePassiveForce(bool gravity = true,
                                                  bool coriolisAndCentrifugal = true,
                                                  bool external = true);
+
+  /* Cancel the selected passive forces in every prestep, all false disables compensation and
+   * removes the compensated force. While compensation, a controller or a held force is active,
+   * the force given by setQf is added on top for the next step only, use setHeldQf for a force
+   * added in every step. */
+  void setPassiveForceCompensation(bool gravity, bool coriolisAndCentrifugal, bool external);
+  std::array<bool, 3> getPassiveForceCompensation() const;
+
+  /* Joint force applied in every prestep, on top of compensation and controllers if any. An
+   * empty vector removes it. */
+  void setHeldQf(std::vector<PxReal> const &v);
+  std::vector<PxReal> getHeldQf() const;
+
+  /* Controllers run in prestep after compensation, the articulation owns them */
+  ArticulationController *addController(std::unique_ptr<ArticulationController> controller);
+  JointPDController *createJointPDController(std::vector<PxReal> const &stiffness,
+                                             std::vector<PxReal> const &damping);
+  JointImpedanceController *createJointImpedanceController(std::vector<PxReal> const &stiffness,
+                                                           std::vector<PxReal> const &damping);
+  /* Task space controller of a non-root link, see OperationalSpaceController */
+  OperationalSpaceController *
+  createOperationalSpaceController(uint32_t linkId, std::vector<PxReal> const &stiffness,
+                                   std::vector<PxReal> const &damping);
+  void removeController(ArticulationController *controller);
+  std::vector<ArticulationController *> getControllers();
   std::vector<physx::PxReal> computeInverseDynamics(const std::vector<PxReal> &qacc);
   std::vector<physx::PxReal> computeForwardDynamics(const std::vector<PxReal> &qf);
   Matrix<PxReal, Dynamic, Dynamic, RowMajor> computeManipulatorInertiaMatrix();
@@ -95,14 +153,31 @@ public:
   Matrix<PxReal, 6, 6, RowMajor> computeAdjointMatrix(uint32_t sourceLinkId,
                                                       uint32_t targetLinkId);
 
+  /* Least-squares diff IK through the pseudo-inverse, damped least squares when damping > 0.
+   * See DiffIKSolver for multiple links and repeated solves. */
   Matrix<PxReal, Dynamic, 1> computeTwistDiffIK(const Eigen::Matrix<PxReal, 6, 1> &spatialTwist,
                                                 uint32_t commandedLinkId,
-                                                const std::vector<uint32_t> &activeQIds = {});
+                                                const std::vector<uint32_t> &activeQIds = {},
+                                                PxReal damping = 0.f);
 
   Matrix<PxReal, Dynamic, 1>
   computeCartesianVelocityDiffIK(const Eigen::Matrix<PxReal, 6, 1> &cartesianVelocity,
                                  uint32_t commandedLinkId,
-                                 const std::vector<uint32_t> &activeQIds = {});
+                                 const std::vector<uint32_t> &activeQIds = {},
+                                 PxReal damping = 0.f);
+
+  inline std::vector<uint32_t> const &getIndexE2I() const { return mIndexE2I; }
+
+  /* Non-allocating helpers for solvers and controllers owning their own cache.
+   * Vectors are in external order, cache arrays are in internal order. */
+  void gatherFromCache(PxReal const *internal, Eigen::Ref<Eigen::VectorXf> external) const;
+  void scatterToCache(Eigen::Ref<const Eigen::VectorXf> const &external, PxReal *internal) const;
+
+  /* Copy the 6 x dof Jacobian of a link out of cache.denseJacobian, which must be filled by
+   * computeDenseJacobian beforehand. Rows are linear then angular. */
+  void copyLinkJacobian(PxArticulationCache const &cache, uint32_t linkId, bool spatialTwist,
+                        Eigen::Ref<Matrix<PxReal, Dynamic, Dynamic, RowMajor>> out) const;
+
   /* Save and Load */
   std::vector<PxReal> packData();
   void unpackData(std::vector<PxReal> const &data);
@@ -112,6 +187,13 @@ private:
   SArticulation(SArticulation const &other) = delete;
   SArticulation &operator=(SArticulation const &other) = delete;
 
+  bool hasPrestepForce() const;
+  void applyPrestepForce();
+
+  inline void invalidateCommonData() { mCommonDataStale.store(true, std::memory_order_release); }
+  /* Run commonInit if the state changed since the last call, safe from concurrent contexts */
+  void prepareCommonData();
+
   std::vector<PxReal> E2I(std::vector<PxReal> ev) const;
   std::vector<PxReal> I2E(std::vector<PxReal> iv) const;
 
@@ -144,21 +144,7 @@ std::string SArticulationBase::exportKinematicsChainAsURDF(bool fixRoot) {
 #ifdef _USE_PINOCCHIO
 std::unique_ptr<PinocchioModel> SArticulationBase::createPinocchioModel() {
   PxVec3 gravity = getScene()->getPxScene()->getGravity();
-  auto pm = PinocchioModel::fromURDFXML(exportKinematicsChainAsURDF(true),
-                                        {gravity.x, gravity.y, gravity.z});
-  std::vector<std::string> jointNames;
-  std::vector<std::string> linkNames;
-  for (auto j : getBaseJoints()) {
-    if (j->getDof() > 0) {
-      jointNames.push_back("joint_" + std::to_string(j->getChildLink()->getIndex()));
-    }
-  }
-  for (auto l : getBaseLinks()) {
-    linkNames.push_back("link_" + std::to_string(l->getIndex()));
-  }
-  pm->setJointOrder(jointNames);
-  pm->setLinkOrder(linkNames);
-  return pm;
+  return PinocchioModel::fromArticulation(*this, {gravity.x, gravity.y, gravity.z});
 }
 #endif
 
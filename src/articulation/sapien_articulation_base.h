@@ -73,6 +73,8 @@ class SArticulationDrivable : public SArticulationBase {
 public:
   virtual void setDriveTarget(const std::vector<physx::PxReal> &v) = 0;
   virtual std::vector<physx::PxReal> getDriveTarget() const = 0;
+  virtual void setDriveVelocityTarget(const std::vector<physx::PxReal> &v) = 0;
+  virtual std::vector<physx::PxReal> getDriveVelocityTarget() const = 0;
 };
 
 } // namespace sapien
@@ -48,6 +48,7 @@ class SJoint : public SJointBase {
   friend class LinkBuilder;
   SArticulation *mArticulation;
   PxArticulationJointReducedCoordinate *mPxJoint;
+  PxReal mVelocityLimit{PX_MAX_F32};
 
 public:
   PxArticulationJointReducedCoordinate *getPxJoint();
@@ -62,6 +63,11 @@ public:
   void setDriveProperty(PxReal stiffness, PxReal damping, PxReal forceLimit = PX_MAX_F32);
 
   PxReal getFriction() const;
+
+  /* maximum joint speed used by planning tools, it does not affect simulation */
+  inline PxReal getVelocityLimit() const { return mVelocityLimit; }
+  inline void setVelocityLimit(PxReal limit) { mVelocityLimit = limit; }
+
   PxReal getDriveStiffness() const;
   PxReal getDriveDamping() const;
   PxReal getDriveForceLimit() const;
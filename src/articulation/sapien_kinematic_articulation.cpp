@@ -3,6 +3,7 @@
 #include "sapien_kinematic_joint.h"
 #include "sapien_link.h"
 #include "sapien_scene.h"
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 #define CHECK_SIZE(v)                                                                             \
@@ -15,6 +16,25 @@
 
 namespace sapien {
 
+void SKJointTable::resize(size_t n) {
+  parent.resize(n, -1);
+  type.resize(n, PxArticulationJointType::eFIX);
+  axis.resize(n, {1, 0, 0});
+  joint2parent.resize(n, PxTransform(PxIdentity));
+  child2joint.resize(n, PxTransform(PxIdentity));
+  pos.resize(n, 0);
+  vel.resize(n, 0);
+  targetPos.resize(n, 0);
+  targetVel.resize(n, 0);
+  stiffness.resize(n, 0);
+  damping.resize(n, 0);
+  maxVel.resize(n, PX_MAX_F32);
+  lowerLimit.resize(n, -PX_MAX_F32);
+  upperLimit.resize(n, PX_MAX_F32);
+  pose.resize(n, PxTransform(PxIdentity));
+  actor.resize(n, nullptr);
+}
+
 std::vector<SLinkBase *> SKArticulation::getBaseLinks() {
   std::vector<SLinkBase *> result;
   result.reserve(mLinks.size());
@@ -110,13 +130,14 @@ void SKArticulation::setQlimits(std::vector<std::array<physx::PxReal, 2>> const
   }
 }
 
+// kinematic joints have at most 1 DOF, write the joint table directly
 void SKArticulation::setDriveTarget(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-  auto it = v.begin();
+  uint32_t i = 0;
   for (auto &j : mJoints) {
-    uint32_t dof = j->getDof();
-    j->setDriveTarget({it, it + dof});
-    it += dof;
+    if (j->getDof()) {
+      mJointTable.targetPos[j->getIndex()] = v[i++];
+    }
   }
 }
 
@@ -124,6 +145,27 @@ std::vector<physx::PxReal> SKArticulation::getDriveTarget() const {
   return std::vector<PxReal>(0, dof());
 }
 
+void SKArticulation::setDriveVelocityTarget(std::vector<physx::PxReal> const &v) {
+  CHECK_SIZE(v);
+  uint32_t i = 0;
+  for (auto &j : mJoints) {
+    if (j->getDof()) {
+      mJointTable.targetVel[j->getIndex()] = v[i++];
+    }
+  }
+}
+
+std::vector<physx::PxReal> SKArticulation::getDriveVelocityTarget() const {
+  std::vector<PxReal> result;
+  result.reserve(mDof);
+  for (auto &j : mJoints) {
+    if (j->getDof()) {
+      result.push_back(mJointTable.targetVel[j->getIndex()]);
+    }
+  }
+  return result;
+}
+
 void SKArticulation::prestep() {
   auto time = mScene->getTimestep();
   EventArticulationStep s;
@@ -138,15 +180,36 @@ void SKArticulation::prestep() {
     l->EventEmitter<EventActorStep>::emit(s);
   }
 
-  std::vector<PxTransform> poses(mJoints.size());
-  poses[mSortedIndices[0]] = mJoints[mSortedIndices[0]]->getChildLink()->getPose();
+  // drive integration over the whole table, fixed joints have zero gains and stay at 0
+  PxReal dt = mScene->getTimestep();
+  auto &t = mJointTable;
+  size_t n = t.size();
+  for (size_t i = 0; i < n; ++i) {
+    PxReal acc = t.stiffness[i] * (t.targetPos[i] - t.pos[i]) +
+                 t.damping[i] * (t.targetVel[i] - t.vel[i]);
+    PxReal vel = std::clamp(t.vel[i] + acc * dt, -t.maxVel[i], t.maxVel[i]);
+    t.vel[i] = vel;
+    t.pos[i] = std::clamp(t.pos[i] + vel * dt, t.lowerLimit[i], t.upperLimit[i]);
+  }
 
-  for (uint32_t n = 1; n < mSortedIndices.size(); ++n) {
-    uint32_t idx = mSortedIndices[n];
-    mJoints[idx]->updatePos(mScene->getTimestep());
-    poses[idx] = poses[mJoints[idx]->getParentLink()->getIndex()] *
-                 mJoints[idx]->getChild2ParentTransform();
-    mLinks[idx]->getPxActor()->setKinematicTarget(poses[idx]);
+  // forward kinematics in topological order
+  int root = mSortedIndices[0];
+  t.pose[root] = t.actor[root]->getGlobalPose();
+  for (size_t k = 1; k < mSortedIndices.size(); ++k) {
+    int i = mSortedIndices[k];
+    PxTransform jointPose(PxIdentity);
+    switch (t.type[i]) {
+    case PxArticulationJointType::eREVOLUTE:
+      jointPose.q = PxQuat(t.pos[i], t.axis[i]);
+      break;
+    case PxArticulationJointType::ePRISMATIC:
+      jointPose.p = t.axis[i] * t.pos[i];
+      break;
+    default:
+      break;
+    }
+    t.pose[i] = t.pose[t.parent[i]] * t.joint2parent[i] * jointPose * t.child2joint[i];
+    t.actor[i]->setKinematicTarget(t.pose[i]);
   }
 }
 
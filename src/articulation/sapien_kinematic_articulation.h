@@ -1,13 +1,44 @@
 #pragma once
 #include "sapien_articulation_base.h"
+#include <PxPhysicsAPI.h>
 #include <memory>
 
 namespace sapien {
+using namespace physx;
 
 class SScene;
 class SKLink;
 class SKJoint;
 
+/* Flat joint table of a kinematic articulation. Row i describes the joint whose child is
+ * link i, the joint of the root link is fixed and has parent -1. SKJoint objects are views
+ * into this table. */
+struct SKJointTable {
+  std::vector<int> parent;
+  std::vector<PxArticulationJointType::Enum> type;
+  std::vector<PxVec3> axis;
+  std::vector<PxTransform> joint2parent;
+  std::vector<PxTransform> child2joint;
+
+  // drive state
+  std::vector<PxReal> pos;
+  std::vector<PxReal> vel;
+  std::vector<PxReal> targetPos;
+  std::vector<PxReal> targetVel;
+  std::vector<PxReal> stiffness;
+  std::vector<PxReal> damping;
+  std::vector<PxReal> maxVel;
+  std::vector<PxReal> lowerLimit;
+  std::vector<PxReal> upperLimit;
+
+  // FK output and targets
+  std::vector<PxTransform> pose;
+  std::vector<PxRigidDynamic *> actor;
+
+  void resize(size_t n);
+  inline size_t size() const { return parent.size(); }
+};
+
 class SKArticulation : public SArticulationDrivable {
   friend class ArticulationBuilder;
   friend class LinkBuilder;
@@ -20,6 +51,7 @@ class SKArticulation : public SArticulationDrivable {
   uint32_t mDof;
 
   std::vector<int> mSortedIndices;
+  SKJointTable mJointTable;
 
 public:
   virtual std::vector<SLinkBase *> getBaseLinks() override;
@@ -47,11 +79,16 @@ public:
 
   virtual void setDriveTarget(std::vector<physx::PxReal> const &v) override;
   virtual std::vector<physx::PxReal> getDriveTarget() const override;
+  virtual void setDriveVelocityTarget(std::vector<physx::PxReal> const &v) override;
+  virtual std::vector<physx::PxReal> getDriveVelocityTarget() const override;
 
   SScene *getScene() const override { return mScene; }
 
   void prestep() override;
 
+  // internal use only
+  inline SKJointTable &getJointTable() { return mJointTable; }
+
   SKArticulation(SKArticulation const &) = delete;
   SKArticulation &operator=(SKArticulation const &) = delete;
   ~SKArticulation() = default;
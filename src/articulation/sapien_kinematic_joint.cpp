@@ -1,68 +1,88 @@
 #include "sapien_kinematic_joint.h"
+#include "sapien_kinematic_articulation.h"
 #include "sapien_link.h"
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 namespace sapien {
 SKJoint::SKJoint(SKArticulation *articulation, SKLink *parent, SKLink *child)
-    : SJointBase(parent, child), mArticulatoin(articulation) {}
+    : SJointBase(parent, child), mArticulation(articulation), mIndex(child->getIndex()) {}
+
+SKJointTable &SKJoint::table() const { return mArticulation->getJointTable(); }
+
+void SKJoint::setParentPose(PxTransform const &pose) { table().joint2parent[mIndex] = pose; }
+
+void SKJoint::setChildPose(PxTransform const &pose) {
+  table().child2joint[mIndex] = pose.getInverse();
+}
+
+PxTransform SKJoint::getParentPose() const { return table().joint2parent[mIndex]; }
+
+PxTransform SKJoint::getChildPose() const { return table().child2joint[mIndex].getInverse(); }
+
+PxTransform SKJoint::getChild2ParentTransform() const {
+  auto &t = table();
+  return t.joint2parent[mIndex] * getJointPose() * t.child2joint[mIndex];
+}
+
+std::vector<PxReal> SKJointSingleDof::getPos() const { return {table().pos[mIndex]}; }
+
+std::vector<PxReal> SKJointSingleDof::getVel() const { return {table().vel[mIndex]}; }
+
+std::vector<std::array<PxReal, 2>> SKJointSingleDof::getLimits() {
+  auto &t = table();
+  return {{t.lowerLimit[mIndex], t.upperLimit[mIndex]}};
+}
 
 void SKJointSingleDof::setLimits(const std::vector<std::array<PxReal, 2>> &limits) {
   if (limits.size() != 1) {
     spdlog::get("SAPIEN")->error("setLimits failed: argument does not match joint DOF");
+    return;
   }
-  lowerLimit = limits[0][0];
-  upperLimit = limits[0][1];
+  auto &t = table();
+  t.lowerLimit[mIndex] = limits[0][0];
+  t.upperLimit[mIndex] = limits[0][1];
 }
 
 void SKJointSingleDof::setPos(const std::vector<PxReal> &v) {
   if (v.size() != 1) {
     spdlog::get("SAPIEN")->error("setPos failed: argument does not match joint DOF");
+    return;
   }
-  pos = v[0];
-  if (pos < lowerLimit) {
-    pos = lowerLimit;
-  } else if (pos > upperLimit) {
-    pos = upperLimit;
-  }
+  auto &t = table();
+  t.pos[mIndex] = std::clamp(v[0], t.lowerLimit[mIndex], t.upperLimit[mIndex]);
 }
 
 void SKJointSingleDof::setVel(const std::vector<PxReal> &v) {
   if (v.size() != 1) {
-    spdlog::get("SAPIEN")->error("setPos failed: argument does not match joint DOF");
+    spdlog::get("SAPIEN")->error("setVel failed: argument does not match joint DOF");
+    return;
   }
-  vel = v[0];
+  table().vel[mIndex] = v[0];
 }
 
 void SKJointSingleDof::setDriveProperties(PxReal accStiffness, PxReal accDamping, PxReal vmax) {
-  stiffness = accStiffness;
-  damping = accDamping;
-  maxVel = vmax;
+  auto &t = table();
+  t.stiffness[mIndex] = accStiffness;
+  t.damping[mIndex] = accDamping;
+  t.maxVel[mIndex] = vmax;
 }
 
 void SKJointSingleDof::setDriveTarget(std::vector<PxReal> const &p) {
   if (p.size() != 1) {
     spdlog::get("SAPIEN")->error("setDriveTarget failed: argument does not match joint DOF");
+    return;
   }
-  targetPos = p[0];
+  table().targetPos[mIndex] = p[0];
 }
+
 void SKJointSingleDof::setDriveVelocityTarget(std::vector<PxReal> const &v) {
   if (v.size() != 1) {
-    spdlog::get("SAPIEN")->error("setDriveVelocityTarget failed: argument does not match joint DOF");
+    spdlog::get("SAPIEN")->error(
+        "setDriveVelocityTarget failed: argument does not match joint DOF");
+    return;
   }
-  targetVel = v[0];
-}
-
-void SKJointSingleDof::updatePos(PxReal dt) {
-  acc = stiffness * (targetPos - pos) + damping * (targetVel - vel);
-  vel += acc * dt;
-  if (vel > maxVel) {
-    vel = maxVel;
-  } else if (vel < -maxVel) {
-    vel = -maxVel;
-  }
-
-  pos += vel * dt;
-  pos = std::clamp(pos, lowerLimit, upperLimit);
+  table().targetVel[mIndex] = v[0];
 }
 
 void SKJointFixed::setLimits(const std::vector<std::array<physx::PxReal, 2>> &limits) {
@@ -84,11 +104,11 @@ void SKJointFixed::setVel(const std::vector<PxReal> &v) {
 }
 
 PxTransform SKJointRevolute::getJointPose() const {
-  return PxTransform({{0, 0, 0}, PxQuat(pos, {1, 0, 0})});
+  return PxTransform({{0, 0, 0}, PxQuat(table().pos[mIndex], {1, 0, 0})});
 }
 
 PxTransform SKJointPrismatic::getJointPose() const {
-  return PxTransform({{pos, 0, 0}, PxIdentity});
+  return PxTransform({{table().pos[mIndex], 0, 0}, PxIdentity});
 }
 
 } // namespace sapien
@@ -4,14 +4,17 @@
 namespace sapien {
 class SKLink;
 class SKArticulation;
+struct SKJointTable;
 
+/* Kinematic joints are views into the joint table of their articulation, see SKJointTable */
 class SKJoint : public SJointBase {
   friend class LinkBuilder;
 
-  SKArticulation *mArticulatoin;
+protected:
+  SKArticulation *mArticulation;
+  uint32_t mIndex; // row in the joint table, equal to the child link index
 
-  PxTransform joint2parent;
-  PxTransform child2joint;
+  SKJointTable &table() const;
 
 public:
   virtual std::vector<PxReal> getPos() const = 0;
@@ -23,61 +26,36 @@ public:
   virtual void setDriveVelocityTarget(std::vector<PxReal> const &v) = 0;
   SKJoint(SKArticulation *articulation, SKLink *parent, SKLink *child);
 
-  void setParentPose(PxTransform const &pose) { joint2parent = pose; }
-  void setChildPose(PxTransform const &pose) { child2joint = pose.getInverse(); }
-
-  virtual inline PxTransform getParentPose() const override { return joint2parent; }
+  void setParentPose(PxTransform const &pose);
+  void setChildPose(PxTransform const &pose);
 
-  virtual inline PxTransform getChildPose() const override { return child2joint.getInverse(); }
+  virtual PxTransform getParentPose() const override;
+  virtual PxTransform getChildPose() const override;
 
   virtual PxTransform getJointPose() const = 0;
-  inline PxTransform getChild2ParentTransform() const {
-    return joint2parent * getJointPose() * child2joint;
-  }
+  PxTransform getChild2ParentTransform() const;
 
-  // update pos by vel
-  virtual void updatePos(PxReal dt) = 0;
+  inline uint32_t getIndex() const { return mIndex; }
 
 public:
-  using SJointBase::SJointBase;
   SKJoint(SKJoint const &) = delete;
   SKJoint &operator=(SKJoint const &) = delete;
   ~SKJoint() = default;
 };
 
 class SKJointSingleDof : public SKJoint {
-protected:
-  PxReal vel = 0;
-  PxReal pos = 0;
-  PxReal lowerLimit;
-  PxReal upperLimit;
-
-  PxReal targetPos = 0;
-  PxReal targetVel = 0;
-
-  PxReal stiffness = 0;
-  PxReal damping = 0;
-  PxReal maxVel = PX_MAX_F32;
-
-  PxReal acc = 0;
-
 public:
-  SKJointSingleDof();
-
   inline uint32_t getDof() const override { return 1; }
-  inline std::vector<PxReal> getPos() const override { return {pos}; }
-  inline std::vector<PxReal> getVel() const override { return {vel}; }
+  std::vector<PxReal> getPos() const override;
+  std::vector<PxReal> getVel() const override;
   void setPos(std::vector<PxReal> const &v) override;
   void setVel(std::vector<PxReal> const &v) override;
-  inline std::vector<std::array<PxReal, 2>> getLimits() override {
-    return {{lowerLimit, upperLimit}};
-  };
+  std::vector<std::array<PxReal, 2>> getLimits() override;
   void setLimits(std::vector<std::array<PxReal, 2>> const &limits) override;
 
   void setDriveProperties(PxReal accStiffness, PxReal accDamping, PxReal maxVel) override;
   void setDriveTarget(std::vector<PxReal> const &p) override;
   void setDriveVelocityTarget(std::vector<PxReal> const &v) override;
-  virtual void updatePos(PxReal dt) override;
 
   virtual inline PxArticulationJointType::Enum getType() const override {
     return PxArticulationJointType::eUNDEFINED;
@@ -100,7 +78,7 @@ public:
 class SKJointPrismatic : public SKJointSingleDof {
 public:
   using SKJointSingleDof::SKJointSingleDof;
-  
+
   virtual inline PxArticulationJointType::Enum getType() const override {
     return PxArticulationJointType::ePRISMATIC;
   };
@@ -121,7 +99,6 @@ public:
   inline void setDriveProperties(PxReal accStiffness, PxReal accDamping, PxReal maxVel) override {}
   inline void setDriveTarget(std::vector<PxReal> const &p) override {}
   inline void setDriveVelocityTarget(std::vector<PxReal> const &v) override {}
-  inline void updatePos(PxReal dt) override{};
 
   inline PxTransform getJointPose() const override { return {{0, 0, 0}, PxIdentity}; }
 
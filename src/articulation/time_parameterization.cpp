@@ -0,0 +1,227 @@
+#include "time_parameterization.h"
+#include "sapien_articulation.h"
+#include "sapien_joint.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+static constexpr double EPS = 1e-9;
+
+TimeParameterization::TimeParameterization(std::vector<PxReal> const &velocityLimits,
+                                           std::vector<PxReal> const &accelerationLimits)
+    : mVelocityLimits(velocityLimits.begin(), velocityLimits.end()),
+      mAccelerationLimits(accelerationLimits.begin(), accelerationLimits.end()) {}
+
+TimeParameterization
+TimeParameterization::fromArticulation(SArticulation *articulation,
+                                       std::vector<PxReal> const &accelerationLimits) {
+  std::vector<PxReal> velocityLimits;
+  for (auto joint : articulation->getSJoints()) {
+    for (uint32_t d = 0; d < joint->getDof(); ++d) {
+      velocityLimits.push_back(joint->getVelocityLimit());
+    }
+  }
+  return TimeParameterization(velocityLimits, accelerationLimits);
+}
+
+bool TimeParameterization::compute(Eigen::MatrixXf const &path, Result &result,
+                                   uint32_t gridPointsPerSegment) const {
+  auto logger = spdlog::get("SAPIEN");
+  uint32_t dof = path.cols();
+  if (mVelocityLimits.size() != dof || mAccelerationLimits.size() != dof) {
+    logger->error("Failed to parameterize path: limits do not match path dimension {}", dof);
+    return false;
+  }
+  for (uint32_t i = 0; i < dof; ++i) {
+    if (!(mVelocityLimits[i] > 0) || !(mAccelerationLimits[i] > 0)) {
+      logger->error("Failed to parameterize path: limits must be positive");
+      return false;
+    }
+  }
+
+  // drop repeated waypoints, the spline needs strictly increasing knots
+  std::vector<Eigen::VectorXd> waypoints;
+  for (Eigen::Index r = 0; r < path.rows(); ++r) {
+    Eigen::VectorXd q = path.row(r).transpose().cast<double>();
+    if (waypoints.empty() || (q - waypoints.back()).norm() > EPS) {
+      waypoints.push_back(q);
+    }
+  }
+  if (waypoints.size() < 2) {
+    if (waypoints.empty()) {
+      logger->error("Failed to parameterize path: path is empty");
+      return false;
+    }
+    result.times = Eigen::VectorXf::Zero(1);
+    result.positions = waypoints[0].transpose().cast<float>();
+    result.velocities = result.accelerations = Eigen::MatrixXf::Zero(1, dof);
+    return true;
+  }
+
+  // natural cubic spline over chord length, M holds second derivatives at knots
+  size_t n = waypoints.size();
+  std::vector<double> knots(n, 0);
+  for (size_t k = 1; k < n; ++k) {
+    knots[k] = knots[k - 1] + (waypoints[k] - waypoints[k - 1]).norm();
+  }
+  std::vector<Eigen::VectorXd> M(n, Eigen::VectorXd::Zero(dof));
+  if (n > 2) {
+    size_t m = n - 2;
+    std::vector<double> lower(m), diag(m), upper(m);
+    std::vector<Eigen::VectorXd> rhs(m);
+    for (size_t j = 0; j < m; ++j) {
+      size_t k = j + 1;
+      double h0 = knots[k] - knots[k - 1];
+      double h1 = knots[k + 1] - knots[k];
+      lower[j] = h0;
+      diag[j] = 2 * (h0 + h1);
+      upper[j] = h1;
+      rhs[j] = 6 * ((waypoints[k + 1] - waypoints[k]) / h1 -
+                    (waypoints[k] - waypoints[k - 1]) / h0);
+    }
+    // Thomas algorithm
+    for (size_t j = 1; j < m; ++j) {
+      double w = lower[j] / diag[j - 1];
+      diag[j] -= w * upper[j - 1];
+      rhs[j] -= w * rhs[j - 1];
+    }
+    M[m] = rhs[m - 1] / diag[m - 1];
+    for (size_t j = m - 1; j-- > 0;) {
+      M[j + 1] = (rhs[j] - upper[j] * M[j + 2]) / diag[j];
+    }
+  }
+
+  // sample the spline on the grid
+  gridPointsPerSegment = std::max(gridPointsPerSegment, 1u);
+  size_t N = (n - 1) * gridPointsPerSegment + 1;
+  std::vector<double> s(N);
+  Eigen::MatrixXd q(dof, N), dq(dof, N), ddq(dof, N);
+  for (size_t g = 0; g < N; ++g) {
+    size_t k = std::min(g / gridPointsPerSegment, n - 2);
+    double h = knots[k + 1] - knots[k];
+    double t = static_cast<double>(g - k * gridPointsPerSegment) / gridPointsPerSegment;
+    s[g] = knots[k] + t * h;
+    double a = h * (1 - t); // s_{k+1} - s
+    double b = h * t;       // s - s_k
+    Eigen::VectorXd c0 = waypoints[k] / h - M[k] * (h / 6);
+    Eigen::VectorXd c1 = waypoints[k + 1] / h - M[k + 1] * (h / 6);
+    q.col(g) = M[k] * (a * a * a / (6 * h)) + M[k + 1] * (b * b * b / (6 * h)) + c0 * a + c1 * b;
+    dq.col(g) = -M[k] * (a * a / (2 * h)) + M[k + 1] * (b * b / (2 * h)) - c0 + c1;
+    ddq.col(g) = M[k] * (a / h) + M[k + 1] * (b / h);
+  }
+
+  // per grid point constraints: x <= xMax, alpha_i x + betaLower_i <= u <= alpha_i x +
+  // betaUpper_i for joints moving along the path
+  std::vector<double> xMax(N, std::numeric_limits<double>::infinity());
+  std::vector<double> alpha(N * dof), betaLower(N * dof), betaUpper(N * dof);
+  std::vector<char> active(N * dof);
+  for (size_t g = 0; g < N; ++g) {
+    for (uint32_t i = 0; i < dof; ++i) {
+      double a = dq(i, g);
+      double b = ddq(i, g);
+      double vmax = mVelocityLimits[i];
+      double amax = mAccelerationLimits[i];
+      size_t idx = g * dof + i;
+      active[idx] = std::abs(a) > EPS;
+      if (active[idx]) {
+        xMax[g] = std::min(xMax[g], (vmax * vmax) / (a * a));
+        alpha[idx] = -b / a;
+        betaLower[idx] = -amax / std::abs(a);
+        betaUpper[idx] = amax / std::abs(a);
+      } else if (std::abs(b) > EPS) {
+        xMax[g] = std::min(xMax[g], amax / std::abs(b));
+      }
+    }
+    // the range of u must be non-empty
+    for (uint32_t i = 0; i < dof; ++i) {
+      for (uint32_t j = 0; j < dof; ++j) {
+        size_t li = g * dof + i, uj = g * dof + j;
+        if (active[li] && active[uj] && alpha[li] > alpha[uj]) {
+          xMax[g] = std::min(xMax[g], (betaUpper[uj] - betaLower[li]) / (alpha[li] - alpha[uj]));
+        }
+      }
+    }
+  }
+
+  auto uMin = [&](size_t g, double x) {
+    double u = -std::numeric_limits<double>::infinity();
+    for (uint32_t i = 0; i < dof; ++i) {
+      size_t idx = g * dof + i;
+      if (active[idx]) {
+        u = std::max(u, alpha[idx] * x + betaLower[idx]);
+      }
+    }
+    return u;
+  };
+  auto uMax = [&](size_t g, double x) {
+    double u = std::numeric_limits<double>::infinity();
+    for (uint32_t i = 0; i < dof; ++i) {
+      size_t idx = g * dof + i;
+      if (active[idx]) {
+        u = std::min(u, alpha[idx] * x + betaUpper[idx]);
+      }
+    }
+    return u;
+  };
+
+  // backward pass: largest x from which the end can still be reached at rest
+  std::vector<double> controllable(N);
+  controllable[N - 1] = 0;
+  for (size_t g = N - 1; g-- > 0;) {
+    double delta = s[g + 1] - s[g];
+    double hi = xMax[g];
+    for (uint32_t i = 0; i < dof; ++i) {
+      size_t idx = g * dof + i;
+      double coeff = 1 + 2 * delta * alpha[idx];
+      // decelerating as hard as allowed must land below the next bound
+      if (active[idx] && coeff > EPS) {
+        hi = std::min(hi, (controllable[g + 1] - 2 * delta * betaLower[idx]) / coeff);
+      }
+    }
+    controllable[g] = std::max(hi, 0.0);
+  }
+
+  // forward pass: maximum acceleration within the controllable sets
+  std::vector<double> x(N), u(N, 0);
+  x[0] = 0;
+  for (size_t g = 0; g + 1 < N; ++g) {
+    double delta = s[g + 1] - s[g];
+    double upper = uMax(g, x[g]);
+    double next = std::isfinite(upper) ? x[g] + 2 * delta * upper : controllable[g + 1];
+    next = std::clamp(next, 0.0, controllable[g + 1]);
+    // stay above the deceleration bound when clamping removed all slack
+    double lowest = x[g] + 2 * delta * uMin(g, x[g]);
+    if (std::isfinite(lowest) && next < lowest) {
+      next = std::min(std::max(lowest, 0.0), controllable[g + 1]);
+    }
+    x[g + 1] = next;
+    u[g] = (x[g + 1] - x[g]) / (2 * delta);
+  }
+  u[N - 1] = u[N - 2];
+
+  result.times.resize(N);
+  result.positions.resize(N, dof);
+  result.velocities.resize(N, dof);
+  result.accelerations.resize(N, dof);
+  double t = 0;
+  for (size_t g = 0; g < N; ++g) {
+    if (g > 0) {
+      double speed = std::sqrt(x[g - 1]) + std::sqrt(x[g]);
+      if (speed < EPS) {
+        logger->error("Failed to parameterize path: path is not traversable within limits");
+        return false;
+      }
+      t += 2 * (s[g] - s[g - 1]) / speed;
+    }
+    result.times[g] = t;
+    result.positions.row(g) = q.col(g).transpose().cast<float>();
+    result.velocities.row(g) = (dq.col(g) * std::sqrt(x[g])).transpose().cast<float>();
+    result.accelerations.row(g) = (ddq.col(g) * x[g] + dq.col(g) * u[g]).transpose().cast<float>();
+  }
+  return true;
+}
+
+} // namespace sapien
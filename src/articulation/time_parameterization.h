@@ -0,0 +1,54 @@
+#pragma once
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulation;
+
+/** Time-optimal parameterization of joint paths under velocity and acceleration limits
+ *
+ *  The waypoints are interpolated by a natural cubic spline over their cumulative chord length
+ *  s. Following TOPP-RA, the squared path speed x = (ds/dt)^2 is bounded on a grid of s by
+ *  a backward pass computing the largest controllable x at every grid point, then a forward
+ *  pass takes the maximum feasible acceleration. All constraints are per grid point and
+ *  linear in (x, u = d^2s/dt^2), so both passes are closed form and run in O(N dof^2). The
+ *  trajectory starts and ends at rest.
+ *
+ *  The result can be played with TrajectoryExecutor using quintic interpolation.
+ */
+class TimeParameterization {
+  std::vector<double> mVelocityLimits;
+  std::vector<double> mAccelerationLimits;
+
+public:
+  struct Result {
+    Eigen::VectorXf times;
+    Eigen::MatrixXf positions;
+    Eigen::MatrixXf velocities;
+    Eigen::MatrixXf accelerations;
+  };
+
+  TimeParameterization(std::vector<PxReal> const &velocityLimits,
+                       std::vector<PxReal> const &accelerationLimits);
+
+  /** velocity limits from SJoint::getVelocityLimit (set from URDF <limit velocity>), URDF has
+   *  no acceleration limits so they are always given */
+  static TimeParameterization fromArticulation(SArticulation *articulation,
+                                               std::vector<PxReal> const &accelerationLimits);
+
+  inline std::vector<double> const &getVelocityLimits() const { return mVelocityLimits; }
+  inline std::vector<double> const &getAccelerationLimits() const { return mAccelerationLimits; }
+
+  /** @param path N x dof waypoints
+   *  @param gridPointsPerSegment grid points per waypoint interval. Limits are only enforced
+   *         at grid points and the spline velocity peaks between waypoints, so 1 can exceed
+   *         the limits between them, more points follow the spline more closely
+   */
+  bool compute(Eigen::MatrixXf const &path, Result &result,
+               uint32_t gridPointsPerSegment = 10) const;
+};
+
+} // namespace sapien
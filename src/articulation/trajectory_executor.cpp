@@ -0,0 +1,224 @@
+#include "trajectory_executor.h"
+#include "sapien_articulation_base.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+TrajectoryExecutor::TrajectoryExecutor(SArticulationDrivable *articulation)
+    : mArticulation(articulation), mDof(articulation->dof()) {
+  mArticulation->EventEmitter<EventArticulationStep>::registerListener(*this);
+  mArticulation->EventEmitter<EventArticulationPreDestroy>::registerListener(*this);
+  mPosBuffer.resize(mDof);
+  mVelBuffer.resize(mDof);
+}
+
+TrajectoryExecutor::~TrajectoryExecutor() {
+  if (mArticulation) {
+    mArticulation->EventEmitter<EventArticulationStep>::unregisterListener(*this);
+    mArticulation->EventEmitter<EventArticulationPreDestroy>::unregisterListener(*this);
+  }
+}
+
+bool TrajectoryExecutor::setTrajectory(Eigen::VectorXf const &times,
+                                       Eigen::MatrixXf const &positions,
+                                       Eigen::MatrixXf const &velocities,
+                                       Eigen::MatrixXf const &accelerations,
+                                       Interpolation interpolation) {
+  auto logger = spdlog::get("SAPIEN");
+  uint32_t n = times.size();
+  if (n == 0 || positions.rows() != n || positions.cols() != mDof) {
+    logger->error("Failed to set trajectory: positions should be {} x {}", n, mDof);
+    return false;
+  }
+  if (velocities.size() && (velocities.rows() != n || velocities.cols() != mDof)) {
+    logger->error("Failed to set trajectory: velocities should be {} x {}", n, mDof);
+    return false;
+  }
+  if (accelerations.size() && (accelerations.rows() != n || accelerations.cols() != mDof)) {
+    logger->error("Failed to set trajectory: accelerations should be {} x {}", n, mDof);
+    return false;
+  }
+  for (uint32_t i = 1; i < n; ++i) {
+    if (times[i] <= times[i - 1]) {
+      logger->error("Failed to set trajectory: time stamps must be strictly increasing");
+      return false;
+    }
+  }
+
+  mInterpolation = interpolation;
+  mTimes.assign(times.data(), times.data() + n);
+  mCoeffs.assign(std::max(n, 2u) * mDof * 6, 0.f);
+
+  if (n == 1) {
+    // a single waypoint is held
+    for (uint32_t d = 0; d < mDof; ++d) {
+      mCoeffs[d * 6] = positions(0, d);
+    }
+  } else if (interpolation == Cubic) {
+    buildCubic(positions, velocities);
+  } else {
+    buildQuintic(positions, velocities, accelerations);
+  }
+
+  mTime = 0;
+  mSegment = 0;
+  mRunning = true;
+  return true;
+}
+
+void TrajectoryExecutor::buildCubic(Eigen::MatrixXf const &positions,
+                                    Eigen::MatrixXf const &velocities) {
+  uint32_t n = mTimes.size();
+  Eigen::MatrixXf vel = velocities;
+
+  if (!vel.size()) {
+    // C2 spline starting and ending at rest, tridiagonal system for knot velocities
+    vel = Eigen::MatrixXf::Zero(n, mDof);
+    if (n > 2) {
+      uint32_t m = n - 2;
+      std::vector<float> lower(m), diag(m), upper(m);
+      Eigen::MatrixXf rhs(m, mDof);
+      for (uint32_t k = 0; k < m; ++k) {
+        uint32_t i = k + 1;
+        float h0 = mTimes[i] - mTimes[i - 1];
+        float h1 = mTimes[i + 1] - mTimes[i];
+        lower[k] = h1;
+        diag[k] = 2 * (h0 + h1);
+        upper[k] = h0;
+        rhs.row(k) = 3 * (h1 * (positions.row(i) - positions.row(i - 1)) / h0 +
+                          h0 * (positions.row(i + 1) - positions.row(i)) / h1);
+      }
+      // Thomas algorithm
+      for (uint32_t k = 1; k < m; ++k) {
+        float w = lower[k] / diag[k - 1];
+        diag[k] -= w * upper[k - 1];
+        rhs.row(k) -= w * rhs.row(k - 1);
+      }
+      vel.row(m) = rhs.row(m - 1) / diag[m - 1];
+      for (int k = m - 2; k >= 0; --k) {
+        vel.row(k + 1) = (rhs.row(k) - upper[k] * vel.row(k + 2)) / diag[k];
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i + 1 < n; ++i) {
+    float h = mTimes[i + 1] - mTimes[i];
+    for (uint32_t d = 0; d < mDof; ++d) {
+      float p0 = positions(i, d), p1 = positions(i + 1, d);
+      float v0 = vel(i, d), v1 = vel(i + 1, d);
+      float *c = &mCoeffs[(i * mDof + d) * 6];
+      c[0] = p0;
+      c[1] = v0;
+      c[2] = (3 * (p1 - p0) / h - 2 * v0 - v1) / h;
+      c[3] = (2 * (p0 - p1) / h + v0 + v1) / (h * h);
+    }
+  }
+}
+
+void TrajectoryExecutor::buildQuintic(Eigen::MatrixXf const &positions,
+                                      Eigen::MatrixXf const &velocities,
+                                      Eigen::MatrixXf const &accelerations) {
+  uint32_t n = mTimes.size();
+  Eigen::MatrixXf vel = velocities;
+  Eigen::MatrixXf acc = accelerations;
+
+  if (!vel.size()) {
+    // weighted average of neighbouring slopes, at rest on both ends
+    vel = Eigen::MatrixXf::Zero(n, mDof);
+    for (uint32_t i = 1; i + 1 < n; ++i) {
+      float h0 = mTimes[i] - mTimes[i - 1];
+      float h1 = mTimes[i + 1] - mTimes[i];
+      vel.row(i) = (h1 * (positions.row(i) - positions.row(i - 1)) / h0 +
+                    h0 * (positions.row(i + 1) - positions.row(i)) / h1) /
+                   (h0 + h1);
+    }
+  }
+  if (!acc.size()) {
+    acc = Eigen::MatrixXf::Zero(n, mDof);
+  }
+
+  for (uint32_t i = 0; i + 1 < n; ++i) {
+    float h = mTimes[i + 1] - mTimes[i];
+    float h2 = h * h, h3 = h2 * h;
+    for (uint32_t d = 0; d < mDof; ++d) {
+      float dp = positions(i + 1, d) - positions(i, d);
+      float v0 = vel(i, d), v1 = vel(i + 1, d);
+      float a0 = acc(i, d), a1 = acc(i + 1, d);
+      float *c = &mCoeffs[(i * mDof + d) * 6];
+      c[0] = positions(i, d);
+      c[1] = v0;
+      c[2] = a0 / 2;
+      c[3] = (20 * dp - (8 * v1 + 12 * v0) * h - (3 * a0 - a1) * h2) / (2 * h3);
+      c[4] = (-30 * dp + (14 * v1 + 16 * v0) * h + (3 * a0 - 2 * a1) * h2) / (2 * h3 * h);
+      c[5] = (12 * dp - 6 * (v1 + v0) * h - (a0 - a1) * h2) / (2 * h3 * h2);
+    }
+  }
+}
+
+void TrajectoryExecutor::start() { mRunning = !mTimes.empty(); }
+
+void TrajectoryExecutor::stop() { mRunning = false; }
+
+bool TrajectoryExecutor::isFinished() const { return mTime >= getDuration(); }
+
+void TrajectoryExecutor::setTime(PxReal t) {
+  mTime = t;
+  mSegment = 0;
+}
+
+PxReal TrajectoryExecutor::getDuration() const {
+  return mTimes.empty() ? 0 : mTimes.back() - mTimes.front();
+}
+
+void TrajectoryExecutor::evaluate(PxReal t, std::vector<PxReal> &pos, std::vector<PxReal> &vel) {
+  pos.resize(mDof);
+  vel.resize(mDof);
+  if (mTimes.empty()) {
+    return;
+  }
+
+  uint32_t nSegments = std::max<uint32_t>(mTimes.size(), 2) - 1;
+  t = std::clamp(t, mTimes.front(), mTimes.back());
+
+  // time usually moves forward, so continue the search from the last segment
+  if (mSegment >= nSegments || t < mTimes[mSegment]) {
+    mSegment = 0;
+  }
+  while (mSegment + 1 < nSegments && t >= mTimes[mSegment + 1]) {
+    ++mSegment;
+  }
+
+  float s = mTimes.size() > 1 ? t - mTimes[mSegment] : 0.f;
+  for (uint32_t d = 0; d < mDof; ++d) {
+    float const *c = &mCoeffs[(mSegment * mDof + d) * 6];
+    pos[d] = c[0] + s * (c[1] + s * (c[2] + s * (c[3] + s * (c[4] + s * c[5]))));
+    vel[d] = c[1] + s * (2 * c[2] + s * (3 * c[3] + s * (4 * c[4] + s * 5 * c[5])));
+  }
+  if (mTimes.size() > 1 && t >= mTimes.back()) {
+    std::fill(vel.begin(), vel.end(), 0.f);
+  }
+}
+
+void TrajectoryExecutor::applyTargets() {
+  mArticulation->setDriveTarget(mPosBuffer);
+  mArticulation->setDriveVelocityTarget(mVelBuffer);
+}
+
+void TrajectoryExecutor::onEvent(EventArticulationStep &event) {
+  if (!mRunning || !mArticulation || mTimes.empty()) {
+    return;
+  }
+  // sample the target for the end of this step
+  mTime += event.time;
+  evaluate(mTimes.front() + mTime, mPosBuffer, mVelBuffer);
+  applyTargets();
+}
+
+void TrajectoryExecutor::onEvent(EventArticulationPreDestroy &event) {
+  // listeners die with the articulation, unregistering here would break the emit loop
+  mArticulation = nullptr;
+  mRunning = false;
+}
+
+} // namespace sapien
@@ -0,0 +1,86 @@
+#pragma once
+#include "event_system/event_system.h"
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+class SArticulationDrivable;
+
+/** Plays a time-stamped joint space trajectory on an articulation
+ *
+ *  Waypoints are turned into piecewise cubic or quintic polynomials. On every articulation
+ *  step the executor advances its clock by the scene timestep and writes the sampled position
+ *  and velocity as drive targets of a dynamic or kinematic articulation. After the last
+ *  waypoint the final position is held.
+ */
+class TrajectoryExecutor : public IEventListener<EventArticulationStep>,
+                           public IEventListener<EventArticulationPreDestroy> {
+public:
+  enum Interpolation { Cubic, Quintic };
+
+private:
+  SArticulationDrivable *mArticulation;
+  uint32_t mDof;
+
+  Interpolation mInterpolation{Cubic};
+  std::vector<PxReal> mTimes;
+  // per segment, per dof, 6 polynomial coefficients in increasing order of (t - t_i)
+  std::vector<PxReal> mCoeffs;
+
+  PxReal mTime{0};
+  uint32_t mSegment{0};
+  bool mRunning{false};
+
+  std::vector<PxReal> mPosBuffer;
+  std::vector<PxReal> mVelBuffer;
+
+public:
+  explicit TrajectoryExecutor(SArticulationDrivable *articulation);
+  TrajectoryExecutor(TrajectoryExecutor const &other) = delete;
+  TrajectoryExecutor &operator=(TrajectoryExecutor const &other) = delete;
+  ~TrajectoryExecutor();
+
+  /** Set the trajectory, it starts playing on the next step
+   *
+   *  @param times strictly increasing time stamps of size N, played from times[0]
+   *  @param positions N x dof waypoints
+   *  @param velocities N x dof waypoint velocities, optional. When empty, cubic trajectories
+   *         use a C2 spline starting and ending at rest and quintic ones estimate velocities
+   *         from neighbouring waypoints
+   *  @param accelerations N x dof waypoint accelerations for quintic interpolation, optional,
+   *         zero when empty
+   */
+  bool setTrajectory(Eigen::VectorXf const &times, Eigen::MatrixXf const &positions,
+                     Eigen::MatrixXf const &velocities = {},
+                     Eigen::MatrixXf const &accelerations = {},
+                     Interpolation interpolation = Cubic);
+
+  void start();
+  void stop();
+  inline bool isRunning() const { return mRunning; }
+  bool isFinished() const;
+
+  /* Time since times[0] */
+  inline PxReal getTime() const { return mTime; }
+  void setTime(PxReal t);
+  PxReal getDuration() const;
+
+  /* Sample the trajectory at time stamp t, clamped to [times[0], times[N-1]] */
+  void evaluate(PxReal t, std::vector<PxReal> &pos, std::vector<PxReal> &vel);
+
+  inline SArticulationDrivable *getArticulation() const { return mArticulation; }
+
+  void onEvent(EventArticulationStep &event) override;
+  void onEvent(EventArticulationPreDestroy &event) override;
+
+private:
+  void buildCubic(Eigen::MatrixXf const &positions, Eigen::MatrixXf const &velocities);
+  void buildQuintic(Eigen::MatrixXf const &positions, Eigen::MatrixXf const &velocities,
+                    Eigen::MatrixXf const &accelerations);
+  void applyTargets();
+};
+
+} // namespace sapien
@@ -327,7 +327,16 @@ URDFLoader::parseRobotDescription(XMLDocument const &urdfDoc, XMLDocument const
         }
         break;
       case Geometry::MESH:
-        if (multipleMeshesInOneFile) {
+        if (isKinematic && nonConvexKinematicCollision) {
+          currentLinkBuilder->addNonConvexShapeFromFile(
+              getAbsPath(urdfFilename, collision->geometry->filename), tCollision2Link,
+              collision->geometry->scale * scale, material, patchRadius, minPatchRadius);
+        } else if (decomposeCollision) {
+          currentLinkBuilder->addDecomposedConvexShapesFromFile(
+              getAbsPath(urdfFilename, collision->geometry->filename), tCollision2Link,
+              collision->geometry->scale * scale, material, density, patchRadius, minPatchRadius,
+              decompositionParams);
+        } else if (multipleMeshesInOneFile) {
           currentLinkBuilder->addMultipleConvexShapesFromFile(
               getAbsPath(urdfFilename, collision->geometry->filename), tCollision2Link,
               collision->geometry->scale * scale, material, density, patchRadius, minPatchRadius);
@@ -402,6 +411,13 @@ URDFLoader::parseRobotDescription(XMLDocument const &urdfDoc, XMLDocument const
         std::cerr << "Unreconized joint type: " + current->joint->type << std::endl;
         exit(1);
       }
+
+      // 0 means the velocity limit is not given
+      if (current->joint->limit && current->joint->limit->velocity > 0) {
+        PxReal velocity = current->joint->limit->velocity;
+        currentLinkBuilder->setJointVelocityLimit(
+            current->joint->type == "prismatic" ? velocity * scale : velocity);
+      }
     }
 
     for (auto c : current->children) {
@@ -546,7 +562,7 @@ SKArticulation *URDFLoader::loadKinematic(const std::string &filename, URDFConfi
     return nullptr;
   }
 
-  auto [builder, records] = parseRobotDescription(urdfDoc, srdfDoc.get(), filename, false, config);
+  auto [builder, records] = parseRobotDescription(urdfDoc, srdfDoc.get(), filename, true, config);
   auto articulation = builder->buildKinematic();
 
   for (auto &record : records) {
@@ -1,4 +1,5 @@
 #pragma once
+#include "convex_decomposition.h"
 #include <PxPhysicsAPI.h>
 #include <iostream>
 #include <map>
@@ -712,6 +713,15 @@ public:
   bool fixRootLink = true;
 
   bool multipleMeshesInOneFile = false;
+
+  /* Mesh collisions of kinematic articulations (loadKinematic) are loaded as exact triangle
+   * meshes. Dynamic articulation links cannot use triangle meshes and ignore this flag */
+  bool nonConvexKinematicCollision = false;
+
+  /* Mesh collisions are loaded as the hulls of an approximate convex decomposition, computed
+   * on the first load and cached on disk. Takes precedence over multipleMeshesInOneFile */
+  bool decomposeCollision = false;
+  ConvexDecompositionParams decompositionParams;
   /* The loaded articulation will use inverse dynamics to balance passive forces,
    * it will act as if there is no gravity, etc.
    */
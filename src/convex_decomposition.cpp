@@ -0,0 +1,580 @@
+#include "convex_decomposition.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+namespace sapien {
+using namespace physx;
+
+// hull volumes are estimated on the extreme points of the part along these directions
+static constexpr uint32_t N_DIRECTIONS = 64;
+// weight of the volume difference of the halves when choosing a split plane
+static constexpr double BALANCE_WEIGHT = 0.05;
+
+static std::array<Eigen::Vector3d, N_DIRECTIONS> const &getDirections() {
+  // Fibonacci sphere
+  static std::array<Eigen::Vector3d, N_DIRECTIONS> directions = [] {
+    std::array<Eigen::Vector3d, N_DIRECTIONS> d;
+    double golden = M_PI * (3.0 - std::sqrt(5.0));
+    for (uint32_t i = 0; i < N_DIRECTIONS; ++i) {
+      double z = 1.0 - (2.0 * i + 1.0) / N_DIRECTIONS;
+      double r = std::sqrt(1.0 - z * z);
+      d[i] = {r * std::cos(golden * i), r * std::sin(golden * i), z};
+    }
+    return d;
+  }();
+  return directions;
+}
+
+/* Volume of the convex hull of a small point set, built incrementally */
+static double convexHullVolume(std::vector<Eigen::Vector3d> const &points) {
+  uint32_t n = points.size();
+  if (n < 4) {
+    return 0;
+  }
+
+  // initial tetrahedron from extreme points
+  uint32_t i0 = 0;
+  for (uint32_t i = 1; i < n; ++i) {
+    if (points[i].x() < points[i0].x()) {
+      i0 = i;
+    }
+  }
+  uint32_t i1 = i0;
+  double best = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    double d = (points[i] - points[i0]).squaredNorm();
+    if (d > best) {
+      best = d;
+      i1 = i;
+    }
+  }
+  double eps = 1e-9 * std::sqrt(best);
+  if (best == 0) {
+    return 0;
+  }
+  Eigen::Vector3d axis = (points[i1] - points[i0]).normalized();
+  uint32_t i2 = i0;
+  best = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    Eigen::Vector3d v = points[i] - points[i0];
+    double d = (v - v.dot(axis) * axis).norm();
+    if (d > best) {
+      best = d;
+      i2 = i;
+    }
+  }
+  if (best < eps) {
+    return 0;
+  }
+  Eigen::Vector3d normal = axis.cross(points[i2] - points[i0]).normalized();
+  uint32_t i3 = i0;
+  best = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    double d = std::abs(normal.dot(points[i] - points[i0]));
+    if (d > best) {
+      best = d;
+      i3 = i;
+    }
+  }
+  if (best < eps) {
+    return 0;
+  }
+
+  struct Face {
+    uint32_t v[3];
+    Eigen::Vector3d normal;
+    double offset;
+  };
+  std::vector<Face> faces;
+  auto addFace = [&](uint32_t a, uint32_t b, uint32_t c) {
+    Eigen::Vector3d normal = (points[b] - points[a]).cross(points[c] - points[a]);
+    double length = normal.norm();
+    // degenerate faces are never visible and have no volume
+    normal = length > 0 ? Eigen::Vector3d(normal / length) : Eigen::Vector3d::Zero();
+    faces.push_back({{a, b, c}, normal, normal.dot(points[a])});
+  };
+  Eigen::Vector3d center = (points[i0] + points[i1] + points[i2] + points[i3]) / 4;
+  uint32_t tetrahedron[4][3] = {{i0, i1, i2}, {i0, i1, i3}, {i0, i2, i3}, {i1, i2, i3}};
+  for (auto &t : tetrahedron) {
+    uint32_t a = t[0], b = t[1], c = t[2];
+    if ((points[b] - points[a]).cross(points[c] - points[a]).dot(center - points[a]) > 0) {
+      std::swap(b, c);
+    }
+    addFace(a, b, c);
+  }
+
+  auto edgeKey = [](uint32_t a, uint32_t b) { return (uint64_t(a) << 32) | b; };
+  std::vector<char> visible;
+  std::unordered_set<uint64_t> visibleEdges;
+  std::vector<std::pair<uint32_t, uint32_t>> horizon;
+  for (uint32_t k = 0; k < n; ++k) {
+    if (k == i0 || k == i1 || k == i2 || k == i3) {
+      continue;
+    }
+    visible.assign(faces.size(), 0);
+    visibleEdges.clear();
+    for (uint32_t f = 0; f < faces.size(); ++f) {
+      if (faces[f].normal.dot(points[k]) - faces[f].offset > eps) {
+        visible[f] = 1;
+        for (int e = 0; e < 3; ++e) {
+          visibleEdges.insert(edgeKey(faces[f].v[e], faces[f].v[(e + 1) % 3]));
+        }
+      }
+    }
+    if (visibleEdges.empty()) {
+      continue;
+    }
+    // edges of visible faces whose twin is not visible bound the hole to cap with the point
+    horizon.clear();
+    std::vector<Face> kept;
+    kept.reserve(faces.size());
+    for (uint32_t f = 0; f < faces.size(); ++f) {
+      if (!visible[f]) {
+        kept.push_back(faces[f]);
+        continue;
+      }
+      for (int e = 0; e < 3; ++e) {
+        uint32_t a = faces[f].v[e];
+        uint32_t b = faces[f].v[(e + 1) % 3];
+        if (!visibleEdges.count(edgeKey(b, a))) {
+          horizon.push_back({a, b});
+        }
+      }
+    }
+    faces = std::move(kept);
+    for (auto [a, b] : horizon) {
+      addFace(a, b, k);
+    }
+  }
+
+  double volume = 0;
+  for (auto &f : faces) {
+    volume += (points[f.v[0]] - center)
+                  .dot((points[f.v[1]] - center).cross(points[f.v[2]] - center));
+  }
+  return volume / 6;
+}
+
+namespace {
+
+struct Voxel {
+  uint32_t coord[3];
+  int32_t surface; // index of the surface samples, -1 for interior voxels
+};
+
+struct Part {
+  std::vector<uint32_t> voxels;
+  double concavity;
+  bool final;
+};
+
+class Decomposer {
+  ConvexDecompositionParams mParams;
+  PxVec3 mOrigin;
+  PxReal mVoxelSize;
+  double mVoxelVolume;
+  uint32_t mDims[3];
+
+  std::vector<Voxel> mVoxels;
+  // voxel of every grid cell, -1 outside
+  std::vector<int32_t> mVoxelOf;
+  // bounds of the surface samples in every surface voxel
+  std::vector<PxBounds3> mSamples;
+
+public:
+  explicit Decomposer(ConvexDecompositionParams const &params) : mParams(params) {
+    mParams.resolution = std::max(mParams.resolution, 8u);
+    mParams.maxHulls = std::max(mParams.maxHulls, 1u);
+    mParams.planeDownsampling = std::max(mParams.planeDownsampling, 1u);
+  }
+
+  std::vector<std::vector<PxVec3>> run(std::vector<PxVec3> const &vertices,
+                                       std::vector<uint32_t> const &triangles,
+                                       utils::ThreadPool *pool) {
+    if (!voxelize(vertices, triangles)) {
+      // flat or degenerate meshes are kept as a single hull
+      if (vertices.empty()) {
+        return {};
+      }
+      return {vertices};
+    }
+    std::vector<Part> parts = components();
+    double volume = 0;
+    for (auto &part : parts) {
+      volume += part.voxels.size() * mVoxelVolume;
+      part.concavity = concavity(part.voxels);
+      part.final = false;
+    }
+    double threshold = mParams.concavity * volume;
+
+    while (parts.size() < mParams.maxHulls) {
+      std::vector<uint32_t> selected;
+      for (uint32_t i = 0; i < parts.size(); ++i) {
+        if (!parts[i].final && parts[i].concavity > threshold) {
+          selected.push_back(i);
+        }
+      }
+      if (selected.empty()) {
+        break;
+      }
+      // most concave first, every split adds one part
+      std::sort(selected.begin(), selected.end(), [&](uint32_t a, uint32_t b) {
+        return parts[a].concavity > parts[b].concavity;
+      });
+      selected.resize(std::min<size_t>(selected.size(), mParams.maxHulls - parts.size()));
+
+      std::vector<std::array<Part, 2>> halves(selected.size());
+      std::vector<char> split(selected.size(), 0);
+      auto task = [&](size_t i, uint32_t) {
+        split[i] = splitPart(parts[selected[i]], halves[i]);
+      };
+      if (pool && selected.size() > 1) {
+        pool->parallelFor(0, selected.size(), task);
+      } else {
+        for (size_t i = 0; i < selected.size(); ++i) {
+          task(i, 0);
+        }
+      }
+      for (size_t i = 0; i < selected.size(); ++i) {
+        if (split[i]) {
+          parts[selected[i]] = std::move(halves[i][0]);
+          parts.push_back(std::move(halves[i][1]));
+        } else {
+          parts[selected[i]].final = true;
+        }
+      }
+    }
+
+    std::vector<std::vector<PxVec3>> hulls;
+    for (auto &part : parts) {
+      hulls.push_back(hullPoints(part.voxels));
+    }
+    return hulls;
+  }
+
+private:
+  inline uint32_t index(uint32_t x, uint32_t y, uint32_t z) const {
+    return (z * mDims[1] + y) * mDims[0] + x;
+  }
+
+  bool voxelize(std::vector<PxVec3> const &vertices, std::vector<uint32_t> const &triangles) {
+    PxBounds3 bounds = PxBounds3::empty();
+    for (auto &v : vertices) {
+      bounds.include(v);
+    }
+    PxVec3 extents = bounds.getDimensions();
+    PxReal longest = extents.maxElement();
+    if (vertices.empty() || triangles.empty() || !(longest > 0)) {
+      return false;
+    }
+    mVoxelSize = longest / mParams.resolution;
+    mVoxelVolume = double(mVoxelSize) * mVoxelSize * mVoxelSize;
+    // one voxel of padding on every side keeps the outside connected
+    mOrigin = bounds.minimum - PxVec3(mVoxelSize);
+    for (int a = 0; a < 3; ++a) {
+      mDims[a] = static_cast<uint32_t>(extents[a] / mVoxelSize) + 3;
+    }
+    uint32_t total = mDims[0] * mDims[1] * mDims[2];
+
+    // sample triangles at half the voxel size
+    std::vector<int32_t> surfaceOf(total, -1);
+    auto mark = [&](PxVec3 const &p) {
+      uint32_t c[3];
+      for (int a = 0; a < 3; ++a) {
+        int v = static_cast<int>(std::floor((p[a] - mOrigin[a]) / mVoxelSize));
+        c[a] = std::clamp<int>(v, 1, mDims[a] - 2);
+      }
+      uint32_t i = index(c[0], c[1], c[2]);
+      if (surfaceOf[i] < 0) {
+        surfaceOf[i] = mSamples.size();
+        mSamples.push_back(PxBounds3::empty());
+      }
+      mSamples[surfaceOf[i]].include(p);
+    };
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+      PxVec3 a = vertices[triangles[t]];
+      PxVec3 ab = vertices[triangles[t + 1]] - a;
+      PxVec3 ac = vertices[triangles[t + 2]] - a;
+      PxReal edge = std::max({ab.magnitude(), ac.magnitude(), (ac - ab).magnitude()});
+      uint32_t k = std::max(1u, static_cast<uint32_t>(std::ceil(edge / (0.5f * mVoxelSize))));
+      for (uint32_t i = 0; i <= k; ++i) {
+        for (uint32_t j = 0; i + j <= k; ++j) {
+          mark(a + ab * (PxReal(i) / k) + ac * (PxReal(j) / k));
+        }
+      }
+    }
+
+    // flood the outside from a padding corner, what is neither outside nor surface is inside
+    std::vector<char> outside(total, 0);
+    std::vector<uint32_t> stack{0};
+    outside[0] = 1;
+    while (!stack.empty()) {
+      uint32_t i = stack.back();
+      stack.pop_back();
+      uint32_t c[3] = {i % mDims[0], (i / mDims[0]) % mDims[1], i / (mDims[0] * mDims[1])};
+      for (int a = 0; a < 3; ++a) {
+        for (int s = -1; s <= 1; s += 2) {
+          int v = static_cast<int>(c[a]) + s;
+          if (v < 0 || v >= static_cast<int>(mDims[a])) {
+            continue;
+          }
+          uint32_t n[3] = {c[0], c[1], c[2]};
+          n[a] = v;
+          uint32_t j = index(n[0], n[1], n[2]);
+          if (!outside[j] && surfaceOf[j] < 0) {
+            outside[j] = 1;
+            stack.push_back(j);
+          }
+        }
+      }
+    }
+
+    mVoxelOf.assign(total, -1);
+    for (uint32_t z = 0; z < mDims[2]; ++z) {
+      for (uint32_t y = 0; y < mDims[1]; ++y) {
+        for (uint32_t x = 0; x < mDims[0]; ++x) {
+          uint32_t i = index(x, y, z);
+          if (!outside[i]) {
+            mVoxelOf[i] = mVoxels.size();
+            mVoxels.push_back({{x, y, z}, surfaceOf[i]});
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  /* 26-connected voxel components, thin shells are often only diagonally connected */
+  std::vector<Part> components() {
+    std::vector<Part> parts;
+    std::vector<char> visited(mVoxels.size(), 0);
+    for (uint32_t start = 0; start < mVoxels.size(); ++start) {
+      if (visited[start]) {
+        continue;
+      }
+      parts.push_back({});
+      auto &voxels = parts.back().voxels;
+      std::vector<uint32_t> stack{start};
+      visited[start] = 1;
+      while (!stack.empty()) {
+        uint32_t v = stack.back();
+        stack.pop_back();
+        voxels.push_back(v);
+        auto &c = mVoxels[v].coord;
+        // solid voxels are never in the padding, neighbours are in the grid
+        for (int dz = -1; dz <= 1; ++dz) {
+          for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+              int32_t w = mVoxelOf[index(c[0] + dx, c[1] + dy, c[2] + dz)];
+              if (w >= 0 && !visited[w]) {
+                visited[w] = 1;
+                stack.push_back(w);
+              }
+            }
+          }
+        }
+      }
+    }
+    return parts;
+  }
+
+  /* point estimating the surface in a voxel, the voxel center inside */
+  Eigen::Vector3d samplePoint(uint32_t v) const {
+    auto &voxel = mVoxels[v];
+    PxVec3 p = voxel.surface >= 0
+                   ? mSamples[voxel.surface].getCenter()
+                   : mOrigin + PxVec3(voxel.coord[0] + 0.5f, voxel.coord[1] + 0.5f,
+                                      voxel.coord[2] + 0.5f) *
+                                   mVoxelSize;
+    return {p.x, p.y, p.z};
+  }
+
+  /* surface voxels of a part, or all its voxels if it has none */
+  std::vector<uint32_t> boundary(std::vector<uint32_t> const &voxels) const {
+    std::vector<uint32_t> result;
+    for (auto v : voxels) {
+      if (mVoxels[v].surface >= 0) {
+        result.push_back(v);
+      }
+    }
+    return result.empty() ? voxels : result;
+  }
+
+  double concavity(std::vector<uint32_t> const &voxels) const {
+    auto &directions = getDirections();
+    std::vector<Eigen::Vector3d> points;
+    for (auto v : boundary(voxels)) {
+      points.push_back(samplePoint(v));
+    }
+    std::vector<uint32_t> extreme;
+    for (auto &d : directions) {
+      uint32_t best = 0;
+      for (uint32_t i = 1; i < points.size(); ++i) {
+        if (points[i].dot(d) > points[best].dot(d)) {
+          best = i;
+        }
+      }
+      extreme.push_back(best);
+    }
+    std::sort(extreme.begin(), extreme.end());
+    extreme.erase(std::unique(extreme.begin(), extreme.end()), extreme.end());
+    std::vector<Eigen::Vector3d> hull;
+    for (auto i : extreme) {
+      hull.push_back(points[i]);
+    }
+    return std::max(0.0, convexHullVolume(hull) - voxels.size() * mVoxelVolume);
+  }
+
+  /** Split a part along the best axis aligned plane
+   *
+   *  For every axis, the extreme points of all prefixes and suffixes of voxel layers are
+   *  accumulated once, so every candidate plane only costs two small hulls.
+   */
+  bool splitPart(Part const &part, std::array<Part, 2> &halves) const {
+    auto &directions = getDirections();
+    std::vector<uint32_t> surface = boundary(part.voxels);
+    std::vector<Eigen::Vector3d> points;
+    for (auto v : surface) {
+      points.push_back(samplePoint(v));
+    }
+
+    double bestCost = std::numeric_limits<double>::infinity();
+    int bestAxis = -1;
+    uint32_t bestPlane = 0;
+    double bestConcavity[2] = {0, 0};
+
+    for (int axis = 0; axis < 3; ++axis) {
+      uint32_t lo = std::numeric_limits<uint32_t>::max();
+      uint32_t hi = 0;
+      for (auto v : part.voxels) {
+        lo = std::min(lo, mVoxels[v].coord[axis]);
+        hi = std::max(hi, mVoxels[v].coord[axis]);
+      }
+      if (hi == lo) {
+        continue;
+      }
+      uint32_t layers = hi - lo + 1;
+      std::vector<uint32_t> counts(layers, 0);
+      for (auto v : part.voxels) {
+        counts[mVoxels[v].coord[axis] - lo] += 1;
+      }
+
+      // extreme point of every layer along every direction, -1 for layers without points
+      std::vector<std::array<int32_t, N_DIRECTIONS>> layerBest(layers);
+      for (auto &b : layerBest) {
+        b.fill(-1);
+      }
+      for (uint32_t i = 0; i < points.size(); ++i) {
+        auto &b = layerBest[mVoxels[surface[i]].coord[axis] - lo];
+        for (uint32_t k = 0; k < N_DIRECTIONS; ++k) {
+          if (b[k] < 0 || points[i].dot(directions[k]) > points[b[k]].dot(directions[k])) {
+            b[k] = i;
+          }
+        }
+      }
+      auto better = [&](int32_t a, int32_t b, uint32_t k) {
+        if (a < 0) {
+          return b;
+        }
+        if (b < 0) {
+          return a;
+        }
+        return points[a].dot(directions[k]) >= points[b].dot(directions[k]) ? a : b;
+      };
+      auto prefix = layerBest;
+      auto suffix = layerBest;
+      for (uint32_t l = 1; l < layers; ++l) {
+        for (uint32_t k = 0; k < N_DIRECTIONS; ++k) {
+          prefix[l][k] = better(prefix[l][k], prefix[l - 1][k], k);
+          suffix[layers - 1 - l][k] = better(suffix[layers - 1 - l][k], suffix[layers - l][k], k);
+        }
+      }
+      auto hullConcavity = [&](std::array<int32_t, N_DIRECTIONS> const &best, double volume) {
+        std::vector<int32_t> extreme(best.begin(), best.end());
+        std::sort(extreme.begin(), extreme.end());
+        extreme.erase(std::unique(extreme.begin(), extreme.end()), extreme.end());
+        std::vector<Eigen::Vector3d> hull;
+        for (auto i : extreme) {
+          if (i >= 0) {
+            hull.push_back(points[i]);
+          }
+        }
+        return std::max(0.0, convexHullVolume(hull) - volume);
+      };
+
+      uint32_t leftCount = 0;
+      for (uint32_t plane = 1; plane < layers; ++plane) {
+        leftCount += counts[plane - 1];
+        if (plane % mParams.planeDownsampling != 0 && layers > mParams.planeDownsampling) {
+          continue;
+        }
+        if (prefix[plane - 1][0] < 0 || suffix[plane][0] < 0) {
+          continue;
+        }
+        double leftVolume = leftCount * mVoxelVolume;
+        double rightVolume = (part.voxels.size() - leftCount) * mVoxelVolume;
+        double left = hullConcavity(prefix[plane - 1], leftVolume);
+        double right = hullConcavity(suffix[plane], rightVolume);
+        double cost = left + right + BALANCE_WEIGHT * std::abs(leftVolume - rightVolume);
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestPlane = lo + plane;
+          bestConcavity[0] = left;
+          bestConcavity[1] = right;
+        }
+      }
+    }
+    if (bestAxis < 0) {
+      return false;
+    }
+
+    for (int h = 0; h < 2; ++h) {
+      halves[h].voxels.clear();
+      halves[h].concavity = bestConcavity[h];
+      halves[h].final = false;
+    }
+    for (auto v : part.voxels) {
+      halves[mVoxels[v].coord[bestAxis] < bestPlane ? 0 : 1].voxels.push_back(v);
+    }
+    return true;
+  }
+
+  /* corners of the surface sample bounds, or of the voxels of a part without surface */
+  std::vector<PxVec3> hullPoints(std::vector<uint32_t> const &voxels) const {
+    std::vector<PxVec3> points;
+    for (auto v : boundary(voxels)) {
+      auto &voxel = mVoxels[v];
+      PxBounds3 box =
+          voxel.surface >= 0
+              ? mSamples[voxel.surface]
+              : PxBounds3(mOrigin + PxVec3(voxel.coord[0], voxel.coord[1], voxel.coord[2]) *
+                                        mVoxelSize,
+                          mOrigin + PxVec3(voxel.coord[0] + 1, voxel.coord[1] + 1,
+                                           voxel.coord[2] + 1) *
+                                        mVoxelSize);
+      for (int c = 0; c < 8; ++c) {
+        points.push_back({c & 1 ? box.maximum.x : box.minimum.x,
+                          c & 2 ? box.maximum.y : box.minimum.y,
+                          c & 4 ? box.maximum.z : box.minimum.z});
+      }
+    }
+    return points;
+  }
+
+};
+
+} // namespace
+
+std::vector<std::vector<PxVec3>> decomposeConvex(std::vector<PxVec3> const &vertices,
+                                                 std::vector<uint32_t> const &triangles,
+                                                 ConvexDecompositionParams const &params,
+                                                 utils::ThreadPool *pool) {
+  return Decomposer(params).run(vertices, triangles, pool);
+}
+
+} // namespace sapien
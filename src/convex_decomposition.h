@@ -0,0 +1,36 @@
+#pragma once
+#include "utils/thread_pool.hpp"
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+
+struct ConvexDecompositionParams {
+  /* voxels along the longest side of the mesh bounds */
+  uint32_t resolution = 64;
+  /* splitting stops at this many hulls, disconnected parts of the mesh are never merged */
+  uint32_t maxHulls = 16;
+  /* a part is not split once its hull exceeds its volume by less than this fraction of the
+   * mesh volume */
+  float concavity = 0.01f;
+  /* candidate split planes are tried every planeDownsampling voxels */
+  uint32_t planeDownsampling = 2;
+};
+
+/** Approximate convex decomposition of a triangle mesh, in the spirit of V-HACD
+ *
+ *  The mesh is voxelized and its interior filled, closed meshes decompose as solids and open
+ *  meshes as shells. Connected voxel components are split recursively along axis aligned
+ *  planes, always splitting the most concave parts first and choosing the plane that minimizes
+ *  the concavity of the halves, measured as hull volume minus voxel volume.
+ *  @param triangles 3 vertex indices per triangle
+ *  @param pool splits of different parts are evaluated on the pool if given, must not be called
+ *         from a task of the same pool
+ *  @return points of every hull, cook them with PxConvexFlag::eCOMPUTE_CONVEX, none for an
+ *          empty mesh
+ */
+std::vector<std::vector<physx::PxVec3>>
+decomposeConvex(std::vector<physx::PxVec3> const &vertices, std::vector<uint32_t> const &triangles,
+                ConvexDecompositionParams const &params, utils::ThreadPool *pool = nullptr);
+
+} // namespace sapien
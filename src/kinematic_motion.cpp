@@ -0,0 +1,140 @@
+#include "kinematic_motion.h"
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+static PxQuat slerp(PxQuat const &a, PxQuat b, PxReal alpha) {
+  if (a.dot(b) < 0) {
+    b = -b; // shortest arc
+  }
+  PxReal cosTheta = a.dot(b);
+  if (cosTheta > 0.9995f) {
+    return (a * (1 - alpha) + b * alpha).getNormalized();
+  }
+  PxReal theta = PxAcos(cosTheta);
+  PxReal sinTheta = PxSin(theta);
+  return a * (PxSin((1 - alpha) * theta) / sinTheta) + b * (PxSin(alpha * theta) / sinTheta);
+}
+
+bool KinematicMotion::setKeyframes(std::vector<PxReal> const &times,
+                                   std::vector<PxTransform> const &poses,
+                                   Interpolation interpolation) {
+  auto logger = spdlog::get("SAPIEN");
+  if (times.empty() || times.size() != poses.size()) {
+    logger->error("Failed to set keyframes: expected the same number of times and poses");
+    return false;
+  }
+  for (size_t i = 1; i < times.size(); ++i) {
+    if (times[i] <= times[i - 1]) {
+      logger->error("Failed to set keyframes: time stamps must be strictly increasing");
+      return false;
+    }
+  }
+
+  mConstantVelocity = false;
+  mInterpolation = interpolation;
+  mTimes = times;
+  mPoses = poses;
+  for (auto &pose : mPoses) {
+    pose.q.normalize();
+  }
+
+  // Catmull-Rom style tangents for non-uniform time stamps, zero at both ends
+  size_t n = mTimes.size();
+  mTangents.assign(n, {0, 0, 0});
+  for (size_t i = 1; i + 1 < n; ++i) {
+    PxReal h0 = mTimes[i] - mTimes[i - 1];
+    PxReal h1 = mTimes[i + 1] - mTimes[i];
+    mTangents[i] = ((mPoses[i].p - mPoses[i - 1].p) * (h1 / h0) +
+                    (mPoses[i + 1].p - mPoses[i].p) * (h0 / h1)) /
+                   (h0 + h1);
+  }
+
+  mTime = 0;
+  mRunning = true;
+  return true;
+}
+
+void KinematicMotion::setConstantVelocity(PxTransform const &origin, PxVec3 const &linear,
+                                          PxVec3 const &angular) {
+  mConstantVelocity = true;
+  mTimes.clear();
+  mPoses.clear();
+  mTangents.clear();
+  mOrigin = origin;
+  mLinearVelocity = linear;
+  mAngularVelocity = angular;
+  mTime = 0;
+  mRunning = true;
+}
+
+bool KinematicMotion::isFinished() const {
+  return !mConstantVelocity && mMode == Once && mTime >= getDuration();
+}
+
+PxReal KinematicMotion::getDuration() const {
+  return mTimes.empty() ? 0 : mTimes.back() - mTimes.front();
+}
+
+PxReal KinematicMotion::wrapTime(PxReal t) const {
+  PxReal duration = getDuration();
+  if (duration <= 0) {
+    return 0;
+  }
+  switch (mMode) {
+  case Loop:
+    t = std::fmod(t, duration);
+    return t < 0 ? t + duration : t;
+  case PingPong: {
+    PxReal s = std::fmod(t, 2 * duration);
+    s = s < 0 ? s + 2 * duration : s;
+    return s > duration ? 2 * duration - s : s;
+  }
+  default:
+    return std::clamp(t, 0.f, duration);
+  }
+}
+
+PxTransform KinematicMotion::evaluate(PxReal t) const {
+  if (mConstantVelocity) {
+    PxReal angle = mAngularVelocity.magnitude() * t;
+    PxQuat rotation =
+        angle > 0 ? PxQuat(angle, mAngularVelocity.getNormalized()) : PxQuat(PxIdentity);
+    return {mOrigin.p + mLinearVelocity * t, (rotation * mOrigin.q).getNormalized()};
+  }
+  if (mPoses.empty()) {
+    return PxTransform(PxIdentity);
+  }
+  if (mPoses.size() == 1) {
+    return mPoses[0];
+  }
+
+  PxReal s = mTimes.front() + wrapTime(t);
+  size_t i = std::upper_bound(mTimes.begin(), mTimes.end(), s) - mTimes.begin();
+  i = std::clamp<size_t>(i, 1, mTimes.size() - 1) - 1;
+
+  PxReal h = mTimes[i + 1] - mTimes[i];
+  PxReal u = std::clamp((s - mTimes[i]) / h, 0.f, 1.f);
+  PxTransform const &a = mPoses[i];
+  PxTransform const &b = mPoses[i + 1];
+
+  PxVec3 p;
+  if (mInterpolation == Spline) {
+    // cubic Hermite basis
+    PxReal u2 = u * u, u3 = u2 * u;
+    p = a.p * (2 * u3 - 3 * u2 + 1) + mTangents[i] * (h * (u3 - 2 * u2 + u)) +
+        b.p * (-2 * u3 + 3 * u2) + mTangents[i + 1] * (h * (u3 - u2));
+  } else {
+    p = a.p * (1 - u) + b.p * u;
+  }
+  return {p, slerp(a.q, b.q, u)};
+}
+
+PxTransform KinematicMotion::advance(PxReal dt) {
+  mTime += dt;
+  return evaluate(mTime);
+}
+
+} // namespace sapien
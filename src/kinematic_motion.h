@@ -0,0 +1,74 @@
+#pragma once
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+/** Scripted motion of a kinematic actor
+ *
+ *  A motion is either a keyframe track or a constant velocity. It is evaluated by
+ *  SActor::prestep, which sets the kinematic target for the end of the coming step, so moving
+ *  props need no per-step Python calls. Created by SActor::createKinematicMotion.
+ */
+class KinematicMotion {
+public:
+  enum Interpolation { Linear, Spline };
+  enum Mode { Once, Loop, PingPong };
+
+private:
+  // keyframe track
+  std::vector<PxReal> mTimes;
+  std::vector<PxTransform> mPoses;
+  std::vector<PxVec3> mTangents; // position tangents for spline interpolation
+  Interpolation mInterpolation{Linear};
+  Mode mMode{Once};
+
+  // constant velocity, in world frame, starting from mOrigin
+  bool mConstantVelocity{false};
+  PxTransform mOrigin{PxIdentity};
+  PxVec3 mLinearVelocity{0, 0, 0};
+  PxVec3 mAngularVelocity{0, 0, 0};
+
+  PxReal mTime{0};
+  bool mRunning{false};
+
+public:
+  /** Set a keyframe track, it replaces any constant velocity motion
+   *  @param times strictly increasing time stamps, the track is played from times[0]
+   *  @param poses actor poses at the time stamps
+   *  @param interpolation Linear: piecewise linear translation, Spline: C1 cubic translation.
+   *         Rotations are interpolated by slerp in both cases
+   */
+  bool setKeyframes(std::vector<PxReal> const &times, std::vector<PxTransform> const &poses,
+                    Interpolation interpolation = Linear);
+
+  /** Move with constant world frame velocity from origin, it replaces any keyframe track */
+  void setConstantVelocity(PxTransform const &origin, PxVec3 const &linear,
+                           PxVec3 const &angular);
+
+  inline void setMode(Mode mode) { mMode = mode; }
+  inline Mode getMode() const { return mMode; }
+
+  inline void start() { mRunning = true; }
+  inline void stop() { mRunning = false; }
+  inline bool isRunning() const { return mRunning; }
+
+  /* only keyframe tracks in Once mode finish */
+  bool isFinished() const;
+
+  inline PxReal getTime() const { return mTime; }
+  inline void setTime(PxReal t) { mTime = t; }
+  PxReal getDuration() const;
+
+  /* pose at time t since the motion started, with the play mode applied */
+  PxTransform evaluate(PxReal t) const;
+
+  // internal use only, advance by dt and return the new pose
+  PxTransform advance(PxReal dt);
+
+private:
+  PxReal wrapTime(PxReal t) const;
+};
+
+} // namespace sapien
@@ -1,82 +1,127 @@
 #include "mesh_manager.h"
 #include "simulation.h"
-#include <assimp/Exporter.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <algorithm>
+#include <cstdlib>
 #include <experimental/filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <spdlog/spdlog.h>
 #include <sstream>
+#include <thread>
 
 namespace sapien {
 namespace fs = std::experimental::filesystem;
 
-static void exportMeshToFile(PxConvexMesh *pxMesh, const std::string &filename) {
-  // check stl supported
-  int formatCount = aiGetExportFormatCount();
-  const char *stlId = nullptr;
-  for (int i = 0; i < formatCount; ++i) {
-    const aiExportFormatDesc *formatDesc = aiGetExportFormatDescription(i);
-    if (std::string(formatDesc->fileExtension) == "stl") {
-      stlId = formatDesc->id;
-      break;
-    }
-  }
-  if (!stlId) {
-    spdlog::get("SAPIEN")->critical("Export failed: you need to build Assimp with .stl export support.");
-    throw std::runtime_error("Assimp is not built with .stl support.");
-  }
-
-  Assimp::Exporter exporter;
-  aiScene scene;
-  scene.mRootNode = new aiNode();
+// 64 bit FNV-1a
+static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
 
-  // create empty material
-  scene.mMaterials = new aiMaterial *[1];
-  scene.mMaterials[0] = new aiMaterial;
-  scene.mNumMaterials = 1;
+static uint64_t fnv1a(uint64_t hash, void const *data, size_t size) {
+  auto bytes = static_cast<uint8_t const *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
 
-  // create mesh
-  scene.mMeshes = new aiMesh *[1];
-  scene.mMeshes[0] = new aiMesh;
-  scene.mNumMeshes = 1;
-  scene.mMeshes[0]->mMaterialIndex = 0;
+template <typename T> static uint64_t fnv1a(uint64_t hash, T const &value) {
+  return fnv1a(hash, &value, sizeof(T));
+}
 
-  // add mesh to root
-  scene.mRootNode->mMeshes = new uint32_t[1];
-  scene.mRootNode->mMeshes[0] = 0;
-  scene.mRootNode->mNumMeshes = 1;
+static bool readFile(const std::string &filename, std::vector<PxU8> &data) {
+  std::ifstream s(filename, std::ios::binary | std::ios::ate);
+  if (!s) {
+    return false;
+  }
+  data.resize(s.tellg());
+  s.seekg(0);
+  return static_cast<bool>(s.read(reinterpret_cast<char *>(data.data()), data.size()));
+}
 
-  uint32_t nbvertices = pxMesh->getNbVertices();
-  scene.mMeshes[0]->mNumVertices = nbvertices;
-  scene.mMeshes[0]->mNormals = new aiVector3D[nbvertices];
-  scene.mMeshes[0]->mVertices = new aiVector3D[nbvertices];
-  const PxVec3 *vertices = pxMesh->getVertices();
-  for (uint32_t i = 0; i < nbvertices; ++i) {
-    scene.mMeshes[0]->mVertices[i] = aiVector3D(vertices[i].x, vertices[i].y, vertices[i].z);
+/* write to a temporary file first so readers never see a partial entry */
+static bool writeFileAtomic(const std::string &filename, PxU8 const *data, size_t size) {
+  std::ostringstream tmp;
+  tmp << filename << ".tmp." << std::this_thread::get_id();
+  {
+    std::ofstream s(tmp.str(), std::ios::binary);
+    if (!s || !s.write(reinterpret_cast<char const *>(data), size)) {
+      return false;
+    }
   }
+  std::error_code ec;
+  fs::rename(tmp.str(), filename, ec);
+  if (ec) {
+    fs::remove(tmp.str(), ec);
+    return false;
+  }
+  return true;
+}
 
-  uint32_t nbfaces = pxMesh->getNbPolygons();
-  scene.mMeshes[0]->mNumFaces = nbfaces;
-  scene.mMeshes[0]->mFaces = new aiFace[nbfaces];
+// decomposition cache entry: magic, hull count, then the size and cooked data of every hull
+static constexpr uint32_t DECOMPOSITION_MAGIC = 0x44434153; // "SACD"
+static constexpr uint32_t DECOMPOSITION_VERSION = 1;
 
-  const uint8_t *indexBuffer = pxMesh->getIndexBuffer();
+static std::vector<PxU8> packHulls(std::vector<std::vector<PxU8>> const &hulls) {
+  std::vector<PxU8> data;
+  auto append = [&](void const *p, size_t size) {
+    data.insert(data.end(), static_cast<PxU8 const *>(p), static_cast<PxU8 const *>(p) + size);
+  };
+  uint32_t header[2] = {DECOMPOSITION_MAGIC, static_cast<uint32_t>(hulls.size())};
+  append(header, sizeof(header));
+  for (auto &hull : hulls) {
+    uint32_t size = hull.size();
+    append(&size, sizeof(size));
+    append(hull.data(), hull.size());
+  }
+  return data;
+}
 
-  for (uint32_t i = 0; i < nbfaces; ++i) {
-    PxHullPolygon polygon;
-    pxMesh->getPolygonData(i, polygon);
-    scene.mMeshes[0]->mFaces[i].mNumIndices = polygon.mNbVerts;
-    scene.mMeshes[0]->mFaces[i].mIndices = new uint32_t[polygon.mNbVerts];
-    uint16_t offset = polygon.mIndexBase;
-    for (uint32_t j = 0; j < polygon.mNbVerts; ++j) {
-      scene.mMeshes[0]->mFaces[i].mIndices[j] = indexBuffer[offset + j];
+static bool unpackHulls(std::vector<PxU8> const &data, std::vector<std::vector<PxU8>> &hulls) {
+  size_t offset = 0;
+  auto read = [&](void *p, size_t size) {
+    if (offset + size > data.size()) {
+      return false;
+    }
+    std::copy(data.begin() + offset, data.begin() + offset + size, static_cast<PxU8 *>(p));
+    offset += size;
+    return true;
+  };
+  uint32_t header[2];
+  if (!read(header, sizeof(header)) || header[0] != DECOMPOSITION_MAGIC || header[1] == 0) {
+    return false;
+  }
+  // check counts against the remaining bytes before allocating, the entry may be corrupt
+  if (header[1] > (data.size() - offset) / sizeof(uint32_t)) {
+    return false;
+  }
+  hulls.resize(header[1]);
+  for (auto &hull : hulls) {
+    uint32_t size;
+    if (!read(&size, sizeof(size)) || size > data.size() - offset) {
+      return false;
+    }
+    hull.resize(size);
+    if (!read(hull.data(), size)) {
+      return false;
     }
   }
-  exporter.Export(&scene, stlId, filename);
+  return offset == data.size();
+}
 
-  // memory freed by aiScene destructor
+static std::string defaultCacheDirectory() {
+  if (char const *dir = std::getenv("XDG_CACHE_HOME")) {
+    return (fs::path(dir) / "sapien" / "convex").string();
+  }
+  if (char const *home = std::getenv("HOME")) {
+    return (fs::path(home) / ".cache" / "sapien" / "convex").string();
+  }
+  return (fs::temp_directory_path() / "sapien" / "convex").string();
 }
 
 static std::vector<PxVec3> getVerticesFromMeshFile(const std::string &filename) {
@@ -102,52 +147,254 @@ static std::vector<PxVec3> getVerticesFromMeshFile(const std::string &filename)
   return vertices;
 }
 
-MeshManager::MeshManager(Simulation *simulation) : mSimulation(simulation) {}
+static bool getTrianglesFromMeshFile(const std::string &filename, std::vector<PxVec3> &vertices,
+                                     std::vector<uint32_t> &triangles) {
+  Assimp::Importer importer;
+  uint32_t flags = aiProcess_Triangulate | aiProcess_PreTransformVertices |
+                   aiProcess_SortByPType | aiProcess_FindDegenerates;
+  importer.SetPropertyInteger(AI_CONFIG_PP_PTV_ADD_ROOT_TRANSFORMATION, 1);
+  importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE,
+                              aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+
+  const aiScene *scene = importer.ReadFile(filename, flags);
+  if (!scene) {
+    spdlog::get("SAPIEN")->error(importer.GetErrorString());
+    return false;
+  }
+
+  for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
+    auto mesh = scene->mMeshes[i];
+    uint32_t base = vertices.size();
+    for (uint32_t v = 0; v < mesh->mNumVertices; ++v) {
+      auto vertex = mesh->mVertices[v];
+      vertices.push_back({vertex.x, vertex.y, vertex.z});
+    }
+    for (uint32_t f = 0; f < mesh->mNumFaces; ++f) {
+      auto &face = mesh->mFaces[f];
+      if (face.mNumIndices == 3) {
+        triangles.insert(triangles.end(), {base + face.mIndices[0], base + face.mIndices[1],
+                                           base + face.mIndices[2]});
+      }
+    }
+  }
+  return true;
+}
+
+MeshManager::MeshManager(Simulation *simulation)
+    : mCacheDirectory(defaultCacheDirectory()), mSimulation(simulation) {}
 
-void MeshManager::setCacheSuffix(const std::string &filename) {
-  if (filename.empty()) {
-    throw std::runtime_error("Invalid suffix: empty string.");
+void MeshManager::setCacheDirectory(const std::string &directory) {
+  if (directory.empty()) {
+    throw std::runtime_error("Invalid cache directory: empty string.");
   }
-  mCacheSuffix = filename;
+  mCacheDirectory = directory;
+}
+
+uint64_t MeshManager::cookingHash() const {
+  // everything that changes the cooked data
+  auto params = mSimulation->mCooking->getParams();
+  uint64_t hash = fnv1a(FNV_OFFSET, static_cast<uint32_t>(PX_PHYSICS_VERSION));
+  hash = fnv1a(hash, params.scale.length);
+  hash = fnv1a(hash, params.scale.speed);
+  hash = fnv1a(hash, params.areaTestEpsilon);
+  hash = fnv1a(hash, params.planeTolerance);
+  hash = fnv1a(hash, static_cast<uint32_t>(params.convexMeshCookingType));
+  hash = fnv1a(hash, params.gaussMapLimit);
+  hash = fnv1a(hash, static_cast<uint32_t>(params.buildGPUData));
+  hash = fnv1a(hash, static_cast<uint32_t>(CONVEX_FLAGS));
+  hash = fnv1a(hash, CONVEX_VERTEX_LIMIT);
+  return hash;
+}
+
+uint64_t MeshManager::triangleMeshCookingHash() const {
+  auto params = mSimulation->mTriangleMeshCooking->getParams();
+  uint64_t hash = fnv1a(FNV_OFFSET, static_cast<uint32_t>(PX_PHYSICS_VERSION));
+  hash = fnv1a(hash, params.scale.length);
+  hash = fnv1a(hash, params.scale.speed);
+  hash = fnv1a(hash, static_cast<uint32_t>(params.midphaseDesc.getType()));
+  hash = fnv1a(hash, params.midphaseDesc.mBVH34Desc.numPrimsPerLeaf);
+  hash = fnv1a(hash, static_cast<uint32_t>(params.meshPreprocessParams));
+  hash = fnv1a(hash, params.meshWeldTolerance);
+  hash = fnv1a(hash, static_cast<uint32_t>(params.meshCookingHint));
+  hash = fnv1a(hash, static_cast<uint32_t>(params.suppressTriangleMeshRemapTable));
+  hash = fnv1a(hash, static_cast<uint32_t>(params.buildTriangleAdjacencies));
+  return hash;
+}
+
+uint64_t MeshManager::decompositionHash(ConvexDecompositionParams const &params) const {
+  uint64_t hash = fnv1a(cookingHash(), DECOMPOSITION_VERSION);
+  hash = fnv1a(hash, params.resolution);
+  hash = fnv1a(hash, params.maxHulls);
+  hash = fnv1a(hash, params.concavity);
+  hash = fnv1a(hash, params.planeDownsampling);
+  return hash;
+}
+
+std::string MeshManager::decompositionKey(const std::string &fullPath,
+                                          ConvexDecompositionParams const &params) const {
+  std::ostringstream key;
+  key << fullPath << "?decomposition=" << std::hex << decompositionHash(params);
+  return key.str();
 }
 
 std::string MeshManager::getCachedFilename(const std::string &filename) {
-  return filename + mCacheSuffix;
+  return getCacheEntry(filename, cookingHash(), ".pxconvex");
+}
+
+std::string MeshManager::getCacheEntry(const std::string &filename, uint64_t paramsHash,
+                                       const std::string &suffix) {
+  std::vector<PxU8> data;
+  if (!readFile(filename, data)) {
+    return "";
+  }
+  // the extension selects the importer, so it is part of the content
+  std::string extension = fs::path(filename).extension().string();
+  uint64_t hash = fnv1a(paramsHash, extension.data(), extension.size());
+  hash = fnv1a(hash, data.data(), data.size());
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << hash << suffix;
+  return (fs::path(mCacheDirectory) / name.str()).string();
 }
 
 physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool useCache,
                                            bool saveCache) {
+  return requestMesh(filename, useCache, saveCache, false).get();
+}
+
+std::shared_future<physx::PxConvexMesh *>
+MeshManager::loadMeshAsync(const std::string &filename, bool useCache, bool saveCache) {
+  return requestMesh(filename, useCache, saveCache, true);
+}
+
+std::vector<std::shared_future<physx::PxConvexMesh *>>
+MeshManager::loadMeshesAsync(const std::vector<std::string> &filenames, bool useCache,
+                             bool saveCache) {
+  std::vector<std::shared_future<physx::PxConvexMesh *>> futures;
+  futures.reserve(filenames.size());
+  for (auto &filename : filenames) {
+    futures.push_back(requestMesh(filename, useCache, saveCache, true));
+  }
+  return futures;
+}
+
+void MeshManager::setNumThreads(uint32_t n) {
+  waitForPendingLoads();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mNumThreads = n;
+}
+
+void MeshManager::waitForPendingLoads() {
+  std::vector<std::shared_future<PxConvexMesh *>> pending;
+  std::shared_ptr<utils::ThreadPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto &entry : mPendingMeshes) {
+      pending.push_back(entry.second);
+    }
+    pool = std::move(mThreadPool);
+  }
+  for (auto &future : pending) {
+    future.wait();
+  }
+  // the pool is destroyed here unless a parallel load on another thread still holds it
+  pool.reset();
+}
+
+std::shared_future<physx::PxConvexMesh *>
+MeshManager::requestMesh(const std::string &filename, bool useCache, bool saveCache, bool async) {
+  auto ready = [](PxConvexMesh *mesh) {
+    std::promise<PxConvexMesh *> p;
+    p.set_value(mesh);
+    return p.get_future().share();
+  };
 
   if (!fs::is_regular_file(filename)) {
     spdlog::get("SAPIEN")->error("File not found: {}", filename);
-    return nullptr;
+    return ready(nullptr);
   }
-
   std::string fullPath = fs::canonical(filename);
-  auto it = mMeshRegistry.find(fullPath);
-  if (it != mMeshRegistry.end()) {
-    spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
-    return it->second.mesh;
+
+  auto promise = std::make_shared<std::promise<PxConvexMesh *>>();
+  std::shared_future<PxConvexMesh *> future;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshRegistry.find(fullPath);
+    if (it != mMeshRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
+      it->second.lastUsed = ++mUseCounter;
+      return ready(it->second.mesh);
+    }
+    auto pending = mPendingMeshes.find(fullPath);
+    if (pending != mPendingMeshes.end()) {
+      return pending->second;
+    }
+    future = promise->get_future().share();
+    mPendingMeshes[fullPath] = future;
   }
 
-  bool cacheDidLoad = false;
-  std::string fileToLoad = filename;
-  if (useCache) {
-    std::string cachedFilename = getCachedFilename(filename);
-    if (fs::is_regular_file(cachedFilename)) {
-      fileToLoad = cachedFilename;
-      saveCache = false; // no need to save cache if it is loaded
-      cacheDidLoad = true;
+  auto task = [this, promise, filename, fullPath, useCache, saveCache]() {
+    bool cached = false;
+    size_t bytes = 0;
+    PxConvexMesh *mesh = nullptr;
+    try {
+      mesh = cookMesh(filename, useCache, saveCache, cached, bytes);
+    } catch (std::exception const &e) {
+      spdlog::get("SAPIEN")->error("Failed to load mesh {}: {}", filename, e.what());
     }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (mesh) {
+        mMeshRegistry[fullPath] = {cached, fullPath, mesh, bytes, ++mUseCounter};
+        mResidentBytes += bytes;
+        if (mMemoryBudget) {
+          evict(mMemoryBudget, fullPath);
+        }
+      }
+      mPendingMeshes.erase(fullPath);
+    }
+    promise->set_value(mesh);
+  };
+
+  if (async) {
+    getThreadPool()->submit(task);
+  } else {
+    task();
   }
+  return future;
+}
 
-  std::vector<PxVec3> vertices = getVerticesFromMeshFile(fileToLoad);
+physx::PxConvexMesh *MeshManager::cookMesh(const std::string &filename, bool useCache,
+                                           bool saveCache, bool &cached, size_t &bytes) {
+  std::string cachedFilename = (useCache || saveCache) ? getCachedFilename(filename) : "";
+
+  if (useCache && !cachedFilename.empty() && fs::is_regular_file(cachedFilename)) {
+    std::vector<PxU8> data;
+    if (readFile(cachedFilename, data)) {
+      PxDefaultMemoryInputData input(data.data(), data.size());
+      PxConvexMesh *convexMesh;
+      {
+        std::lock_guard<std::mutex> lock(mPhysicsMutex);
+        convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
+      }
+      if (convexMesh) {
+        spdlog::get("SAPIEN")->info("Loaded cooked mesh {} from cache: {}", filename,
+                                    cachedFilename);
+        cached = true;
+        bytes = data.size();
+        return convexMesh;
+      }
+    }
+    spdlog::get("SAPIEN")->warn("Invalid cache file {}, cooking {} again", cachedFilename,
+                                filename);
+  }
+
+  std::vector<PxVec3> vertices = getVerticesFromMeshFile(filename);
   PxConvexMeshDesc convexDesc;
   convexDesc.points.count = vertices.size();
   convexDesc.points.stride = sizeof(PxVec3);
   convexDesc.points.data = vertices.data();
-  convexDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX; // FIXME: shift vertices may improve statbility
-  convexDesc.vertexLimit = 256;
+  convexDesc.flags = CONVEX_FLAGS; // FIXME: shift vertices may improve statbility
+  convexDesc.vertexLimit = CONVEX_VERTEX_LIMIT;
 
   PxDefaultMemoryOutputStream buf;
   PxConvexMeshCookingResult::Enum result;
@@ -156,64 +403,91 @@ physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool use
     return nullptr;
   }
   PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
-  PxConvexMesh *convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
+  PxConvexMesh *convexMesh;
+  {
+    std::lock_guard<std::mutex> lock(mPhysicsMutex);
+    convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
+  }
 
   spdlog::get("SAPIEN")->info("Created {} vertices from: {}", std::to_string(convexMesh->getNbVertices()),
                filename);
 
-  if (saveCache) {
-    std::string cachedFilename = getCachedFilename(filename);
-    exportMeshToFile(convexMesh, cachedFilename);
-    spdlog::get("SAPIEN")->info("Saved cache file: {}", cachedFilename);
+  cached = false;
+  bytes = buf.getSize();
+  if (saveCache && !cachedFilename.empty()) {
+    std::error_code ec;
+    fs::create_directories(mCacheDirectory, ec);
+    if (writeFileAtomic(cachedFilename, buf.getData(), buf.getSize())) {
+      spdlog::get("SAPIEN")->info("Saved cache file: {}", cachedFilename);
+      cached = true;
+    } else {
+      spdlog::get("SAPIEN")->warn("Failed to save cache file: {}", cachedFilename);
+    }
   }
-
-  mMeshRegistry[fullPath] = {/* cached */ cacheDidLoad || saveCache, /* filename */ fullPath,
-                             /* mesh */ convexMesh};
-
   return convexMesh;
 }
 
-std::vector<std::vector<int>> splitMesh(aiMesh *mesh) {
-  // build adjacency list
-  spdlog::get("SAPIEN")->info("splitting mesh with {} vertices", mesh->mNumVertices);
-  std::vector<std::set<int>> adj(mesh->mNumVertices);
-  for (uint32_t i = 0; i < mesh->mNumFaces; ++i) {
-    for (uint32_t j = 0; j < mesh->mFaces[i].mNumIndices; ++j) {
-      uint32_t a = mesh->mFaces[i].mIndices[j];
-      uint32_t b = mesh->mFaces[i].mIndices[(j + 1) % mesh->mFaces[i].mNumIndices];
-      adj[a].insert(b);
-      adj[b].insert(a);
+std::vector<std::vector<uint32_t>> splitMeshComponents(std::vector<PxVec3> const &vertices,
+                                                       std::vector<uint32_t> const &triangles) {
+  uint32_t n = vertices.size();
+  std::vector<uint32_t> parent(n), size(n, 1);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](uint32_t x) {
+    while (parent[x] != x) {
+      parent[x] = parent[parent[x]]; // path halving
+      x = parent[x];
+    }
+    return x;
+  };
+  auto unite = [&](uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+      return;
     }
+    if (size[a] < size[b]) {
+      std::swap(a, b);
+    }
+    parent[b] = a;
+    size[a] += size[b];
+  };
+
+  // weld vertices at identical positions, neighbours after a lexicographic sort
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  auto less = [&](uint32_t a, uint32_t b) {
+    auto &u = vertices[a];
+    auto &v = vertices[b];
+    return u.x < v.x || (u.x == v.x && (u.y < v.y || (u.y == v.y && u.z < v.z)));
+  };
+  std::sort(order.begin(), order.end(), less);
+  std::vector<char> duplicate(n, 0);
+  for (uint32_t k = 1; k < n; ++k) {
+    if (vertices[order[k]] == vertices[order[k - 1]]) {
+      unite(order[k], order[k - 1]);
+      duplicate[order[k]] = 1;
+    }
+  }
+
+  for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+    unite(triangles[i], triangles[i + 1]);
+    unite(triangles[i], triangles[i + 2]);
   }
 
-  std::vector<std::vector<int>> groups;
-  std::vector<int> visited(mesh->mNumVertices, 0);
-  for (uint32_t i = 0; i < mesh->mNumVertices; ++i) {
-    if (visited[i]) {
+  // one entry per welded position, components in order of their first vertex
+  std::vector<std::vector<uint32_t>> groups;
+  std::vector<int> groupOf(n, -1);
+  for (uint32_t v = 0; v < n; ++v) {
+    if (duplicate[v]) {
       continue;
     }
-
-    // new group
-    groups.emplace_back();
-    groups.back().push_back(i);
-
-    // traverse group
-    visited[i] = 1;
-    std::vector<int> q;
-    q.push_back(i);
-    while (!q.empty()) {
-      int n = q.back();
-      q.pop_back();
-      for (auto m : adj[n]) {
-        if (!visited[m]) {
-          visited[m] = 1;
-          groups.back().push_back(m);
-          q.push_back(m);
-        }
-      }
+    uint32_t root = find(v);
+    if (groupOf[root] < 0) {
+      groupOf[root] = groups.size();
+      groups.emplace_back();
     }
+    groups[groupOf[root]].push_back(v);
   }
-
   return groups;
 }
 
@@ -226,64 +500,614 @@ std::vector<PxConvexMesh *> MeshManager::loadMeshGroup(const std::string &filena
   }
 
   std::string fullPath = fs::canonical(filename);
-  auto it = mMeshGroupRegistry.find(fullPath);
-  if (it != mMeshGroupRegistry.end()) {
-    spdlog::get("SAPIEN")->info("Using loaded mesh group: {}", filename);
-    for (PxConvexMesh *mesh : it->second.meshes) {
-      meshes.push_back(mesh);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshGroupRegistry.find(fullPath);
+    if (it != mMeshGroupRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded mesh group: {}", filename);
+      it->second.lastUsed = ++mUseCounter;
+      return it->second.meshes;
     }
-    return meshes;
   }
 
-  // import obj using assimp
+  // vertices are welded by splitMeshComponents, no need for Assimp to join them
   Assimp::Importer importer;
-  importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS,
-                              aiComponent_NORMALS |
-                              aiComponent_TEXCOORDS |
-                              aiComponent_COLORS |
-                              aiComponent_TANGENTS_AND_BITANGENTS | 
-                              aiComponent_MATERIALS |
-                              aiComponent_TEXTURES);
-
-  uint32_t flags = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_RemoveComponent;
-
-  const aiScene *scene = importer.ReadFile(filename, flags);
+  const aiScene *scene = importer.ReadFile(filename, aiProcess_Triangulate);
   if (!scene) {
     spdlog::get("SAPIEN")->error(importer.GetErrorString());
     return meshes;
   }
 
   spdlog::get("SAPIEN")->info("Found {} meshes", scene->mNumMeshes);
+  std::vector<std::vector<PxVec3>> parts;
   for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
     auto mesh = scene->mMeshes[i];
-    auto vertexGroups = splitMesh(mesh);
+    std::vector<PxVec3> vertices(mesh->mNumVertices);
+    for (uint32_t v = 0; v < mesh->mNumVertices; ++v) {
+      vertices[v] = {mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z};
+    }
+    std::vector<uint32_t> triangles;
+    triangles.reserve(mesh->mNumFaces * 3);
+    for (uint32_t f = 0; f < mesh->mNumFaces; ++f) {
+      auto &face = mesh->mFaces[f];
+      if (face.mNumIndices == 0) {
+        continue;
+      }
+      // points and lines left by triangulation become degenerate triangles
+      uint32_t a = face.mIndices[0];
+      uint32_t b = face.mIndices[std::min(1u, face.mNumIndices - 1)];
+      uint32_t c = face.mIndices[std::min(2u, face.mNumIndices - 1)];
+      triangles.insert(triangles.end(), {a, b, c});
+    }
 
-    spdlog::get("SAPIEN")->info("Decomposed mesh {} into {} components", i + 1, vertexGroups.size());
+    auto vertexGroups = splitMeshComponents(vertices, triangles);
+    spdlog::get("SAPIEN")->info("Decomposed mesh {} into {} components", i + 1,
+                                vertexGroups.size());
     for (auto &g : vertexGroups) {
-      spdlog::get("SAPIEN")->info("vertex count: {}", g.size());
-      std::vector<PxVec3> vertices;
+      parts.emplace_back();
+      parts.back().reserve(g.size());
       for (auto v : g) {
-        auto vertex = mesh->mVertices[v];
-        vertices.push_back({vertex.x, vertex.y, vertex.z});
+        parts.back().push_back(vertices[v]);
       }
+    }
+  }
+
+  // cook parts in parallel, creation on PxPhysics is serialized
+  meshes.resize(parts.size(), nullptr);
+  std::vector<size_t> partBytes(parts.size(), 0);
+  getThreadPool()->parallelFor(0, parts.size(), [&](size_t i, uint32_t) {
+    PxConvexMeshDesc convexDesc;
+    convexDesc.points.count = parts[i].size();
+    convexDesc.points.stride = sizeof(PxVec3);
+    convexDesc.points.data = parts[i].data();
+    convexDesc.flags = CONVEX_FLAGS; // | PxConvexFlag::eSHIFT_VERTICES;
+    convexDesc.vertexLimit = CONVEX_VERTEX_LIMIT;
+
+    PxDefaultMemoryOutputStream buf;
+    PxConvexMeshCookingResult::Enum result;
+    if (!mSimulation->mCooking->cookConvexMesh(convexDesc, buf, &result)) {
+      spdlog::get("SAPIEN")->error("Failed to cook a mesh from file: {}", filename);
+      return;
+    }
+    PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
+    partBytes[i] = buf.getSize();
+    std::lock_guard<std::mutex> lock(mPhysicsMutex);
+    meshes[i] = mSimulation->mPhysicsSDK->createConvexMesh(input);
+  });
+  size_t bytes = std::accumulate(partBytes.begin(), partBytes.end(), size_t(0));
+  meshes.erase(std::remove(meshes.begin(), meshes.end(), nullptr), meshes.end());
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mMeshGroupRegistry.find(fullPath);
+  if (it != mMeshGroupRegistry.end()) {
+    // loaded concurrently by another thread, keep the registered meshes
+    std::lock_guard<std::mutex> physicsLock(mPhysicsMutex);
+    for (auto mesh : meshes) {
+      mesh->release();
+    }
+    return it->second.meshes;
+  }
+  mMeshGroupRegistry[fullPath] = {fullPath, meshes, bytes, ++mUseCounter};
+  mResidentBytes += bytes;
+  if (mMemoryBudget) {
+    evict(mMemoryBudget, fullPath);
+  }
+  return meshes;
+}
+
+PxConvexMesh *MeshManager::acquireMesh(const std::string &filename, bool useCache,
+                                       bool saveCache) {
+  // another thread may evict the mesh between loading and acquiring it, load it again then
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    PxConvexMesh *mesh = loadMesh(filename, useCache, saveCache);
+    if (!mesh) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshRegistry.find(fs::canonical(filename));
+    if (it != mMeshRegistry.end() && it->second.mesh == mesh) {
+      it->second.lastUsed = ++mUseCounter;
+      mesh->acquireReference();
+      return mesh;
+    }
+  }
+  spdlog::get("SAPIEN")->error("Failed to acquire mesh {}: the memory budget is too small",
+                               filename);
+  return nullptr;
+}
+
+std::vector<PxConvexMesh *> MeshManager::acquireMeshGroup(const std::string &filename) {
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    auto meshes = loadMeshGroup(filename);
+    if (meshes.empty()) {
+      return meshes;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshGroupRegistry.find(fs::canonical(filename));
+    if (it != mMeshGroupRegistry.end() && it->second.meshes == meshes) {
+      it->second.lastUsed = ++mUseCounter;
+      for (auto mesh : meshes) {
+        mesh->acquireReference();
+      }
+      return meshes;
+    }
+  }
+  spdlog::get("SAPIEN")->error("Failed to acquire mesh group {}: the memory budget is too small",
+                               filename);
+  return {};
+}
+
+std::vector<PxConvexMesh *>
+MeshManager::loadMeshDecomposition(const std::string &filename,
+                                   ConvexDecompositionParams const &params, bool useCache,
+                                   bool saveCache) {
+  if (!fs::is_regular_file(filename)) {
+    spdlog::get("SAPIEN")->error("File not found: {}", filename);
+    return {};
+  }
+  std::string key = decompositionKey(fs::canonical(filename), params);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshGroupRegistry.find(key);
+    if (it != mMeshGroupRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded decomposition: {}", filename);
+      it->second.lastUsed = ++mUseCounter;
+      return it->second.meshes;
+    }
+  }
+
+  size_t bytes = 0;
+  auto meshes = cookDecomposition(filename, params, useCache, saveCache, bytes);
+  if (meshes.empty()) {
+    return meshes;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mMeshGroupRegistry.find(key);
+  if (it != mMeshGroupRegistry.end()) {
+    // loaded concurrently by another thread, keep the registered meshes
+    std::lock_guard<std::mutex> physicsLock(mPhysicsMutex);
+    for (auto mesh : meshes) {
+      mesh->release();
+    }
+    return it->second.meshes;
+  }
+  mMeshGroupRegistry[key] = {fs::canonical(filename), meshes, bytes, ++mUseCounter};
+  mResidentBytes += bytes;
+  if (mMemoryBudget) {
+    evict(mMemoryBudget, key);
+  }
+  return meshes;
+}
+
+std::vector<PxConvexMesh *>
+MeshManager::acquireMeshDecomposition(const std::string &filename,
+                                      ConvexDecompositionParams const &params, bool useCache,
+                                      bool saveCache) {
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    auto meshes = loadMeshDecomposition(filename, params, useCache, saveCache);
+    if (meshes.empty()) {
+      return meshes;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMeshGroupRegistry.find(decompositionKey(fs::canonical(filename), params));
+    if (it != mMeshGroupRegistry.end() && it->second.meshes == meshes) {
+      it->second.lastUsed = ++mUseCounter;
+      for (auto mesh : meshes) {
+        mesh->acquireReference();
+      }
+      return meshes;
+    }
+  }
+  spdlog::get("SAPIEN")->error(
+      "Failed to acquire decomposition of {}: the memory budget is too small", filename);
+  return {};
+}
+
+std::vector<PxConvexMesh *>
+MeshManager::cookDecomposition(const std::string &filename,
+                               ConvexDecompositionParams const &params, bool useCache,
+                               bool saveCache, size_t &bytes) {
+  std::string cachedFilename =
+      (useCache || saveCache) ? getCacheEntry(filename, decompositionHash(params), ".pxacd") : "";
+
+  std::vector<std::vector<PxU8>> cooked;
+  bool cached = false;
+  if (useCache && !cachedFilename.empty() && fs::is_regular_file(cachedFilename)) {
+    std::vector<PxU8> data;
+    if (readFile(cachedFilename, data) && unpackHulls(data, cooked)) {
+      spdlog::get("SAPIEN")->info("Loaded decomposition of {} from cache: {}", filename,
+                                  cachedFilename);
+      cached = true;
+    } else {
+      spdlog::get("SAPIEN")->warn("Invalid cache file {}, decomposing {} again",
+                                  cachedFilename, filename);
+      cooked.clear();
+    }
+  }
+
+  if (!cached) {
+    std::vector<PxVec3> vertices;
+    std::vector<uint32_t> triangles;
+    if (!getTrianglesFromMeshFile(filename, vertices, triangles) || triangles.empty()) {
+      spdlog::get("SAPIEN")->error("Failed to load triangles from: {}", filename);
+      return {};
+    }
+    auto pool = getThreadPool();
+    auto hulls = decomposeConvex(vertices, triangles, params, pool.get());
+
+    cooked.resize(hulls.size());
+    pool->parallelFor(0, hulls.size(), [&](size_t i, uint32_t) {
       PxConvexMeshDesc convexDesc;
-      convexDesc.points.count = vertices.size();
+      convexDesc.points.count = hulls[i].size();
       convexDesc.points.stride = sizeof(PxVec3);
-      convexDesc.points.data = vertices.data();
-      convexDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX; // | PxConvexFlag::eSHIFT_VERTICES;
-      convexDesc.vertexLimit = 256;
+      convexDesc.points.data = hulls[i].data();
+      convexDesc.flags = CONVEX_FLAGS;
+      convexDesc.vertexLimit = CONVEX_VERTEX_LIMIT;
 
       PxDefaultMemoryOutputStream buf;
-      PxConvexMeshCookingResult::Enum result;
-      if (!mSimulation->mCooking->cookConvexMesh(convexDesc, buf, &result)) {
-        spdlog::get("SAPIEN")->error("Failed to cook a mesh from file: {}", filename);
+      if (!mSimulation->mCooking->cookConvexMesh(convexDesc, buf)) {
+        spdlog::get("SAPIEN")->warn("Failed to cook hull {} of {}", i, filename);
+        return;
+      }
+      cooked[i].assign(buf.getData(), buf.getData() + buf.getSize());
+    });
+    cooked.erase(std::remove_if(cooked.begin(), cooked.end(),
+                                [](std::vector<PxU8> const &c) { return c.empty(); }),
+                 cooked.end());
+    if (cooked.empty()) {
+      spdlog::get("SAPIEN")->error("Failed to decompose mesh: {}", filename);
+      return {};
+    }
+    spdlog::get("SAPIEN")->info("Decomposed {} into {} convex hulls", filename, cooked.size());
+
+    if (saveCache && !cachedFilename.empty()) {
+      std::error_code ec;
+      fs::create_directories(mCacheDirectory, ec);
+      auto data = packHulls(cooked);
+      if (writeFileAtomic(cachedFilename, data.data(), data.size())) {
+        spdlog::get("SAPIEN")->info("Saved cache file: {}", cachedFilename);
+      } else {
+        spdlog::get("SAPIEN")->warn("Failed to save cache file: {}", cachedFilename);
       }
-      PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
-      PxConvexMesh *convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
-      meshes.push_back(convexMesh);
     }
   }
+
+  std::vector<PxConvexMesh *> meshes;
+  bytes = 0;
+  std::lock_guard<std::mutex> lock(mPhysicsMutex);
+  for (auto &c : cooked) {
+    PxDefaultMemoryInputData input(c.data(), c.size());
+    if (auto mesh = mSimulation->mPhysicsSDK->createConvexMesh(input)) {
+      meshes.push_back(mesh);
+      bytes += c.size();
+    }
+  }
+  if (meshes.size() != cooked.size()) {
+    spdlog::get("SAPIEN")->warn("Failed to create {} hulls of {}", cooked.size() - meshes.size(),
+                                filename);
+  }
   return meshes;
 }
 
+PxTriangleMesh *MeshManager::loadNonConvexMesh(const std::string &filename, bool useCache,
+                                               bool saveCache) {
+  if (!fs::is_regular_file(filename)) {
+    spdlog::get("SAPIEN")->error("File not found: {}", filename);
+    return nullptr;
+  }
+  std::string fullPath = fs::canonical(filename);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mTriangleMeshRegistry.find(fullPath);
+    if (it != mTriangleMeshRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded non-convex mesh: {}", filename);
+      it->second.lastUsed = ++mUseCounter;
+      return it->second.mesh;
+    }
+  }
+
+  size_t bytes = 0;
+  PxTriangleMesh *mesh = cookNonConvexMesh(filename, useCache, saveCache, bytes);
+  if (!mesh) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mTriangleMeshRegistry.find(fullPath);
+  if (it != mTriangleMeshRegistry.end()) {
+    // loaded concurrently by another thread, keep the registered mesh
+    std::lock_guard<std::mutex> physicsLock(mPhysicsMutex);
+    mesh->release();
+    return it->second.mesh;
+  }
+  mTriangleMeshRegistry[fullPath] = {fullPath, mesh, bytes, ++mUseCounter};
+  mResidentBytes += bytes;
+  if (mMemoryBudget) {
+    evict(mMemoryBudget, fullPath);
+  }
+  return mesh;
+}
+
+PxTriangleMesh *MeshManager::acquireNonConvexMesh(const std::string &filename, bool useCache,
+                                                  bool saveCache) {
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    PxTriangleMesh *mesh = loadNonConvexMesh(filename, useCache, saveCache);
+    if (!mesh) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mTriangleMeshRegistry.find(fs::canonical(filename));
+    if (it != mTriangleMeshRegistry.end() && it->second.mesh == mesh) {
+      it->second.lastUsed = ++mUseCounter;
+      mesh->acquireReference();
+      return mesh;
+    }
+  }
+  spdlog::get("SAPIEN")->error("Failed to acquire mesh {}: the memory budget is too small",
+                               filename);
+  return nullptr;
+}
+
+PxTriangleMesh *MeshManager::cookNonConvexMesh(const std::string &filename, bool useCache,
+                                               bool saveCache, size_t &bytes) {
+  std::string cachedFilename =
+      (useCache || saveCache) ? getCacheEntry(filename, triangleMeshCookingHash(), ".pxtrimesh")
+                              : "";
+
+  if (useCache && !cachedFilename.empty() && fs::is_regular_file(cachedFilename)) {
+    std::vector<PxU8> data;
+    if (readFile(cachedFilename, data)) {
+      PxDefaultMemoryInputData input(data.data(), data.size());
+      PxTriangleMesh *triangleMesh;
+      {
+        std::lock_guard<std::mutex> lock(mPhysicsMutex);
+        triangleMesh = mSimulation->mPhysicsSDK->createTriangleMesh(input);
+      }
+      if (triangleMesh) {
+        spdlog::get("SAPIEN")->info("Loaded cooked mesh {} from cache: {}", filename,
+                                    cachedFilename);
+        bytes = data.size();
+        return triangleMesh;
+      }
+    }
+    spdlog::get("SAPIEN")->warn("Invalid cache file {}, cooking {} again", cachedFilename,
+                                filename);
+  }
+
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+  if (!getTrianglesFromMeshFile(filename, vertices, triangles) || triangles.empty()) {
+    spdlog::get("SAPIEN")->error("Failed to load triangles from: {}", filename);
+    return nullptr;
+  }
+  PxTriangleMeshDesc meshDesc;
+  meshDesc.points.count = vertices.size();
+  meshDesc.points.stride = sizeof(PxVec3);
+  meshDesc.points.data = vertices.data();
+  meshDesc.triangles.count = triangles.size() / 3;
+  meshDesc.triangles.stride = 3 * sizeof(uint32_t);
+  meshDesc.triangles.data = triangles.data();
+
+  PxDefaultMemoryOutputStream buf;
+  PxTriangleMeshCookingResult::Enum result;
+  if (!mSimulation->mTriangleMeshCooking->cookTriangleMesh(meshDesc, buf, &result)) {
+    spdlog::get("SAPIEN")->error("Failed to cook non-convex mesh: {}", filename);
+    return nullptr;
+  }
+  if (result == PxTriangleMeshCookingResult::eLARGE_TRIANGLE) {
+    spdlog::get("SAPIEN")->warn("Mesh {} has large triangles, consider tessellating it",
+                                filename);
+  }
+  PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
+  PxTriangleMesh *triangleMesh;
+  {
+    std::lock_guard<std::mutex> lock(mPhysicsMutex);
+    triangleMesh = mSimulation->mPhysicsSDK->createTriangleMesh(input);
+  }
+  if (!triangleMesh) {
+    spdlog::get("SAPIEN")->error("Failed to create non-convex mesh: {}", filename);
+    return nullptr;
+  }
+  spdlog::get("SAPIEN")->info("Created non-convex mesh with {} triangles from: {}",
+                              triangleMesh->getNbTriangles(), filename);
+
+  bytes = buf.getSize();
+  if (saveCache && !cachedFilename.empty()) {
+    std::error_code ec;
+    fs::create_directories(mCacheDirectory, ec);
+    if (writeFileAtomic(cachedFilename, buf.getData(), buf.getSize())) {
+      spdlog::get("SAPIEN")->info("Saved cache file: {}", cachedFilename);
+    } else {
+      spdlog::get("SAPIEN")->warn("Failed to save cache file: {}", cachedFilename);
+    }
+  }
+  return triangleMesh;
+}
+
+MeshManager::Stats MeshManager::getStats() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Stats stats{0, mResidentBytes, 0, 0, mEvictedCount};
+  for (auto &[key, record] : mMeshRegistry) {
+    stats.residentMeshes += 1;
+    if (record.mesh->getReferenceCount() == 1) {
+      stats.unusedMeshes += 1;
+      stats.unusedBytes += record.bytes;
+    }
+  }
+  for (auto &[key, record] : mMeshGroupRegistry) {
+    stats.residentMeshes += record.meshes.size();
+    bool unused = std::all_of(record.meshes.begin(), record.meshes.end(),
+                              [](PxConvexMesh *mesh) { return mesh->getReferenceCount() == 1; });
+    if (unused) {
+      stats.unusedMeshes += record.meshes.size();
+      stats.unusedBytes += record.bytes;
+    }
+  }
+  for (auto &[key, record] : mTriangleMeshRegistry) {
+    stats.residentMeshes += 1;
+    if (record.mesh->getReferenceCount() == 1) {
+      stats.unusedMeshes += 1;
+      stats.unusedBytes += record.bytes;
+    }
+  }
+  return stats;
+}
+
+void MeshManager::setMemoryBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMemoryBudget = bytes;
+  if (mMemoryBudget) {
+    evict(mMemoryBudget);
+  }
+}
+
+uint32_t MeshManager::evictUnusedMeshes() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return evict(0);
+}
+
+void MeshManager::setPrimitiveFitTolerance(float tolerance) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mPrimitiveFitTolerance = std::max(tolerance, 0.f);
+}
+
+float MeshManager::getPrimitiveFitTolerance() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mPrimitiveFitTolerance;
+}
+
+PrimitiveFit MeshManager::fitShape(PxConvexMesh *mesh, PxVec3 const &scale,
+                                   std::string const &shape) {
+  float tolerance;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    tolerance = mPrimitiveFitTolerance;
+  }
+  if (tolerance <= 0 || !mesh) {
+    return {};
+  }
+
+  std::ostringstream oss;
+  oss << shape << " " << scale.x << " " << scale.y << " " << scale.z;
+  std::string key = oss.str();
+  PrimitiveFit fit;
+  bool known = false;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mPrimitiveFits.find(key);
+    if (it != mPrimitiveFits.end() && it->second.mesh == mesh) {
+      fit = it->second.record.fit;
+      known = true;
+    }
+  }
+  // fitting runs unlocked, concurrent builds of a new shape may both fit it
+  if (!known) {
+    fit = fitPrimitive(*mesh, scale);
+  }
+  bool replaced = fit.type != PrimitiveFit::None && fit.error <= tolerance;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!known && replaced) {
+      spdlog::get("SAPIEN")->info("Replaced convex mesh {} by a primitive, volume error {}",
+                                  shape, fit.error);
+    }
+    mPrimitiveFits[key] = {mesh, {shape, scale, fit, replaced}};
+  }
+  return replaced ? fit : PrimitiveFit{};
+}
+
+std::vector<PrimitiveFitRecord> MeshManager::getPrimitiveFitReport() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<PrimitiveFitRecord> report;
+  for (auto &[key, entry] : mPrimitiveFits) {
+    report.push_back(entry.record);
+  }
+  return report;
+}
+
+void MeshManager::clearPrimitiveFitReport() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mPrimitiveFits.clear();
+}
+
+uint32_t MeshManager::evict(size_t budget, std::string const &keep) {
+  if (mResidentBytes <= budget) {
+    return 0;
+  }
+
+  // a group is only evicted when none of its parts is used
+  struct Candidate {
+    uint64_t lastUsed;
+    std::map<std::string, MeshRecord>::iterator mesh;
+    std::map<std::string, MeshGroupRecord>::iterator group;
+    std::map<std::string, TriangleMeshRecord>::iterator triangleMesh;
+  };
+  std::vector<Candidate> candidates;
+  for (auto it = mMeshRegistry.begin(); it != mMeshRegistry.end(); ++it) {
+    if (it->first != keep && it->second.mesh->getReferenceCount() == 1) {
+      candidates.push_back(
+          {it->second.lastUsed, it, mMeshGroupRegistry.end(), mTriangleMeshRegistry.end()});
+    }
+  }
+  for (auto it = mMeshGroupRegistry.begin(); it != mMeshGroupRegistry.end(); ++it) {
+    auto &meshes = it->second.meshes;
+    if (it->first != keep &&
+        std::all_of(meshes.begin(), meshes.end(),
+                    [](PxConvexMesh *mesh) { return mesh->getReferenceCount() == 1; })) {
+      candidates.push_back(
+          {it->second.lastUsed, mMeshRegistry.end(), it, mTriangleMeshRegistry.end()});
+    }
+  }
+  for (auto it = mTriangleMeshRegistry.begin(); it != mTriangleMeshRegistry.end(); ++it) {
+    if (it->first != keep && it->second.mesh->getReferenceCount() == 1) {
+      candidates.push_back(
+          {it->second.lastUsed, mMeshRegistry.end(), mMeshGroupRegistry.end(), it});
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](Candidate const &a, Candidate const &b) { return a.lastUsed < b.lastUsed; });
+
+  uint32_t count = 0;
+  std::lock_guard<std::mutex> lock(mPhysicsMutex);
+  for (auto &c : candidates) {
+    if (mResidentBytes <= budget) {
+      break;
+    }
+    if (c.mesh != mMeshRegistry.end()) {
+      c.mesh->second.mesh->release();
+      mResidentBytes -= c.mesh->second.bytes;
+      mMeshRegistry.erase(c.mesh);
+      count += 1;
+    } else if (c.triangleMesh != mTriangleMeshRegistry.end()) {
+      c.triangleMesh->second.mesh->release();
+      mResidentBytes -= c.triangleMesh->second.bytes;
+      mTriangleMeshRegistry.erase(c.triangleMesh);
+      count += 1;
+    } else {
+      for (auto mesh : c.group->second.meshes) {
+        mesh->release();
+      }
+      mResidentBytes -= c.group->second.bytes;
+      count += c.group->second.meshes.size();
+      mMeshGroupRegistry.erase(c.group);
+    }
+  }
+  mEvictedCount += count;
+  if (count) {
+    spdlog::get("SAPIEN")->info("Evicted {} unused meshes, {} bytes resident", count,
+                                mResidentBytes);
+  }
+  return count;
+}
+
+std::shared_ptr<utils::ThreadPool> MeshManager::getThreadPool() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (!mThreadPool) {
+    mThreadPool = std::make_shared<utils::ThreadPool>(mNumThreads);
+  }
+  return mThreadPool;
+}
+
 } // namespace sapien
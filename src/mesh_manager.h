@@ -1,8 +1,13 @@
 #pragma once
+#include "convex_decomposition.h"
+#include "primitive_fit.h"
+#include "utils/thread_pool.hpp"
 #include <PxPhysicsAPI.h>
-#include <string>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace sapien {
@@ -12,20 +17,87 @@ struct MeshRecord {
   bool cached;
   std::string filename;
   physx::PxConvexMesh *mesh;
+  size_t bytes;      // size of the cooked data
+  uint64_t lastUsed; // MeshManager use counter at the last load
+};
+
+struct TriangleMeshRecord {
+  std::string filename;
+  physx::PxTriangleMesh *mesh;
+  size_t bytes;
+  uint64_t lastUsed;
 };
 
 struct MeshGroupRecord {
   std::string filename;
   std::vector<physx::PxConvexMesh *> meshes;
+  size_t bytes;
+  uint64_t lastUsed;
+};
+
+struct PrimitiveFitRecord {
+  std::string shape; // mesh file, with #index for parts of groups and decompositions
+  physx::PxVec3 scale;
+  PrimitiveFit fit;
+  bool replaced; // fit error within the tolerance
 };
 
+/** Connected components of a triangle mesh
+ *
+ *  Vertices at identical positions are welded, so components are found on triangle soups as
+ *  well as indexed meshes. Runs in O(n log n) with a union-find over vertices.
+ *  @param triangles 3 vertex indices per triangle
+ *  @return vertex indices of every component, one index per distinct position
+ */
+std::vector<std::vector<uint32_t>> splitMeshComponents(std::vector<physx::PxVec3> const &vertices,
+                                                       std::vector<uint32_t> const &triangles);
+
+/** Loads and cooks convex collision meshes, each file is cooked once
+ *
+ *  Loading is thread-safe. loadMeshesAsync cooks files on a worker pool, and a file requested
+ *  again while it is being cooked, synchronously or not, waits for the same result instead of
+ *  being cooked twice. Cache configuration is not synchronized, set it before loading.
+ *
+ *  The registry holds one PhysX reference to every mesh and each shape using a mesh holds
+ *  another, so a mesh whose reference count is 1 is not used by any scene. When the cooked
+ *  size of the loaded meshes exceeds the memory budget, unused meshes are released in least
+ *  recently used order and loaded again on demand.
+ */
 class MeshManager {
 private:
-  std::string mCacheSuffix = ".convex.stl";
+  static constexpr physx::PxConvexFlag::Enum CONVEX_FLAGS = physx::PxConvexFlag::eCOMPUTE_CONVEX;
+  static constexpr physx::PxU16 CONVEX_VERTEX_LIMIT = 256;
+
+  std::string mCacheDirectory;
 
   Simulation *mSimulation;
   std::map<std::string, MeshRecord> mMeshRegistry;
   std::map<std::string, MeshGroupRecord> mMeshGroupRegistry;
+  std::map<std::string, TriangleMeshRecord> mTriangleMeshRegistry;
+
+  // guards the registries and the in-flight loads, never held while cooking
+  std::mutex mMutex;
+  // serializes mesh creation on PxPhysics, cooking itself runs concurrently
+  std::mutex mPhysicsMutex;
+  std::map<std::string, std::shared_future<physx::PxConvexMesh *>> mPendingMeshes;
+
+  // shared so that a parallel load keeps the pool alive while setNumThreads replaces it
+  std::shared_ptr<utils::ThreadPool> mThreadPool;
+  uint32_t mNumThreads{0};
+
+  float mPrimitiveFitTolerance{0.f};
+  // latest fit of every fitted shape, keyed by shape name and scale, reused while the shape
+  // still uses the same mesh
+  struct PrimitiveFitEntry {
+    physx::PxConvexMesh *mesh;
+    PrimitiveFitRecord record;
+  };
+  std::map<std::string, PrimitiveFitEntry> mPrimitiveFits;
+
+  size_t mMemoryBudget{0};
+  size_t mResidentBytes{0};
+  uint64_t mUseCounter{0};
+  uint64_t mEvictedCount{0};
 
 public:
   explicit MeshManager(Simulation *simulation);
@@ -33,12 +105,122 @@ public:
   physx::PxConvexMesh *loadMesh(const std::string &filename, bool useCache = true,
                                 bool saveCache = true);
 
+  /** Start loading a mesh on the worker pool, the future holds nullptr on failure */
+  std::shared_future<physx::PxConvexMesh *>
+  loadMeshAsync(const std::string &filename, bool useCache = true, bool saveCache = true);
+  std::vector<std::shared_future<physx::PxConvexMesh *>>
+  loadMeshesAsync(const std::vector<std::string> &filenames, bool useCache = true,
+                  bool saveCache = true);
+
   std::vector<physx::PxConvexMesh *> loadMeshGroup(const std::string &filename);
 
+  /** Load a mesh and add a reference to it, the caller must release it
+   *
+   *  Pointers returned by loadMesh and loadMeshGroup may be evicted once the memory budget is
+   *  exceeded, unless a shape uses them. Builders acquire meshes instead and release them after
+   *  the shapes are created.
+   */
+  physx::PxConvexMesh *acquireMesh(const std::string &filename, bool useCache = true,
+                                   bool saveCache = true);
+  std::vector<physx::PxConvexMesh *> acquireMeshGroup(const std::string &filename);
+
+  /** Load a mesh file as the hulls of its approximate convex decomposition
+   *
+   *  Decomposition and cooking run on the worker pool, do not call from a pool task. The
+   *  cooked hulls are cached on disk, keyed by the file content, the cooking parameters and
+   *  the decomposition parameters, so only the first load decomposes the mesh. Decompositions
+   *  are registered and evicted like mesh groups.
+   */
+  std::vector<physx::PxConvexMesh *>
+  loadMeshDecomposition(const std::string &filename, ConvexDecompositionParams const &params = {},
+                        bool useCache = true, bool saveCache = true);
+  std::vector<physx::PxConvexMesh *>
+  acquireMeshDecomposition(const std::string &filename,
+                           ConvexDecompositionParams const &params = {}, bool useCache = true,
+                           bool saveCache = true);
+
+  /** Load all meshes in a file as one triangle mesh, for static and kinematic actors only
+   *
+   *  Cooked with Simulation::mTriangleMeshCooking and cached like convex meshes.
+   */
+  physx::PxTriangleMesh *loadNonConvexMesh(const std::string &filename, bool useCache = true,
+                                           bool saveCache = true);
+  physx::PxTriangleMesh *acquireNonConvexMesh(const std::string &filename, bool useCache = true,
+                                              bool saveCache = true);
+
+  struct Stats {
+    uint32_t residentMeshes; // single meshes, group parts and triangle meshes
+    size_t residentBytes;
+    uint32_t unusedMeshes; // resident meshes not used by any shape
+    size_t unusedBytes;
+    uint64_t evictedMeshes; // since creation
+  };
+  Stats getStats();
+
+  /** Cooked bytes kept resident before unused meshes are evicted, 0 means no limit */
+  void setMemoryBudget(size_t bytes);
+  inline size_t getMemoryBudget() const { return mMemoryBudget; }
+
+  /* Release every mesh not used by any shape, returns the number of meshes released */
+  uint32_t evictUnusedMeshes();
+
+  /** Builders replace convex meshes by a box, sphere or capsule when the enclosing primitive
+   *  exceeds the hull volume by at most this fraction, 0 disables fitting. Primitive contacts
+   *  are much cheaper than convex-convex contacts. */
+  void setPrimitiveFitTolerance(float tolerance);
+  float getPrimitiveFitTolerance();
+
+  /** Fit a primitive to a mesh used by a shape and record the result
+   *  @param shape name of the shape in the report
+   *  @return type None when fitting is disabled or the error exceeds the tolerance
+   */
+  PrimitiveFit fitShape(physx::PxConvexMesh *mesh, physx::PxVec3 const &scale,
+                        std::string const &shape);
+  /* latest fit of every shape built with fitting enabled */
+  std::vector<PrimitiveFitRecord> getPrimitiveFitReport();
+  void clearPrimitiveFitReport();
+
+  /** worker threads used by asynchronous loads, 0 means one per hardware thread */
+  void setNumThreads(uint32_t n);
+  inline uint32_t getNumThreads() const { return mNumThreads; }
+
+  /* Block until all asynchronous loads have finished and release the workers, loads running
+   * parallel work on other threads keep them until they return */
+  void waitForPendingLoads();
+
+private:
+  std::shared_future<physx::PxConvexMesh *> requestMesh(const std::string &filename,
+                                                         bool useCache, bool saveCache,
+                                                         bool async);
+  physx::PxConvexMesh *cookMesh(const std::string &filename, bool useCache, bool saveCache,
+                                bool &cached, size_t &bytes);
+  /* Evict unused meshes in LRU order until the budget is met, mMutex must be held. The entry
+   * named keep, if any, is never evicted. Returns the number of meshes released */
+  uint32_t evict(size_t budget, std::string const &keep = "");
+  uint64_t cookingHash() const;
+  uint64_t triangleMeshCookingHash() const;
+  uint64_t decompositionHash(ConvexDecompositionParams const &params) const;
+  /* registry key of a decomposition, files may be decomposed with different parameters */
+  std::string decompositionKey(const std::string &fullPath,
+                               ConvexDecompositionParams const &params) const;
+  std::vector<physx::PxConvexMesh *> cookDecomposition(const std::string &filename,
+                                                       ConvexDecompositionParams const &params,
+                                                       bool useCache, bool saveCache,
+                                                       size_t &bytes);
+  std::string getCacheEntry(const std::string &filename, uint64_t paramsHash,
+                            const std::string &suffix);
+  physx::PxTriangleMesh *cookNonConvexMesh(const std::string &filename, bool useCache,
+                                           bool saveCache, size_t &bytes);
+  std::shared_ptr<utils::ThreadPool> getThreadPool();
+
 public:
-  // cache config
+  /** Cooked meshes are cached in PhysX binary format, keyed by a hash of the file content and
+   *  the cooking parameters, so edited files are cooked again. The directory defaults to
+   *  $XDG_CACHE_HOME/sapien/convex or ~/.cache/sapien/convex. */
+  void setCacheDirectory(const std::string &directory);
+  inline std::string getCacheDirectory() const { return mCacheDirectory; }
 
-  void setCacheSuffix(const std::string &filename);
+  /* Cache entry of a mesh file, empty if the file cannot be read */
   std::string getCachedFilename(const std::string &filename);
 };
 } // namespace sapien
@@ -0,0 +1,93 @@
+#include "primitive_fit.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+PrimitiveFit fitPrimitive(PxConvexMesh &mesh, PxVec3 const &scale) {
+  PrimitiveFit result;
+  PxMassProperties props(PxConvexMeshGeometry(&mesh, PxMeshScale(scale)));
+  PxReal volume = props.mass; // unit density
+  if (!(volume > 0)) {
+    return result;
+  }
+
+  // fit in the principal frame of the hull
+  PxQuat frame;
+  PxVec3 moments = PxMassProperties::getMassSpaceInertia(props.inertiaTensor, frame);
+  PxTransform principal(props.centerOfMass, frame);
+  std::vector<PxVec3> points(mesh.getNbVertices());
+  PxBounds3 bounds = PxBounds3::empty();
+  for (uint32_t i = 0; i < points.size(); ++i) {
+    points[i] = principal.transformInv(mesh.getVertices()[i].multiply(scale));
+    bounds.include(points[i]);
+  }
+
+  PrimitiveFit box;
+  box.type = PrimitiveFit::Box;
+  box.halfExtents = bounds.getExtents();
+  box.pose = principal * PxTransform(bounds.getCenter());
+  box.error = 8 * box.halfExtents.x * box.halfExtents.y * box.halfExtents.z / volume - 1;
+
+  // centered on the bounds or on the center of mass, whichever is smaller
+  PrimitiveFit sphere;
+  sphere.type = PrimitiveFit::Sphere;
+  sphere.radius = std::numeric_limits<PxReal>::infinity();
+  for (PxVec3 center : {bounds.getCenter(), PxVec3(0)}) {
+    PxReal radius = 0;
+    for (auto &p : points) {
+      radius = std::max(radius, (p - center).magnitude());
+    }
+    if (radius < sphere.radius) {
+      sphere.radius = radius;
+      sphere.pose = principal * PxTransform(center);
+    }
+  }
+  sphere.error = 4.f / 3.f * PxPi * std::pow(sphere.radius, 3.f) / volume - 1;
+
+  // along the axis of least inertia, the shortest segment keeping every point within radius
+  uint32_t a = moments.x <= moments.y ? (moments.x <= moments.z ? 0 : 2)
+                                      : (moments.y <= moments.z ? 1 : 2);
+  uint32_t b = (a + 1) % 3;
+  uint32_t c = (a + 2) % 3;
+  PxVec3 center = bounds.getCenter();
+  PxReal radius = 0;
+  for (auto &p : points) {
+    radius = std::max(radius, PxVec2(p[b] - center[b], p[c] - center[c]).magnitude());
+  }
+  PxReal hi = -std::numeric_limits<PxReal>::infinity();
+  PxReal lo = std::numeric_limits<PxReal>::infinity();
+  for (auto &p : points) {
+    PxReal d2 = PxVec2(p[b] - center[b], p[c] - center[c]).magnitudeSquared();
+    PxReal s = std::sqrt(std::max(0.f, radius * radius - d2));
+    hi = std::max(hi, p[a] - s);
+    lo = std::min(lo, p[a] + s);
+  }
+  center[a] = (hi + lo) / 2;
+  PxVec3 axes[3] = {PxVec3(1, 0, 0), PxVec3(0, 1, 0), PxVec3(0, 0, 1)};
+  PrimitiveFit capsule;
+  capsule.type = PrimitiveFit::Capsule;
+  capsule.radius = radius;
+  capsule.halfLength = std::max(0.f, (hi - lo) / 2);
+  // cyclic permutation of the axes, x maps to the capsule axis
+  capsule.pose = principal * PxTransform(center, PxQuat(PxMat33(axes[a], axes[b], axes[c])));
+  capsule.error = (PxPi * radius * radius * 2 * capsule.halfLength +
+                   4.f / 3.f * PxPi * radius * radius * radius) /
+                      volume -
+                  1;
+
+  result = box;
+  if (sphere.error < result.error) {
+    result = sphere;
+  }
+  // a capsule of no length is the sphere, rounding would pick either on round meshes
+  if (capsule.halfLength > 1e-3f * capsule.radius && capsule.error < result.error) {
+    result = capsule;
+  }
+  return result;
+}
+
+} // namespace sapien
@@ -0,0 +1,27 @@
+#pragma once
+#include <PxPhysicsAPI.h>
+
+namespace sapien {
+
+/** Box, sphere or capsule enclosing a convex mesh */
+struct PrimitiveFit {
+  enum Type { None, Box, Sphere, Capsule } type = None;
+  /* pose of the primitive in the mesh frame, the capsule axis is its x axis */
+  physx::PxTransform pose = physx::PxTransform(physx::PxIdentity);
+  physx::PxVec3 halfExtents = {0, 0, 0}; // box
+  physx::PxReal radius = 0;              // sphere and capsule
+  physx::PxReal halfLength = 0;          // capsule
+  /* volume of the primitive over the volume of the hull, minus 1 */
+  physx::PxReal error = 0;
+};
+
+/** Fit the enclosing primitive of smallest volume to a scaled convex mesh
+ *
+ *  Boxes are aligned with the principal axes of the hull and capsules with its longest axis.
+ *  The primitive contains the hull, so its volume in excess of the hull volume is the volume
+ *  of their difference. Capsules of negligible length are fitted as spheres. Type is None for
+ *  degenerate hulls.
+ */
+PrimitiveFit fitPrimitive(physx::PxConvexMesh &mesh, physx::PxVec3 const &scale = {1, 1, 1});
+
+} // namespace sapien
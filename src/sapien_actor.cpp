@@ -1,4 +1,5 @@
 #include "sapien_actor.h"
+#include "kinematic_motion.h"
 #include "renderer/render_interface.h"
 #include "sapien_scene.h"
 #include <spdlog/spdlog.h>
@@ -10,6 +11,8 @@ SActor::SActor(PxRigidDynamic *actor, physx_id_t id, SScene *scene,
                std::vector<Renderer::IPxrRigidbody *> collisionBodies)
     : SActorDynamicBase(id, scene, renderBodies, collisionBodies), mActor(actor) {}
 
+SActor::~SActor() = default;
+
 PxRigidDynamic *SActor::getPxActor() { return mActor; }
 
 void SActor::destroy() { mParentScene->removeActor(this); }
@@ -97,6 +100,24 @@ void SActor::unpackData(std::vector<PxReal> const &data) {
   }
 }
 
+KinematicMotion *SActor::createKinematicMotion() {
+  if (getType() != EActorType::KINEMATIC) {
+    spdlog::get("SAPIEN")->error("Failed to create kinematic motion: actor is not kinematic");
+    return nullptr;
+  }
+  mKinematicMotion = std::make_unique<KinematicMotion>();
+  return mKinematicMotion.get();
+}
+
+void SActor::removeKinematicMotion() { mKinematicMotion.reset(); }
+
+void SActor::prestep() {
+  SActorBase::prestep();
+  if (mKinematicMotion && mKinematicMotion->isRunning()) {
+    mActor->setKinematicTarget(mKinematicMotion->advance(mParentScene->getTimestep()));
+  }
+}
+
 SActorStatic::SActorStatic(PxRigidStatic *actor, physx_id_t id, SScene *scene,
                            std::vector<Renderer::IPxrRigidbody *> renderBodies,
                            std::vector<Renderer::IPxrRigidbody *> collisionBodies)
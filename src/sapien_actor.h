@@ -2,6 +2,7 @@
 #include "id_generator.h"
 #include "sapien_actor_base.h"
 #include <PxPhysicsAPI.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,6 +12,7 @@ using namespace physx;
 class SDrive;
 class SScene;
 class ActorBuilder;
+class KinematicMotion;
 namespace Renderer {
 class IPxrRigidbody;
 }
@@ -20,6 +22,7 @@ class SActor : public SActorDynamicBase {
 
 private:
   PxRigidDynamic *mActor = nullptr;
+  std::unique_ptr<KinematicMotion> mKinematicMotion;
 
 public:
   PxRigidDynamic *getPxActor() override;
@@ -36,6 +39,17 @@ public:
   std::vector<PxReal> packData();
   void unpackData(std::vector<PxReal> const &data);
 
+  /** Attach a scripted motion to a kinematic actor, replacing any previous one
+   *  The motion sets the kinematic target before every step, see KinematicMotion
+   */
+  KinematicMotion *createKinematicMotion();
+  inline KinematicMotion *getKinematicMotion() const { return mKinematicMotion.get(); }
+  void removeKinematicMotion();
+
+  void prestep() override;
+
+  ~SActor();
+
 private:
   /* Only actor builder can create actor */
   SActor(PxRigidDynamic *actor, physx_id_t id, SScene *scene,
@@ -60,7 +74,7 @@ public:
 public:
   void destroy();
 
-private:
+protected:
   /* Only actor builder can create actor */
   SActorStatic(PxRigidStatic *actor, physx_id_t id, SScene *scene,
                std::vector<Renderer::IPxrRigidbody *> renderBodies,
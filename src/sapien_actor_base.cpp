@@ -152,6 +152,53 @@ std::vector<std::unique_ptr<SShape>> SActorBase::getCollisionShapes() {
       outputShape->geometry = std::move(sg);
       break;
     }
+    case PxGeometryType::eTRIANGLEMESH: {
+      outputShape->type = "nonconvex_mesh";
+      PxTriangleMeshGeometry g;
+      shape->getTriangleMeshGeometry(g);
+      auto sg = std::make_unique<SNonconvexMeshGeometry>();
+      sg->scale = g.scale.scale;
+      sg->rotation = g.scale.rotation;
+
+      sg->vertices.reserve(3 * g.triangleMesh->getNbVertices());
+      auto vertices = g.triangleMesh->getVertices();
+      for (uint32_t i = 0; i < g.triangleMesh->getNbVertices(); ++i) {
+        sg->vertices.push_back(vertices[i].x);
+        sg->vertices.push_back(vertices[i].y);
+        sg->vertices.push_back(vertices[i].z);
+      }
+
+      uint32_t nIndices = 3 * g.triangleMesh->getNbTriangles();
+      sg->indices.reserve(nIndices);
+      if (g.triangleMesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES) {
+        auto indices = static_cast<PxU16 const *>(g.triangleMesh->getTriangles());
+        sg->indices.assign(indices, indices + nIndices);
+      } else {
+        auto indices = static_cast<PxU32 const *>(g.triangleMesh->getTriangles());
+        sg->indices.assign(indices, indices + nIndices);
+      }
+      outputShape->geometry = std::move(sg);
+      break;
+    }
+    case PxGeometryType::eHEIGHTFIELD: {
+      outputShape->type = "height_field";
+      PxHeightFieldGeometry g;
+      shape->getHeightFieldGeometry(g);
+      auto sg = std::make_unique<SHeightFieldGeometry>();
+      sg->rows = g.heightField->getNbRows();
+      sg->cols = g.heightField->getNbColumns();
+      sg->rowScale = g.rowScale;
+      sg->columnScale = g.columnScale;
+
+      sg->heights.reserve(sg->rows * sg->cols);
+      for (uint32_t i = 0; i < sg->rows; ++i) {
+        for (uint32_t j = 0; j < sg->cols; ++j) {
+          sg->heights.push_back(g.heightField->getHeight(i, j) * g.heightScale);
+        }
+      }
+      outputShape->geometry = std::move(sg);
+      break;
+    }
     default:
       spdlog::get("SAPIEN")->critical("Unrecognized geometry in getCollisionShapes");
       throw std::runtime_error("Unrecognized geometry");
@@ -5,10 +5,12 @@
 namespace sapien {
 class SScene;
 class SActorBase;
+class SDriveGroup;
 
 using namespace physx;
 class SDrive {
   friend SScene;
+  friend SDriveGroup;
 
 private:
   SScene *mScene;
@@ -0,0 +1,129 @@
+#include "sapien_drive_group.h"
+#include "sapien_drive.h"
+#include "sapien_scene.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+SDriveGroup::SDriveGroup(SScene *scene, std::vector<SDrive *> const &drives) : mScene(scene) {
+  for (auto drive : drives) {
+    addDrive(drive);
+  }
+}
+
+void SDriveGroup::addDrive(SDrive *drive) {
+  if (!drive || drive->mScene != mScene) {
+    spdlog::get("SAPIEN")->error("Failed to add drive to group: drive is not in this scene.");
+    return;
+  }
+  if (std::find(mDrives.begin(), mDrives.end(), drive) != mDrives.end()) {
+    return;
+  }
+  mDrives.push_back(drive);
+  mStartTargets.push_back(drive->getTarget());
+  mEndTargets.push_back(drive->getTarget());
+}
+
+void SDriveGroup::removeDrive(SDrive *drive) {
+  auto it = std::find(mDrives.begin(), mDrives.end(), drive);
+  if (it == mDrives.end()) {
+    return;
+  }
+  size_t i = it - mDrives.begin();
+  mDrives.erase(it);
+  mStartTargets.erase(mStartTargets.begin() + i);
+  mEndTargets.erase(mEndTargets.begin() + i);
+}
+
+void SDriveGroup::setProperties(PxReal stiffness, PxReal damping, PxReal forceLimit,
+                                bool isAcceleration) {
+  for (auto drive : mDrives) {
+    drive->setProperties(stiffness, damping, forceLimit, isAcceleration);
+  }
+}
+
+void SDriveGroup::setTargets(Eigen::Ref<const PoseArray> const &targets,
+                             uint32_t interpolationSteps) {
+  if (static_cast<size_t>(targets.rows()) != mDrives.size()) {
+    spdlog::get("SAPIEN")->error("Failed to set drive targets: expected {} rows, got {}",
+                                 mDrives.size(), targets.rows());
+    return;
+  }
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    auto row = targets.row(i);
+    mEndTargets[i] = {{row(0), row(1), row(2)}, PxQuat(row(4), row(5), row(6), row(3))};
+  }
+
+  if (interpolationSteps == 0) {
+    mInterpolationSteps = mInterpolationStep = 0;
+    for (size_t i = 0; i < mDrives.size(); ++i) {
+      mDrives[i]->mJoint->setDrivePosition(mEndTargets[i]);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    mStartTargets[i] = mDrives[i]->mJoint->getDrivePosition();
+  }
+  mInterpolationSteps = interpolationSteps;
+  mInterpolationStep = 0;
+}
+
+SDriveGroup::PoseArray SDriveGroup::getTargets() const {
+  PoseArray result(mDrives.size(), 7);
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    PxTransform pose = mDrives[i]->mJoint->getDrivePosition();
+    result.row(i) << pose.p.x, pose.p.y, pose.p.z, pose.q.w, pose.q.x, pose.q.y, pose.q.z;
+  }
+  return result;
+}
+
+void SDriveGroup::setTargetVelocities(Eigen::Ref<const VelocityArray> const &velocities) {
+  if (static_cast<size_t>(velocities.rows()) != mDrives.size()) {
+    spdlog::get("SAPIEN")->error("Failed to set drive velocities: expected {} rows, got {}",
+                                 mDrives.size(), velocities.rows());
+    return;
+  }
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    auto row = velocities.row(i);
+    mDrives[i]->mJoint->setDriveVelocity({row(0), row(1), row(2)}, {row(3), row(4), row(5)});
+  }
+}
+
+SDriveGroup::VelocityArray SDriveGroup::getTargetVelocities() const {
+  VelocityArray result(mDrives.size(), 6);
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    PxVec3 linear, angular;
+    mDrives[i]->mJoint->getDriveVelocity(linear, angular);
+    result.row(i) << linear.x, linear.y, linear.z, angular.x, angular.y, angular.z;
+  }
+  return result;
+}
+
+void SDriveGroup::prestep() {
+  if (!isInterpolating()) {
+    return;
+  }
+  ++mInterpolationStep;
+  PxReal alpha = static_cast<PxReal>(mInterpolationStep) / mInterpolationSteps;
+  for (size_t i = 0; i < mDrives.size(); ++i) {
+    PxTransform const &a = mStartTargets[i];
+    PxTransform const &b = mEndTargets[i];
+    PxQuat qb = a.q.dot(b.q) < 0 ? -b.q : b.q; // shortest arc
+    PxReal cosTheta = a.q.dot(qb);
+    PxQuat q;
+    if (cosTheta > 0.9995f) {
+      q = (a.q * (1 - alpha) + qb * alpha).getNormalized();
+    } else {
+      PxReal theta = PxAcos(cosTheta);
+      PxReal sinTheta = PxSin(theta);
+      q = a.q * (PxSin((1 - alpha) * theta) / sinTheta) + qb * (PxSin(alpha * theta) / sinTheta);
+    }
+    mDrives[i]->mJoint->setDrivePosition({a.p * (1 - alpha) + b.p * alpha, q});
+  }
+}
+
+void SDriveGroup::destroy() { mScene->removeDriveGroup(this); }
+
+} // namespace sapien
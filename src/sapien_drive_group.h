@@ -0,0 +1,69 @@
+#pragma once
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+class SScene;
+class SDrive;
+
+using namespace physx;
+
+/** A set of drives whose targets are written together
+ *
+ *  Targets are packed N x 7 arrays, one row (x, y, z, qw, qx, qy, qz) per drive, matching
+ *  the Pose layout. Target velocities are N x 6 arrays, one row (linear, angular) per drive.
+ *  Rows follow the order of getDrives(). A group does not own its drives, destroying a drive
+ *  removes it from every group.
+ */
+class SDriveGroup {
+  friend SScene;
+
+public:
+  using PoseArray = Eigen::Matrix<PxReal, Eigen::Dynamic, 7, Eigen::RowMajor>;
+  using VelocityArray = Eigen::Matrix<PxReal, Eigen::Dynamic, 6, Eigen::RowMajor>;
+
+private:
+  SScene *mScene;
+  std::vector<SDrive *> mDrives;
+
+  // targets are interpolated from mStartTargets to mEndTargets over mInterpolationSteps steps
+  std::vector<PxTransform> mStartTargets;
+  std::vector<PxTransform> mEndTargets;
+  uint32_t mInterpolationSteps{0};
+  uint32_t mInterpolationStep{0};
+
+  SDriveGroup(SScene *scene, std::vector<SDrive *> const &drives);
+
+public:
+  SDriveGroup(SDriveGroup const &other) = delete;
+  SDriveGroup &operator=(SDriveGroup const &other) = delete;
+
+  inline SScene *getScene() const { return mScene; }
+  inline std::vector<SDrive *> getDrives() const { return mDrives; }
+  inline uint32_t size() const { return mDrives.size(); }
+
+  void addDrive(SDrive *drive);
+  void removeDrive(SDrive *drive);
+
+  void setProperties(PxReal stiffness, PxReal damping, PxReal forceLimit, bool isAcceleration);
+
+  /** Set the targets of all drives
+   *  @param interpolationSteps when positive, targets move from the current targets to the
+   *         given ones over this many scene steps, translations linearly and rotations by slerp
+   */
+  void setTargets(Eigen::Ref<const PoseArray> const &targets, uint32_t interpolationSteps = 0);
+  PoseArray getTargets() const;
+
+  void setTargetVelocities(Eigen::Ref<const VelocityArray> const &velocities);
+  VelocityArray getTargetVelocities() const;
+
+  inline bool isInterpolating() const { return mInterpolationStep < mInterpolationSteps; }
+
+  // internal use only, advance interpolation before simulation
+  void prestep();
+
+  void destroy();
+};
+
+} // namespace sapien
@@ -0,0 +1,212 @@
+#include "sapien_height_field.h"
+#include "sapien_scene.h"
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+SHeightField::SHeightField(PxRigidStatic *actor, physx_id_t id, SScene *scene, PxReal cellSize,
+                           std::vector<PxMaterial *> const &materials, bool render,
+                           Renderer::PxrMaterial const &renderMaterial)
+    : SActorStatic(actor, id, scene, {}, {}), mCellSize(cellSize), mMaterials(materials),
+      mRender(render), mRenderMaterial(renderMaterial) {}
+
+SHeightField::~SHeightField() {
+  if (mHeightField) {
+    mHeightField->release();
+  }
+}
+
+bool SHeightField::setHeights(Heights const &heights, MaterialIndices const &materialIndices) {
+  uint32_t rows = heights.rows();
+  uint32_t cols = heights.cols();
+  if (rows < 2 || cols < 2) {
+    spdlog::get("SAPIEN")->error("Height field requires at least 2 x 2 heights, got {} x {}", rows,
+                                 cols);
+    return false;
+  }
+  if (!heights.allFinite()) {
+    spdlog::get("SAPIEN")->error("Height field heights must be finite");
+    return false;
+  }
+  MaterialIndices indices = materialIndices;
+  if (indices.size() == 0) {
+    indices = MaterialIndices::Zero(rows - 1, cols - 1);
+  }
+  if (indices.rows() != rows - 1 || indices.cols() != cols - 1) {
+    spdlog::get("SAPIEN")->error(
+        "Height field material indices must be (rows - 1) x (cols - 1) = {} x {}, got {} x {}",
+        rows - 1, cols - 1, indices.rows(), indices.cols());
+    return false;
+  }
+  for (uint32_t i = 0; i < indices.size(); ++i) {
+    uint8_t index = indices.data()[i];
+    if (index != HOLE && index >= mMaterials.size()) {
+      spdlog::get("SAPIEN")->error("Height field material index {} out of range", index);
+      return false;
+    }
+  }
+
+  // quantize to the full 16 bit range of this terrain
+  PxReal heightScale = std::max(heights.cwiseAbs().maxCoeff() / PX_MAX_I16,
+                                static_cast<PxReal>(PX_MIN_HEIGHTFIELD_Y_SCALE));
+
+  // PhysX samples are row-major with rows along the shape x axis, which getShapePose maps to the
+  // actor y axis. Cells are split along the (row, col) - (row + 1, col + 1) diagonal as in the
+  // render mesh.
+  std::vector<PxHeightFieldSample> samples(rows * cols);
+  for (uint32_t i = 0; i < rows; ++i) {
+    for (uint32_t j = 0; j < cols; ++j) {
+      auto &sample = samples[i * cols + j];
+      PxReal h = std::round(heights(i, j) / heightScale);
+      sample.height = static_cast<PxI16>(std::clamp<PxReal>(h, -PX_MAX_I16, PX_MAX_I16));
+      uint8_t index = (i + 1 < rows && j + 1 < cols) ? indices(i, j) : 0;
+      sample.materialIndex0 = PxBitAndByte(index, true);
+      sample.materialIndex1 = PxBitAndByte(index, false);
+    }
+  }
+
+  PxHeightFieldDesc desc;
+  desc.format = PxHeightFieldFormat::eS16_TM;
+  desc.nbRows = rows;
+  desc.nbColumns = cols;
+  desc.samples.data = samples.data();
+  desc.samples.stride = sizeof(PxHeightFieldSample);
+
+  auto simulation = mParentScene->getEngine();
+  if (mHeightField && mHeightField->getNbRows() == rows && mHeightField->getNbColumns() == cols) {
+    if (!mHeightField->modifySamples(0, 0, desc, true)) {
+      spdlog::get("SAPIEN")->error("Failed to modify height field samples");
+      return false;
+    }
+  } else {
+    PxHeightField *heightField = simulation->mCooking->createHeightField(
+        desc, simulation->mPhysicsSDK->getPhysicsInsertionCallback());
+    if (!heightField) {
+      spdlog::get("SAPIEN")->error("Failed to create height field");
+      return false;
+    }
+    // the shape holds its own reference to the previous height field
+    if (mHeightField) {
+      mHeightField->release();
+    }
+    mHeightField = heightField;
+  }
+
+  PxHeightFieldGeometry geometry(mHeightField, PxMeshGeometryFlags(), heightScale, mCellSize,
+                                 mCellSize);
+  if (!mShape) {
+    mShape = simulation->mPhysicsSDK->createShape(geometry, mMaterials.data(),
+                                                  static_cast<PxU16>(mMaterials.size()), true);
+    if (!mShape) {
+      spdlog::get("SAPIEN")->error("Failed to create height field shape");
+      return false;
+    }
+    PxFilterData data;
+    data.word0 = mCol1;
+    data.word1 = mCol2;
+    data.word2 = mCol3;
+    data.word3 = 0;
+    mShape->setSimulationFilterData(data);
+    mShape->setLocalPose(getShapePose(rows, cols));
+    getPxActor()->attachShape(*mShape);
+    mShape->release();
+  } else {
+    // also refreshes the shape bounds after modifySamples
+    mShape->setGeometry(geometry);
+    mShape->setLocalPose(getShapePose(rows, cols));
+  }
+
+  mHeights = heights;
+  mMaterialIndices = indices;
+  updateRenderBody();
+  return true;
+}
+
+PxReal SHeightField::getHeightAt(PxReal x, PxReal y) const {
+  uint32_t rows = getRows();
+  uint32_t cols = getCols();
+  if (rows == 0 || cols == 0) {
+    return 0.f;
+  }
+  PxReal u = std::clamp(x / mCellSize + (cols - 1) * 0.5f, 0.f, cols - 1.f);
+  PxReal v = std::clamp(y / mCellSize + (rows - 1) * 0.5f, 0.f, rows - 1.f);
+  uint32_t j = std::min(static_cast<uint32_t>(u), cols - 2);
+  uint32_t i = std::min(static_cast<uint32_t>(v), rows - 2);
+  PxReal fu = u - j;
+  PxReal fv = v - i;
+  return (1 - fv) * ((1 - fu) * mHeights(i, j) + fu * mHeights(i, j + 1)) +
+         fv * ((1 - fu) * mHeights(i + 1, j) + fu * mHeights(i + 1, j + 1));
+}
+
+PxTransform SHeightField::getShapePose(uint32_t rows, uint32_t cols) const {
+  // rotate the shape (x, y, z) axes to the actor (y, z, x) axes
+  return PxTransform({-(cols - 1) * mCellSize * 0.5f, -(rows - 1) * mCellSize * 0.5f, 0.f},
+                     PxQuat(0.5f, 0.5f, 0.5f, 0.5f));
+}
+
+void SHeightField::updateRenderBody() {
+  auto rendererScene = mParentScene->getRendererScene();
+  if (!mRender || !rendererScene) {
+    return;
+  }
+  for (auto body : mRenderBodies) {
+    body->destroy();
+  }
+  mRenderBodies.clear();
+
+  uint32_t rows = getRows();
+  uint32_t cols = getCols();
+  PxReal offsetX = -(cols - 1) * mCellSize * 0.5f;
+  PxReal offsetY = -(rows - 1) * mCellSize * 0.5f;
+
+  std::vector<PxVec3> vertices;
+  std::vector<PxVec3> normals;
+  vertices.reserve(rows * cols);
+  normals.reserve(rows * cols);
+  for (uint32_t i = 0; i < rows; ++i) {
+    for (uint32_t j = 0; j < cols; ++j) {
+      vertices.push_back({j * mCellSize + offsetX, i * mCellSize + offsetY, mHeights(i, j)});
+      uint32_t j0 = j > 0 ? j - 1 : j;
+      uint32_t j1 = j + 1 < cols ? j + 1 : j;
+      uint32_t i0 = i > 0 ? i - 1 : i;
+      uint32_t i1 = i + 1 < rows ? i + 1 : i;
+      PxReal dx = (mHeights(i, j1) - mHeights(i, j0)) / ((j1 - j0) * mCellSize);
+      PxReal dy = (mHeights(i1, j) - mHeights(i0, j)) / ((i1 - i0) * mCellSize);
+      normals.push_back(PxVec3(-dx, -dy, 1.f).getNormalized());
+    }
+  }
+
+  std::vector<uint32_t> indices;
+  indices.reserve((rows - 1) * (cols - 1) * 6);
+  for (uint32_t i = 0; i + 1 < rows; ++i) {
+    for (uint32_t j = 0; j + 1 < cols; ++j) {
+      if (mMaterialIndices(i, j) == HOLE) {
+        continue;
+      }
+      uint32_t a = i * cols + j;
+      uint32_t b = a + 1;
+      uint32_t c = a + cols + 1;
+      uint32_t d = a + cols;
+      indices.insert(indices.end(), {a, b, c, a, c, d});
+    }
+  }
+  if (indices.empty()) {
+    return;
+  }
+
+  auto body = rendererScene->addRigidbody(vertices, normals, indices, {1, 1, 1}, mRenderMaterial);
+  if (!body) {
+    return;
+  }
+  body->setSegmentationId(mId);
+  body->setUniqueId(mParentScene->mRenderIdGenerator.next());
+  if (mHidden) {
+    body->setVisible(false);
+  }
+  mRenderBodies.push_back(body);
+}
+
+} // namespace sapien
@@ -0,0 +1,73 @@
+#pragma once
+#include "render_interface.h"
+#include "sapien_actor.h"
+#include <Eigen/Dense>
+#include <PxPhysicsAPI.h>
+#include <vector>
+
+namespace sapien {
+using namespace physx;
+
+/** Static terrain backed by a PxHeightField
+ *
+ *  Heights form a rows x cols grid in the xy plane of the actor, row i at y and column j at x,
+ *  spaced by the cell size and centered at the actor origin. Each of the (rows - 1) x
+ *  (cols - 1) cells uses one of the actor materials, or is a hole when its index is HOLE.
+ *
+ *  setHeights replaces the terrain in place, so environments can generate new terrain between
+ *  episodes without recreating the actor or the scene. Heights are quantized to 16 bits over
+ *  the height range of each terrain.
+ */
+class SHeightField : public SActorStatic {
+  friend ActorBuilder;
+
+public:
+  using Heights = Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using MaterialIndices = Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  static constexpr uint8_t HOLE = PxHeightFieldMaterial::eHOLE;
+
+private:
+  PxHeightField *mHeightField{nullptr};
+  PxShape *mShape{nullptr};
+  PxReal mCellSize;
+  std::vector<PxMaterial *> mMaterials;
+
+  bool mRender;
+  Renderer::PxrMaterial mRenderMaterial;
+
+  Heights mHeights;
+  MaterialIndices mMaterialIndices;
+
+public:
+  SHeightField(SHeightField const &other) = delete;
+  SHeightField &operator=(SHeightField const &other) = delete;
+  ~SHeightField();
+
+  /** Replace the terrain, the grid size may change
+   *  @param materialIndices (rows - 1) x (cols - 1) material index of every cell, all 0 when
+   *         empty
+   *  @return false and keep the current terrain if the input is invalid
+   */
+  bool setHeights(Heights const &heights, MaterialIndices const &materialIndices = {});
+  inline Heights const &getHeights() const { return mHeights; }
+  inline MaterialIndices const &getMaterialIndices() const { return mMaterialIndices; }
+
+  inline PxReal getCellSize() const { return mCellSize; }
+  inline uint32_t getRows() const { return mHeights.rows(); }
+  inline uint32_t getCols() const { return mHeights.cols(); }
+  inline std::vector<PxMaterial *> getMaterials() const { return mMaterials; }
+
+  /* Bilinear height at a point in the actor frame, clamped to the terrain */
+  PxReal getHeightAt(PxReal x, PxReal y) const;
+
+private:
+  SHeightField(PxRigidStatic *actor, physx_id_t id, SScene *scene, PxReal cellSize,
+               std::vector<PxMaterial *> const &materials, bool render,
+               Renderer::PxrMaterial const &renderMaterial);
+
+  /* pose of the height field shape, PhysX height fields are y-up with rows along x */
+  PxTransform getShapePose(uint32_t rows, uint32_t cols) const;
+  void updateRenderBody();
+};
+
+} // namespace sapien
@@ -11,6 +11,7 @@
 #include "sapien_actor.h"
 #include "sapien_contact.h"
 #include "sapien_drive.h"
+#include "sapien_drive_group.h"
 #include "simulation.h"
 #include <algorithm>
 #include <spdlog/spdlog.h>
@@ -231,6 +232,9 @@ void SScene::removeDrive(SDrive *drive) {
   if (drive->mScene != this) {
     spdlog::get("SAPIEN")->error("Failed to remove drive: drive is not in this scene.");
   }
+  for (auto &group : mDriveGroups) {
+    group->removeDrive(drive);
+  }
   drive->mJoint->release();
   if (drive->mActor1) {
     drive->mActor1->removeDrive(drive);
@@ -382,6 +386,9 @@ void SScene::step() {
     if (!a->isBeingDestroyed())
       a->prestep();
   }
+  for (auto &g : mDriveGroups) {
+    g->prestep();
+  }
 
 #ifdef _PROFILE
   EASY_END_BLOCK;
@@ -416,6 +423,9 @@ void SScene::stepAsync() {
     if (!a->isBeingDestroyed())
       a->prestep();
   }
+  for (auto &g : mDriveGroups) {
+    g->prestep();
+  }
   mPxScene->simulate(mTimestep);
 }
 
@@ -518,6 +528,17 @@ SDrive *SScene::createDrive(SActorBase *actor1, PxTransform const &pose1, SActor
   return drive;
 }
 
+SDriveGroup *SScene::createDriveGroup(std::vector<SDrive *> const &drives) {
+  mDriveGroups.push_back(std::unique_ptr<SDriveGroup>(new SDriveGroup(this, drives)));
+  return mDriveGroups.back().get();
+}
+
+void SScene::removeDriveGroup(SDriveGroup *group) {
+  mDriveGroups.erase(std::remove_if(mDriveGroups.begin(), mDriveGroups.end(),
+                                    [group](auto &g) { return g.get() == group; }),
+                     mDriveGroups.end());
+}
+
 void SScene::removeMountedCameraByMount(SActorBase *actor) {
   for (auto &cam : mCameras) {
     if (cam.actor == actor) {
@@ -23,6 +23,8 @@ class ActorBuilder;
 class LinkBuilder;
 class ArticulationBuilder;
 class SDrive;
+class SDriveGroup;
+class SHeightField;
 struct SContact;
 
 namespace Renderer {
@@ -40,6 +42,7 @@ class SScene : public EventEmitter<EventStep> {
   friend ActorBuilder;
   friend LinkBuilder;
   friend ArticulationBuilder;
+  friend SHeightField;
 
 private:
   // defaults
@@ -80,6 +83,7 @@ private:
       std::unique_ptr<SKArticulation> articulation); // called by articulation builder
 
   std::vector<std::unique_ptr<SDrive>> mDrives;
+  std::vector<std::unique_ptr<SDriveGroup>> mDriveGroups;
 
  private:
   bool mRequiresRemoveCleanUp;
@@ -126,12 +130,18 @@ public:
    */
   void removeKinematicArticulation(SKArticulation *articulation);
 
-  /** Remove a drive immediately */
+  /** Remove a drive immediately, it is also removed from its drive groups */
   void removeDrive(SDrive *drive);
 
   SDrive *createDrive(SActorBase *actor1, PxTransform const &pose1, SActorBase *actor2,
                       PxTransform const &pose2);
 
+  /** Create a group to set targets of many drives at once, see SDriveGroup */
+  SDriveGroup *createDriveGroup(std::vector<SDrive *> const &drives = {});
+
+  /** Remove a drive group immediately, its drives are kept */
+  void removeDriveGroup(SDriveGroup *group);
+
 public:
   SActorBase *findActorById(physx_id_t id) const;
   SLinkBase *findArticulationLinkById(physx_id_t id) const;
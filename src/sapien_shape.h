@@ -28,8 +28,24 @@ struct SConvexMeshGeometry : public SGeometry {
   std::vector<uint32_t> indices;
 };
 
+struct SNonconvexMeshGeometry : public SGeometry {
+  physx::PxVec3 scale;
+  physx::PxQuat rotation;
+  std::vector<physx::PxReal> vertices;
+  std::vector<uint32_t> indices;
+};
+
 struct SPlaneGeometry : public SGeometry {};
 
+/* heights in the shape frame, which is y-up with rows along x and columns along z */
+struct SHeightFieldGeometry : public SGeometry {
+  uint32_t rows;
+  uint32_t cols;
+  physx::PxReal rowScale;
+  physx::PxReal columnScale;
+  std::vector<physx::PxReal> heights;
+};
+
 struct SShape {
   std::string type = "invalid";
   physx::PxTransform pose = physx::PxTransform(physx::PxIdentity);
@@ -82,6 +82,20 @@ Simulation::Simulation(uint32_t nthread, PxReal toleranceLength, PxReal toleranc
     throw std::runtime_error("Simulation Creation Failed");
   }
 
+  // static geometry is cooked once and queried every step, trade cooking time for query speed
+  PxCookingParams triangleMeshParams(toleranceScale);
+  triangleMeshParams.midphaseDesc.setToDefault(PxMeshMidPhase::eBVH34);
+  triangleMeshParams.midphaseDesc.mBVH34Desc.numPrimsPerLeaf = 4;
+  triangleMeshParams.meshCookingHint = PxMeshCookingHint::eSIM_PERFORMANCE;
+  triangleMeshParams.meshPreprocessParams = PxMeshPreprocessingFlag::eWELD_VERTICES;
+  triangleMeshParams.meshWeldTolerance = 1e-4f * toleranceScale.length;
+  triangleMeshParams.suppressTriangleMeshRemapTable = true;
+  mTriangleMeshCooking = PxCreateCooking(PX_PHYSICS_VERSION, *mFoundation, triangleMeshParams);
+  if (!mTriangleMeshCooking) {
+    spdlog::get("SAPIEN")->critical("Failed to create PhysX Cooking");
+    throw std::runtime_error("Simulation Creation Failed");
+  }
+
   if (!PxInitExtensions(*mPhysicsSDK, nullptr)) {
     spdlog::get("SAPIEN")->critical("Failed to initialize PhysX Extensions");
     throw std::runtime_error("Simulation Creation Failed");
@@ -89,11 +103,14 @@ Simulation::Simulation(uint32_t nthread, PxReal toleranceLength, PxReal toleranc
 }
 
 Simulation::~Simulation() {
+  // asynchronous mesh loads use the cooking library and the SDK
+  mMeshManager.waitForPendingLoads();
   // mDefaultMaterial->release();
   if (mCpuDispatcher) {
     mCpuDispatcher->release();
   }
   mCooking->release();
+  mTriangleMeshCooking->release();
   PxCloseExtensions();
   mPhysicsSDK->release();
 #ifdef _PVD
@@ -36,6 +36,8 @@ public:
   PxPhysics *mPhysicsSDK = nullptr;
   PxFoundation *mFoundation = nullptr;
   PxCooking *mCooking = nullptr;
+  // triangle meshes are cooked with their own parameters, tuned for query speed
+  PxCooking *mTriangleMeshCooking = nullptr;
 
   SapienErrorCallback mErrorCallback;
 
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace sapien::utils {
+
+/** Fixed size worker pool
+ *
+ *  Tasks must not block on other tasks of the same pool, parallelFor in particular should not
+ *  be called from inside a task.
+ */
+class ThreadPool {
+  std::vector<std::thread> mWorkers;
+  std::queue<std::function<void()>> mTasks;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mStop{false};
+
+public:
+  /* 0 threads means one per hardware thread */
+  explicit ThreadPool(uint32_t numThreads = 0) {
+    if (numThreads == 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint32_t i = 0; i < numThreads; ++i) {
+      mWorkers.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+            if (mStop && mTasks.empty()) {
+              return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto &worker : mWorkers) {
+      worker.join();
+    }
+  }
+
+  inline uint32_t size() const { return mWorkers.size(); }
+
+  template <typename F> auto submit(F &&f) -> std::future<decltype(f())> {
+    using R = decltype(f());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTasks.emplace([task] { (*task)(); });
+    }
+    mCondition.notify_one();
+    return future;
+  }
+
+  /** Call fn(i, chunk) for every i in [begin, end) and wait for completion
+   *
+   *  The range is split into at most size() contiguous chunks, each executed by one task.
+   *  chunk is in [0, size()) and unique among running tasks, so it can index per-thread
+   *  scratch data. Exceptions are rethrown on the calling thread.
+   */
+  template <typename F> void parallelFor(size_t begin, size_t end, F &&fn) {
+    if (end <= begin) {
+      return;
+    }
+    size_t n = end - begin;
+    size_t chunks = std::min<size_t>(size(), n);
+    size_t chunkSize = (n + chunks - 1) / chunks;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+      size_t b = begin + c * chunkSize;
+      size_t e = std::min(end, b + chunkSize);
+      if (b >= e) {
+        break;
+      }
+      futures.push_back(submit([&fn, b, e, c] {
+        for (size_t i = b; i < e; ++i) {
+          fn(i, static_cast<uint32_t>(c));
+        }
+      }));
+    }
+    // wait for every chunk before rethrowing, they all reference fn
+    std::exception_ptr error;
+    for (auto &f : futures) {
+      try {
+        f.get();
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+} // namespace sapien::utils
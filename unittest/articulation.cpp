@@ -8,6 +8,7 @@
 #include "sapien_drive.h"
 #include "sapien_scene.h"
 #include "simulation.h"
+#include "utils/thread_pool.hpp"
 
 #include "catch.hpp"
 
@@ -159,3 +160,74 @@ TEST_CASE("Testing Ant runs without error", "[articulation]") {
   }
   REQUIRE_NO_ERROR(sim);
 }
+
+TEST_CASE("Query contexts run concurrently", "[articulation]") {
+  Simulation sim;
+  auto s0 = sim.createScene();
+  s0->setTimestep(1 / 60.f);
+  s0->addGround(-1);
+
+  auto builder = createAntBuilder(*s0);
+  std::vector<SArticulation *> ants;
+  for (int i = 0; i < 4; ++i) {
+    auto ant = builder->build(false);
+    ant->setRootPose({{2.f * i, 0, 2}, PxIdentity});
+    ant->setQpos({0.1f * i, 0.2f, -0.1f, 0.3f, 0.6f, 0.8f, 1.f, 0.7f});
+    ants.push_back(ant);
+  }
+  for (int i = 0; i < 5; ++i) {
+    s0->step();
+  }
+
+  utils::ThreadPool pool(8);
+  std::vector<std::unique_ptr<ArticulationQueryContext>> contexts;
+  for (uint32_t t = 0; t < pool.size(); ++t) {
+    for (auto ant : ants) {
+      contexts.push_back(ant->createQueryContext());
+    }
+  }
+
+  // last results of every context, each is only used by its worker
+  std::vector<Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> mass(
+      contexts.size());
+  std::vector<std::vector<PxReal>> passiveForce(contexts.size());
+
+  // contexts follow the articulations through steps and state changes
+  for (int round = 0; round < 3; ++round) {
+    if (round == 2) {
+      for (auto ant : ants) {
+        ant->setQpos({0.5f, -0.2f, 0.1f, 0.3f, -0.6f, 0.8f, 0.2f, 0.4f});
+      }
+    } else {
+      for (int i = 0; i < 5; ++i) {
+        s0->step();
+      }
+    }
+
+    // Catch assertions are not thread-safe, compare after the workers are done
+    pool.parallelFor(0, 1000, [&](size_t i, uint32_t worker) {
+      uint32_t c = worker * ants.size() + i % ants.size();
+      mass[c] = contexts[c]->computeManipulatorInertiaMatrix();
+      passiveForce[c] = contexts[c]->computePassiveForce();
+    });
+
+    // reference values from the shared articulation cache, computed after the contexts so
+    // that they cannot prepare the articulation for them
+    for (uint32_t a = 0; a < ants.size(); ++a) {
+      auto referenceMass = ants[a]->computeManipulatorInertiaMatrix();
+      auto referenceForce = ants[a]->computePassiveForce();
+      for (uint32_t c = a; c < contexts.size(); c += ants.size()) {
+        if (passiveForce[c].empty()) {
+          continue;
+        }
+        REQUIRE((mass[c] - referenceMass).cwiseAbs().maxCoeff() < 1e-4f);
+        for (uint32_t d = 0; d < referenceForce.size(); ++d) {
+          REQUIRE(passiveForce[c][d] == Approx(referenceForce[d]).margin(1e-4f));
+        }
+        passiveForce[c].clear();
+      }
+    }
+  }
+
+  REQUIRE_NO_ERROR(sim);
+}
@@ -0,0 +1,74 @@
+#include "actor_builder.h"
+#include "common.h"
+#include "sapien_height_field.h"
+#include "sapien_scene.h"
+#include "simulation.h"
+
+#include "catch.hpp"
+
+using namespace sapien;
+
+TEST_CASE("Height field interpolates its heights", "[height_field]") {
+  Simulation sim;
+  auto s0 = sim.createScene();
+
+  // 3 rows at y = -2, 0, 2 and 2 columns at x = -1, 1
+  SHeightField::Heights heights(3, 2);
+  heights << 0, 1, 2, 3, 4, 8;
+  auto terrain = s0->createActorBuilder()->buildHeightField(heights, 2.f, {}, {}, false);
+  REQUIRE(terrain);
+  REQUIRE(terrain->getRows() == 3);
+  REQUIRE(terrain->getCols() == 2);
+
+  SECTION("grid points") {
+    REQUIRE(terrain->getHeightAt(-1, -2) == Approx(0));
+    REQUIRE(terrain->getHeightAt(1, -2) == Approx(1));
+    REQUIRE(terrain->getHeightAt(-1, 0) == Approx(2));
+    REQUIRE(terrain->getHeightAt(1, 2) == Approx(8));
+  }
+
+  SECTION("bilinear between grid points") {
+    REQUIRE(terrain->getHeightAt(0, 0) == Approx(2.5));
+    REQUIRE(terrain->getHeightAt(0, 1) == Approx(4.25));
+    REQUIRE(terrain->getHeightAt(0.5f, -1) == Approx(1.75));
+  }
+
+  SECTION("clamped outside the terrain") {
+    REQUIRE(terrain->getHeightAt(-5, -5) == Approx(0));
+    REQUIRE(terrain->getHeightAt(5, 5) == Approx(8));
+    REQUIRE(terrain->getHeightAt(-5, 0) == Approx(2));
+  }
+
+  SECTION("replaced heights") {
+    // the cell size stays 2, columns at x = -3, -1, 1, 3 and rows at y = -3, -1, 1, 3
+    SHeightField::Heights flat = SHeightField::Heights::Constant(4, 4, 0.5f);
+    flat(3, 3) = 1.5f;
+    REQUIRE(terrain->setHeights(flat));
+    REQUIRE(terrain->getRows() == 4);
+    REQUIRE(terrain->getHeightAt(0, 0) == Approx(0.5));
+    REQUIRE(terrain->getHeightAt(3, 3) == Approx(1.5));
+    REQUIRE(terrain->getHeightAt(1, 1.5f) == Approx(0.5));
+    REQUIRE(terrain->getHeightAt(3, 2) == Approx(1));
+
+    // invalid input keeps the current terrain
+    REQUIRE_FALSE(terrain->setHeights(SHeightField::Heights::Zero(1, 1)));
+    REQUIRE(terrain->getRows() == 4);
+    REQUIRE(terrain->getHeightAt(0, 0) == Approx(0.5));
+  }
+
+  REQUIRE_NO_ERROR(sim);
+}
+
+TEST_CASE("Height field rejects invalid input", "[height_field]") {
+  Simulation sim;
+  auto s0 = sim.createScene();
+  auto builder = s0->createActorBuilder();
+
+  REQUIRE_FALSE(builder->buildHeightField(SHeightField::Heights::Zero(2, 2), 0.f, {}, {}, false));
+  REQUIRE_FALSE(builder->buildHeightField(SHeightField::Heights::Zero(1, 3), 1.f, {}, {}, false));
+
+  // one material index per cell
+  SHeightField::MaterialIndices indices = SHeightField::MaterialIndices::Zero(2, 2);
+  REQUIRE_FALSE(
+      builder->buildHeightField(SHeightField::Heights::Zero(2, 2), 1.f, {}, indices, false));
+}
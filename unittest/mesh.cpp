@@ -0,0 +1,254 @@
+#include "convex_decomposition.h"
+#include "mesh_manager.h"
+#include "primitive_fit.h"
+#include "simulation.h"
+#include <cmath>
+
+#include "catch.hpp"
+
+using namespace sapien;
+using namespace physx;
+
+/* axis aligned box as an indexed mesh, appended to vertices and triangles */
+static void addBox(std::vector<PxVec3> &vertices, std::vector<uint32_t> &triangles,
+                   PxVec3 const &center, PxVec3 const &halfExtents) {
+  uint32_t base = vertices.size();
+  for (uint32_t i = 0; i < 8; ++i) {
+    vertices.push_back(center + PxVec3(i & 1 ? halfExtents.x : -halfExtents.x,
+                                       i & 2 ? halfExtents.y : -halfExtents.y,
+                                       i & 4 ? halfExtents.z : -halfExtents.z));
+  }
+  static const uint32_t faces[12][3] = {{0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6},
+                                        {0, 1, 4}, {1, 5, 4}, {2, 6, 3}, {3, 6, 7},
+                                        {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}};
+  for (auto &f : faces) {
+    triangles.insert(triangles.end(), {base + f[0], base + f[1], base + f[2]});
+  }
+}
+
+/* the same mesh with 3 vertices of its own for every triangle */
+static void toSoup(std::vector<PxVec3> &vertices, std::vector<uint32_t> &triangles) {
+  std::vector<PxVec3> soup;
+  soup.reserve(triangles.size());
+  for (uint32_t i = 0; i < triangles.size(); ++i) {
+    soup.push_back(vertices[triangles[i]]);
+    triangles[i] = i;
+  }
+  vertices = std::move(soup);
+}
+
+TEST_CASE("Mesh components of disjoint boxes", "[mesh]") {
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+  addBox(vertices, triangles, {0, 0, 0}, {1, 1, 1});
+  addBox(vertices, triangles, {3, 0, 0}, {1, 1, 1});
+
+  SECTION("indexed mesh") {
+    auto components = splitMeshComponents(vertices, triangles);
+    REQUIRE(components.size() == 2);
+    REQUIRE(components[0].size() == 8);
+    REQUIRE(components[1].size() == 8);
+    for (auto v : components[0]) {
+      REQUIRE(vertices[v].x < 1.5f);
+    }
+    for (auto v : components[1]) {
+      REQUIRE(vertices[v].x > 1.5f);
+    }
+  }
+
+  SECTION("triangle soup") {
+    toSoup(vertices, triangles);
+    REQUIRE(vertices.size() == 72);
+    auto components = splitMeshComponents(vertices, triangles);
+    // welded to one vertex per distinct position
+    REQUIRE(components.size() == 2);
+    REQUIRE(components[0].size() == 8);
+    REQUIRE(components[1].size() == 8);
+  }
+
+  SECTION("touching boxes are welded") {
+    std::vector<PxVec3> touching;
+    std::vector<uint32_t> touchingTriangles;
+    addBox(touching, touchingTriangles, {0, 0, 0}, {1, 1, 1});
+    addBox(touching, touchingTriangles, {2, 0, 0}, {1, 1, 1});
+    auto components = splitMeshComponents(touching, touchingTriangles);
+    REQUIRE(components.size() == 1);
+    REQUIRE(components[0].size() == 12);
+  }
+
+  SECTION("unreferenced vertices are components of their own") {
+    vertices.push_back({10, 10, 10});
+    auto components = splitMeshComponents(vertices, triangles);
+    REQUIRE(components.size() == 3);
+    REQUIRE(components[2] == std::vector<uint32_t>{16});
+  }
+}
+
+TEST_CASE("Mesh components of an empty mesh", "[mesh]") {
+  REQUIRE(splitMeshComponents({}, {}).empty());
+}
+
+static PxBounds3 getBounds(std::vector<PxVec3> const &points) {
+  PxBounds3 bounds = PxBounds3::empty();
+  for (auto &p : points) {
+    bounds.include(p);
+  }
+  return bounds;
+}
+
+static void requireBounds(PxBounds3 const &bounds, PxVec3 const &lower, PxVec3 const &upper,
+                          PxReal tolerance) {
+  for (int a = 0; a < 3; ++a) {
+    REQUIRE(bounds.minimum[a] == Approx(lower[a]).margin(tolerance));
+    REQUIRE(bounds.maximum[a] == Approx(upper[a]).margin(tolerance));
+  }
+}
+
+TEST_CASE("Convex decomposition of boxes", "[mesh]") {
+  ConvexDecompositionParams params;
+  std::vector<PxVec3> vertices;
+  std::vector<uint32_t> triangles;
+
+  SECTION("a box is a single hull") {
+    addBox(vertices, triangles, {0, 0, 0}, {1, 0.5f, 0.25f});
+    auto hulls = decomposeConvex(vertices, triangles, params);
+    REQUIRE(hulls.size() == 1);
+    requireBounds(getBounds(hulls[0]), {-1, -0.5f, -0.25f}, {1, 0.5f, 0.25f}, 1e-3f);
+  }
+
+  SECTION("disjoint boxes are separate hulls") {
+    addBox(vertices, triangles, {0, 0, 0}, {1, 1, 1});
+    addBox(vertices, triangles, {3, 0, 0}, {1, 1, 1});
+    auto hulls = decomposeConvex(vertices, triangles, params);
+    REQUIRE(hulls.size() == 2);
+    requireBounds(getBounds(hulls[0]), {-1, -1, -1}, {1, 1, 1}, 1e-3f);
+    requireBounds(getBounds(hulls[1]), {2, -1, -1}, {4, 1, 1}, 1e-3f);
+
+    // never merged, even over the hull limit
+    params.maxHulls = 1;
+    REQUIRE(decomposeConvex(vertices, triangles, params).size() == 2);
+  }
+
+  SECTION("an L shape is split") {
+    addBox(vertices, triangles, {0, 0, 0}, {2, 0.5f, 0.5f});
+    addBox(vertices, triangles, {-1.5f, 2, 0}, {0.5f, 1.5f, 0.5f});
+    auto hulls = decomposeConvex(vertices, triangles, params);
+    REQUIRE(hulls.size() == 2);
+    PxBounds3 all = PxBounds3::empty();
+    for (auto &hull : hulls) {
+      all.include(getBounds(hull));
+    }
+    requireBounds(all, {-2, -0.5f, -0.5f}, {2, 3.5f, 0.5f}, 1e-3f);
+
+    params.maxHulls = 1;
+    REQUIRE(decomposeConvex(vertices, triangles, params).size() == 1);
+  }
+
+  SECTION("the same hulls on a thread pool") {
+    addBox(vertices, triangles, {0, 0, 0}, {2, 0.5f, 0.5f});
+    addBox(vertices, triangles, {-1.5f, 2, 0}, {0.5f, 1.5f, 0.5f});
+    addBox(vertices, triangles, {5, 0, 0}, {1, 1, 1});
+    utils::ThreadPool pool(4);
+    auto serial = decomposeConvex(vertices, triangles, params);
+    auto parallel = decomposeConvex(vertices, triangles, params, &pool);
+    REQUIRE(serial.size() == 3);
+    REQUIRE(parallel == serial);
+  }
+
+  SECTION("an empty mesh has no hulls") {
+    REQUIRE(decomposeConvex(vertices, triangles, params).empty());
+  }
+}
+
+/* points of a capsule along z, a sphere if halfLength is 0 */
+static std::vector<PxVec3> capsulePoints(PxVec3 const &center, PxReal radius, PxReal halfLength,
+                                         int rings, int segments) {
+  std::vector<PxVec3> points;
+  for (PxReal side : {-1.f, 1.f}) {
+    for (int r = 0; r <= rings; ++r) {
+      PxReal theta = PxPi / 2 * r / rings;
+      for (int s = 0; s < segments; ++s) {
+        PxReal phi = 2 * PxPi * s / segments;
+        points.push_back(center + PxVec3(radius * std::sin(theta) * std::cos(phi),
+                                         radius * std::sin(theta) * std::sin(phi),
+                                         side * (halfLength + radius * std::cos(theta))));
+      }
+    }
+  }
+  return points;
+}
+
+static PxConvexMesh *cookConvex(Simulation &sim, std::vector<PxVec3> const &points) {
+  PxConvexMeshDesc convexDesc;
+  convexDesc.points.count = points.size();
+  convexDesc.points.stride = sizeof(PxVec3);
+  convexDesc.points.data = points.data();
+  convexDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+
+  PxDefaultMemoryOutputStream buf;
+  if (!sim.mCooking->cookConvexMesh(convexDesc, buf)) {
+    return nullptr;
+  }
+  PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
+  return sim.mPhysicsSDK->createConvexMesh(input);
+}
+
+static void requireVecClose(PxVec3 const &a, PxVec3 const &b, PxReal tolerance) {
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(a[i] == Approx(b[i]).margin(tolerance));
+  }
+}
+
+static PxVec3 absolute(PxVec3 const &v) { return {std::abs(v.x), std::abs(v.y), std::abs(v.z)}; }
+
+TEST_CASE("Primitive fits of known shapes", "[mesh]") {
+  Simulation sim;
+
+  SECTION("box") {
+    std::vector<PxVec3> points;
+    std::vector<uint32_t> triangles;
+    addBox(points, triangles, {1, 2, 3}, {0.05f, 0.03f, 0.02f});
+    auto mesh = cookConvex(sim, points);
+    REQUIRE(mesh);
+
+    auto fit = fitPrimitive(*mesh);
+    REQUIRE(fit.type == PrimitiveFit::Box);
+    REQUIRE(fit.error == Approx(0).margin(1e-3));
+    requireVecClose(fit.pose.p, {1, 2, 3}, 1e-4f);
+    requireVecClose(absolute(fit.pose.q.rotate(fit.halfExtents)), {0.05f, 0.03f, 0.02f}, 1e-4f);
+
+    fit = fitPrimitive(*mesh, {1, 1, 3});
+    REQUIRE(fit.type == PrimitiveFit::Box);
+    REQUIRE(fit.error == Approx(0).margin(1e-3));
+    requireVecClose(fit.pose.p, {1, 2, 9}, 1e-4f);
+    requireVecClose(absolute(fit.pose.q.rotate(fit.halfExtents)), {0.05f, 0.03f, 0.06f}, 1e-4f);
+    mesh->release();
+  }
+
+  SECTION("sphere") {
+    auto mesh = cookConvex(sim, capsulePoints({0.5f, 0, 0}, 0.04f, 0, 4, 16));
+    REQUIRE(mesh);
+    auto fit = fitPrimitive(*mesh);
+    REQUIRE(fit.type == PrimitiveFit::Sphere);
+    REQUIRE(fit.radius == Approx(0.04f).margin(1e-4));
+    requireVecClose(fit.pose.p, {0.5f, 0, 0}, 1e-4f);
+    // the tessellation is inside the sphere
+    REQUIRE(fit.error > 0);
+    REQUIRE(fit.error < 0.1f);
+    mesh->release();
+  }
+
+  SECTION("capsule") {
+    auto mesh = cookConvex(sim, capsulePoints({0, 0.5f, 0}, 0.02f, 0.04f, 4, 16));
+    REQUIRE(mesh);
+    auto fit = fitPrimitive(*mesh);
+    REQUIRE(fit.type == PrimitiveFit::Capsule);
+    REQUIRE(fit.radius == Approx(0.02f).margin(1e-4));
+    REQUIRE(fit.halfLength == Approx(0.04f).margin(1e-4));
+    requireVecClose(fit.pose.p, {0, 0.5f, 0}, 1e-4f);
+    requireVecClose(absolute(fit.pose.q.rotate({1, 0, 0})), {0, 0, 1}, 1e-3f);
+    REQUIRE(fit.error > 0);
+    REQUIRE(fit.error < 0.1f);
+    mesh->release();
+  }
+}